@@ -14,6 +14,13 @@ import sys                  # system
 import pyfits               # FITS file access
 import numpy                # Numerical arrays
 import commands             # command execution
+import subprocess           # job processes
+import time                 # job polling
+try:
+	import _srcid           # in-process association engine
+	have_srcid_module = True
+except ImportError:
+	have_srcid_module = False
 
 
 #=============#
@@ -58,6 +65,150 @@ def run_command(cmd):
 	return error, result
 
 
+#=========================================#
+# Estimate memory needed by a gtsrcid job #
+#=========================================#
+def estimate_memory(hdu_lat, hdu_cpt):
+	"""
+	Estimate the memory (in MB) needed by a gtsrcid job from the catalogue
+	sizes. The catalogue tables are held in memory by the catalogue access
+	layer (about three times their FITS size) together with the object
+	information (about 64 bytes per object).
+	
+	Arguments:
+	 hdu_lat  HDU of LAT catalogue
+	 hdu_cpt  HDU of counterpart catalogue
+	Returns:
+	 Estimated memory in MB
+	"""
+	# Sum up table sizes
+	size = 0.0
+	for hdu in [hdu_lat, hdu_cpt]:
+		try:
+			rows  = float(hdu.header['NAXIS2'])
+			width = float(hdu.header['NAXIS1'])
+		except KeyError:
+			continue
+		size += rows * (3.0 * width + 64.0)
+	
+	# Return estimate, including a base size for the executable
+	return 50.0 + size / (1024.0 * 1024.0)
+
+
+#=============================#
+# Get local machine resources #
+#=============================#
+def get_resources():
+	"""
+	Returns the number of processors and 80% of the physical memory (in MB)
+	of the local machine.
+	"""
+	# Get number of processors
+	try:
+		cpus = int(os.sysconf('SC_NPROCESSORS_ONLN'))
+	except (ValueError, OSError, AttributeError):
+		cpus = 1
+	
+	# Get physical memory
+	try:
+		memory = 0.8 * float(os.sysconf('SC_PAGE_SIZE')) * \
+		               float(os.sysconf('SC_PHYS_PAGES')) / (1024.0 * 1024.0)
+	except (ValueError, OSError, AttributeError):
+		memory = 0.0
+	
+	# Return resources
+	return max(cpus, 1), memory
+
+
+#=====================#
+# Start a gtsrcid job #
+#=====================#
+def start_job(job):
+	"""
+	Start a gtsrcid job in a child process. The job gets its own log file
+	(through GTSRCID_LOGFILE) and its own parameter file directory, which
+	precedes the system parameter files in PFILES.
+	
+	Arguments:
+	 job  Job dictionary (see run_jobs)
+	"""
+	# Create job directory for parameter files and job output
+	pfiles = os.path.abspath(os.path.join(job['dir'], 'pfiles'))
+	if not os.path.isdir(pfiles):
+		os.makedirs(pfiles)
+	
+	# Set job environment
+	env = os.environ.copy()
+	env['GTSRCID_LOGFILE'] = job['log']
+	syspfiles = env.get('PFILES', '')
+	if ';' in syspfiles:
+		syspfiles = syspfiles.split(';', 1)[1]
+	env['PFILES'] = pfiles + ';' + syspfiles
+	
+	# Start job
+	job['out']  = os.path.join(job['dir'], 'gtsrcid.out')
+	output      = open(job['out'], 'w')
+	job['proc'] = subprocess.Popen(job['cmd'], shell=True, env=env, \
+	                               stdout=output, stderr=subprocess.STDOUT)
+	output.close()
+
+
+#==========================#
+# Run pool of gtsrcid jobs #
+#==========================#
+def run_jobs(jobs, max_jobs=1, max_memory=0.0):
+	"""
+	Run gtsrcid jobs on a pool of local worker processes. A job is started
+	if less than max_jobs jobs run and if the memory estimates of all running
+	jobs stay within max_memory (in MB; 0 means no limit). A job is always
+	started if no other job runs.
+	
+	This is a generator that yields the jobs in their original order as soon
+	as the job and all jobs before it have finished, so that results can be
+	collected while later jobs are still running. For each job, 'error' and
+	'result' are set like for run_command.
+	
+	Arguments:
+	 jobs        List of job dictionaries with keys 'cmd' (command), 'dir'
+	             (job directory), 'log' (log file) and 'memory' (MB)
+	 max_jobs=   Maximum number of concurrent jobs
+	 max_memory= Memory budget in MB
+	"""
+	# Initialise scheduler
+	pending = list(jobs)
+	running = []
+	next    = 0
+	
+	# Loop until all jobs have been yielded
+	while next < len(jobs):
+		
+		# Start jobs while resources are available
+		while len(pending) > 0 and len(running) < max(max_jobs, 1):
+			used = sum([job['memory'] for job in running])
+			if len(running) > 0 and max_memory > 0.0 and \
+			   used + pending[0]['memory'] > max_memory:
+				break
+			job = pending.pop(0)
+			start_job(job)
+			running.append(job)
+		
+		# Collect finished jobs
+		for job in list(running):
+			if job['proc'].poll() != None:
+				job['error']  = job['proc'].returncode
+				job['result'] = open(job['out']).read().rstrip('\n')
+				running.remove(job)
+		
+		# Yield finished jobs in original order
+		while next < len(jobs) and 'error' in jobs[next]:
+			yield jobs[next]
+			next = next + 1
+		
+		# Wait a little if jobs are still running
+		if len(running) > 0:
+			time.sleep(0.1)
+
+
 #=================================================#
 # Determine source class catalogue directory path #
 #=================================================#
@@ -337,9 +488,6 @@ def attach_counterparts(pars, hdu_lat):
 	# Get counterpart name key (None if name key was not found)
 	cpt_name_key = get_name_key(pars, hdu_cpt)
 	
-	# Extract table information
-	nrows_lat = hdu_lat.data.shape[0]
-	
 	# Determine maximum number of counterparts in catalogue. Stop if there are no
 	# counterparts
 	try:
@@ -349,6 +497,50 @@ def attach_counterparts(pars, hdu_lat):
 	if max_cpt < 1:
 		return hdu_lat
 	
+	# Collect counterpart rows
+	rows = []
+	for irow, row in enumerate(hdu_cpt.data):
+		# Get Array indices
+		lat_index = long(row.field('ID')[3:8])-1     # Array index starts with 0
+		cpt_index = long(row.field('ID')[9:14])-1    # index starts with 0
+		
+		# Get source name
+		if cpt_name_key != None:
+			name = row.field(cpt_name_key)
+			if name == '':
+				ref  = long(float(row.field('REF'))+1.5)
+				name = '<Row='+str(ref)+'>'
+		else:
+			name = 'NoNameColumnFound'
+		
+		# Append row
+		rows.append((lat_index, cpt_index, name, row.field('PROB'), \
+		             row.field('RAJ2000'), row.field('DEJ2000'), row.field('ANGSEP')))
+	
+	# Attach counterpart columns
+	return add_counterpart_columns(pars, hdu_lat, max_cpt, rows)
+
+
+#======================================#
+# Add counterpart columns to LAT table #
+#======================================#
+def add_counterpart_columns(pars, hdu_lat, max_cpt, rows):
+	"""
+	Add counterpart columns to LAT catalogue.
+	
+	Arguments:
+	 pars     Parameter dictionnary
+	 hdu_lat  HDU of LAT catalogue
+	 max_cpt  Maximum number of counterparts per LAT source
+	 rows     List of (lat_index, cpt_index, name, prob, ra, dec, sep) tuples
+	          (indices start with 0)
+	Returns:
+	 HDU of LAT catalogue with counterparts attached
+	"""
+	
+	# Extract table information
+	nrows_lat = hdu_lat.data.shape[0]
+	
 	# Define empty columns list
 	columns = []
 	
@@ -369,34 +561,13 @@ def attach_counterparts(pars, hdu_lat):
 		array_sep  = [0.0 for i in range(nrows_lat)]
 		
 		# Fill arrays
-		for irow, row in enumerate(hdu_cpt.data):
-			# Get Array indices
-			lat_index = long(row.field('ID')[3:8])-1     # Array index starts with 0
-			cpt_index = long(row.field('ID')[9:14])-1    # index starts with 0
-			
-			# Use counterpart only if indices correspond
-			if cpt_index == index:
-				# Get source name
-				if cpt_name_key != None:
-					name = row.field(cpt_name_key)
-					if name == '':
-						ref  = long(float(row.field('REF'))+1.5)
-						name = '<Row='+str(ref)+'>'
-				else:
-					name = 'NoNameColumnFound'
-				
-				# Get probability
-				prob = row.field('PROB')
-				ra   = row.field('RAJ2000')
-				dec  = row.field('DEJ2000')
-				sep  = row.field('ANGSEP')
-				
-				# Set array entries
-				array_name[lat_index] = name
-				array_prob[lat_index] = prob
-				array_ra[lat_index]   = ra
-				array_dec[lat_index]  = dec
-				array_sep[lat_index]  = sep
+		for row in rows:
+			if row[1] == index:
+				array_name[row[0]] = row[2]
+				array_prob[row[0]] = row[3]
+				array_ra[row[0]]   = row[4]
+				array_dec[row[0]]  = row[5]
+				array_sep[row[0]]  = row[6]
 		
 		# Define columns
 		column_name = pyfits.Column(name=key_name, format='A25', array=array_name)
@@ -433,6 +604,204 @@ def attach_counterparts(pars, hdu_lat):
 	return hdu_new
 
 
+#===============================#
+# Find catalogue column by name #
+#===============================#
+def find_column(names, key):
+	"""
+	Find catalogue column like gtsrcid does.
+	
+	Arguments:
+	 names  Column names
+	 key    Column name to search
+	Returns:
+	 Shortest column name that starts with key (case insensitive) or 'None'
+	 if no column was found.
+	"""
+	# Collect matching columns
+	match = [name for name in names if name.upper().startswith(key.upper())]
+	if len(match) < 1:
+		return None
+	
+	# Return shortest matching column (first one if there are several)
+	result = match[0]
+	for name in match:
+		if len(name) < len(result):
+			result = name
+	return result
+
+
+#==========================================#
+# Get catalogue arrays for in-process mode #
+#==========================================#
+def get_arrays(hdu):
+	"""
+	Extract catalogue arrays from a FITS table HDU for the in-process
+	association engine.
+	
+	Arguments:
+	 hdu  Catalogue HDU
+	Returns:
+	 Dictionary of arrays ('ra', 'dec', 'err_maj', 'err_min', 'err_ang',
+	 'name' and all numerical columns) or 'None' if the catalogue needs to be
+	 processed by gtsrcid.
+	
+	Positions are searched with the column names 'RAdeg', '_RAJ2000',
+	'RAJ2000' and 'RA'. Position errors are searched like in gtsrcid
+	('Conf_95_*', 'Conf_68_*', 'POS_ERR_*', 'theta95', 'PosErr68', 'PosErr90',
+	'PosErr95', 'PosErr99', 'PosErr') and scaled to 95% confidence. 'None' is
+	returned for catalogues without position, for catalogues with 'e_RA*' and
+	'e_DE*' errors and for catalogues with undefined errors, so that they are
+	processed by gtsrcid.
+	"""
+	# Get column names (upper case to column name)
+	data  = hdu.data
+	names = dict([(s.upper(), s) for s in hdu.columns.names])
+	cat   = {}
+	
+	# Get positions
+	for ra, dec in [('RADEG','DEDEG'), ('_RAJ2000','_DEJ2000'), \
+	                ('RAJ2000','DEJ2000'), ('RA','DEC')]:
+		if ra in names and dec in names:
+			cat['ra']  = numpy.asarray(data.field(names[ra]),  dtype=numpy.float64)
+			cat['dec'] = numpy.asarray(data.field(names[dec]), dtype=numpy.float64)
+			break
+	if not cat.has_key('ra'):
+		return None
+	
+	# Get error ellipse. The error columns are searched in the same order and
+	# with the same column name matching as in gtsrcid, and the errors are
+	# converted into 95% confidence errors. Catalogues with e_RA/e_DE errors
+	# (which need unit conversion) or with undefined errors are left to
+	# gtsrcid.
+	q95 = 2.9957230
+	for kind, keys, q in [('ellipse', ('Conf_95_SemiMajor', 'Conf_95_SemiMinor', \
+	                                   'Conf_95_PosAng'), q95), \
+	                     ('ellipse', ('Conf_68_SemiMajor', 'Conf_68_SemiMinor', \
+	                                   'Conf_68_PosAng'), 1.1394375), \
+	                     ('ellipse', ('POS_ERR_MAJ', 'POS_ERR_MIN', \
+	                                   'POS_ERR_ANG'), q95), \
+	                     ('radec',   ('e_RAdeg', 'e_DEdeg'), None), \
+	                     ('radec',   ('e_RAJ2000', 'e_DEJ2000'), None), \
+	                     ('radius',  ('theta95',), q95), \
+	                     ('radius',  ('PosErr68',), 1.1394375), \
+	                     ('radius',  ('PosErr90',), 2.2926342), \
+	                     ('radius',  ('PosErr95',), q95), \
+	                     ('radius',  ('PosErr99',), 4.6051713), \
+	                     ('radius',  ('PosErr',), 1.1478742)]:
+		cols = [find_column(hdu.columns.names, key) for key in keys]
+		if None in cols:
+			continue
+		if kind == 'radec':
+			return None
+		scale          = numpy.sqrt(q95/q)
+		cat['err_maj'] = numpy.asarray(data.field(cols[0]), dtype=numpy.float64) * scale
+		if kind == 'ellipse':
+			cat['err_min'] = numpy.asarray(data.field(cols[1]), dtype=numpy.float64) * scale
+			cat['err_ang'] = numpy.asarray(data.field(cols[2]), dtype=numpy.float64)
+		break
+	for key in ['err_maj', 'err_min', 'err_ang']:
+		if cat.has_key(key) and not numpy.all(numpy.isfinite(cat[key])):
+			return None
+	
+	# Get names
+	for key in ['SOURCE_NAME', 'NAME', 'HESS', 'NICKNAME', 'ID']:
+		if key in names:
+			cat['name'] = data.field(names[key])
+			break
+	
+	# Get all numerical columns
+	for name in hdu.columns.names:
+		if name in ['ra', 'dec', 'err_maj', 'err_min', 'err_ang', 'name']:
+			continue
+		array = data.field(name)
+		if array.ndim == 1 and array.dtype.kind in 'iuf':
+			cat[name] = array
+	
+	# Return catalogue arrays
+	return cat
+
+
+#=================================#
+# Associate catalogues in-process #
+#=================================#
+def associate_arrays(pars, src, cpt):
+	"""
+	Associate catalogue arrays using the in-process engine.
+	
+	Arguments:
+	 pars  Parameter dictionnary
+	 src   Source catalogue arrays (see get_arrays)
+	 cpt   Counterpart catalogue arrays (see get_arrays)
+	Returns:
+	 Structured array of associations
+	"""
+	# Set options from parameters
+	options = {'srcCatPrefix': pars['srcCatPrefix'], \
+	           'cptCatPrefix': pars['cptCatPrefix'], \
+	           'srcPosError':  float(pars['srcPosError']), \
+	           'cptPosError':  float(pars['cptPosError']), \
+	           'probMethod':   str(pars['probMethod']), \
+	           'probPrior':    str(pars['probPrior']), \
+	           'probThres':    float(pars['probThres']), \
+	           'maxNumCpt':    int(pars['maxNumCpt']), \
+	           'fom':          str(pars['fom']), \
+	           'outCatQty':    [pars['outCatQty0'+str(i)] for i in range(1,10)], \
+	           'select':       [pars['select0'+str(i)] for i in range(1,10)], \
+	           'chatter':      0}
+	
+	# Associate catalogues
+	return _srcid.associate(src, cpt, **options)
+
+
+#===============================================#
+# Attach in-process results to source catalogue #
+#===============================================#
+def attach_results(pars, hdu_lat, res, cpt):
+	"""
+	Attach counterparts found by the in-process engine to LAT catalogue.
+	
+	Arguments:
+	 pars     Parameter dictionnary
+	 hdu_lat  HDU of LAT catalogue
+	 res      Structured array of associations
+	 cpt      Counterpart catalogue arrays
+	Returns:
+	 HDU of LAT catalogue with counterparts attached
+	"""
+	
+	# Stop if LAT catalogue is an ASCII table
+	if ('BINTABLE' in hdu_lat.header['XTENSION']):
+		pass
+	else:
+		return hdu_lat
+	
+	# Collect counterpart rows. Counterparts are ranked in the order in which
+	# they are returned for each source.
+	rows  = []
+	ranks = {}
+	for row in res:
+		lat_index = int(row['src'])
+		cpt_index = ranks.get(lat_index, 0)
+		ranks[lat_index] = cpt_index + 1
+		ref = int(row['cpt'])
+		if cpt.has_key('name'):
+			name = str(cpt['name'][ref]).strip()
+			if name == '':
+				name = '<Row='+str(ref+1)+'>'
+		else:
+			name = 'NoNameColumnFound'
+		rows.append((lat_index, cpt_index, name, row['prob'], \
+		             cpt['ra'][ref], cpt['dec'][ref], row['angsep']))
+	
+	# Stop if there are no counterparts
+	if len(ranks) < 1:
+		return hdu_lat
+	
+	# Attach counterpart columns
+	return add_counterpart_columns(pars, hdu_lat, max(ranks.values()), rows)
+
+
 #========================#
 # Expand names in string #
 #========================#
@@ -887,25 +1256,53 @@ if __name__ == '__main__':
 	Usage: srcid.py <LATCatalogue> [OPTIONS]
 	     -h              Display usage message
 	     -C classdir     Specify alternative classes directory
-	
-	The script runs gtsrid for all source classes that are defined in the
-	specified 'classdir'. If no 'classdir' option is given the 'classes'
-	directory that is shipped with the distribution is used.
-	For each source class a FITS and a log file is created in the current 
-	directory, containing the results of the source identification for each
-	source class.
+	     -j jobs         Maximum number of concurrent gtsrcid jobs
+	     -m memory       Memory budget for concurrent gtsrcid jobs (MB)
+	
+	The script associates the LAT catalogue with all source classes that are
+	defined in the specified 'classdir'. If no 'classdir' option is given the
+	'classes' directory that is shipped with the distribution is used.
+	If the _srcid module is available, source classes whose catalogues have
+	position errors that the module reads like gtsrcid are associated
+	in-process. These source classes produce no FITS or log file. All other
+	source classes are associated by gtsrcid jobs.
+	The gtsrcid jobs are independent and run concurrently on a pool of local
+	worker processes. By default, the pool has one worker per processor and
+	the memory budget is 80% of the physical memory. Each job runs in its own
+	directory 'srcid_jobs/<class>' that holds its parameter files.
+	For each source class associated by gtsrcid a FITS and a log file is
+	created in the current directory, containing the results of the source
+	identification for that source class.
 	A copy of the LAT input catalogue names 'srcid.fits' is created which
 	has the names and counterpart probabilities for all identified sources 
 	attached.
 	"""
 	
+	# Get local machine resources
+	max_jobs, max_memory = get_resources()
+	
 	# Verify argument list. We need at least a LAT catalogue name and we allow only
-	# for options '-h' and '-C'
-	if len(sys.argv) < 2 or sys.argv[1] == '-h' or \
-	  (len(sys.argv) > 2 and (len(sys.argv) != 4 or sys.argv[2] != '-C')):
+	# for options '-h', '-C', '-j' and '-m'
+	options = {}
+	valid   = len(sys.argv) >= 2 and sys.argv[1] != '-h' and \
+	          len(sys.argv) % 2 == 0
+	for i in range(2, len(sys.argv)-1, 2):
+		if sys.argv[i] not in ['-C', '-j', '-m']:
+			valid = False
+		options[sys.argv[i]] = sys.argv[i+1]
+	try:
+		if '-j' in options:
+			max_jobs = int(options['-j'])
+		if '-m' in options:
+			max_memory = float(options['-m'])
+	except ValueError:
+		valid = False
+	if not valid:
 		print 'Usage: srcid.py <LATCatalogue> [OPTIONS]'
 		print '     -h              Display this usage message'
 		print '     -C classdir     Specify alternative classes directory'
+		print '     -j jobs         Maximum number of concurrent gtsrcid jobs'
+		print '     -m memory       Memory budget for concurrent gtsrcid jobs (MB)'
 		sys.exit()
 
 	# Keep extension cases
@@ -917,8 +1314,8 @@ if __name__ == '__main__':
 	
 	# If -C option is specified then extract class directory. Otherwise use classes that
 	# ship with this script
-	if len(sys.argv) == 4:
-		path_classes = sys.argv[3]
+	if '-C' in options:
+		path_classes = options['-C']
 		dir_classes  = os.path.basename(path_classes)
 		sys.path.insert(0, os.path.dirname(os.path.abspath(path_classes)))  # import classes from here
 	else:
@@ -958,10 +1355,20 @@ if __name__ == '__main__':
 		print 'ERROR: Catalogue ' + lat_filename + ' not found.'
 		sys.exit(0)
 	
+	# Get LAT source catalogue arrays for the in-process engine (loaded only
+	# once for all source classes)
+	lat_arrays = None
+	if have_srcid_module:
+		lat_arrays = get_arrays(hdu_lat)
+	
 	# Initialise counterpart catalogue dictionary list
 	cpt_cats  = []
 	cpt_index = 1
 	
+	# Initialise gtsrcid job list and list of results in source class order
+	jobs    = []
+	results = []
+	
 	# Loop over all source classes
 	for class_one in class_list:
 		
@@ -1027,30 +1434,71 @@ if __name__ == '__main__':
 		# Dump processing information to screen
 		print 'Process ' + info['name'] + ' (' + info['url'] + ')'
 		
-		# Set gtsrcid command
-		cmd = set_command("gtsrcid", pars)
+		# Get counterpart catalogue arrays for the in-process engine
+		cpt_arrays = None
+		if lat_arrays != None:
+			cpt_arrays = get_arrays(hdu_cpt)
 		
-		# Run gtsrcid
-		error, result = run_command(cmd)
-		if error != 0:
-			print 'WARNING: gtsrcid error while processing catalogue ' + cpt_url
-			lines = result.splitlines(False)
+		# Associate in-process if possible
+		if cpt_arrays != None:
+			try:
+				res = associate_arrays(pars, lat_arrays, cpt_arrays)
+			except Exception, e:
+				print 'WARNING: association error while processing catalogue ' + cpt_url
+				print '         ' + str(e)
+				continue
+			
+			# Keep results for attachment in source class order
+			results.append({'pars': pars, 'url': cpt_url, 'res': res, \
+			                'arrays': cpt_arrays})
+		
+		# ... otherwise queue gtsrcid job
+		else:
+			prefix = pars['cptCatPrefix'].lower()
+			job    = {'pars':   pars, \
+			          'url':    cpt_url, \
+			          'cmd':    set_command("gtsrcid", pars), \
+			          'dir':    os.path.join('srcid_jobs', prefix), \
+			          'log':    prefix + '.log', \
+			          'memory': estimate_memory(hdu_lat, hdu_cpt)}
+			jobs.append(job)
+			results.append(job)
+		
+		# Increment index
+		cpt_index = cpt_index + 1
+	
+	# Run gtsrcid jobs and attach the results of all source classes in class
+	# order. The gtsrcid jobs are yielded in their original order as they
+	# finish, hence results are attached while later jobs are still running.
+	finished = run_jobs(jobs, max_jobs=max_jobs, max_memory=max_memory)
+	for result in results:
+		
+		# Attach in-process counterparts to LAT catalogue
+		if result.has_key('res'):
+			try:
+				hdu_lat = attach_results(result['pars'], hdu_lat, \
+				                         result['res'], result['arrays'])
+			except:
+				print "Unable to attach counterparts for catalogue "+result['url']
+			continue
+		
+		# Wait for gtsrcid job
+		job = finished.next()
+		
+		# Check for job error
+		if job['error'] != 0:
+			print 'WARNING: gtsrcid error while processing catalogue ' + job['url']
+			lines = job['result'].splitlines(False)
 			for line in lines:
 				print '         '+line
 			continue
 		
-		# Rename result file
-		os.rename('gtsrcid.log', pars['cptCatPrefix'].lower() + '.log')
-		
 		# Attach counterparts to LAT catalogue
 		try:
-			hdu_lat = attach_counterparts(pars, hdu_lat)
+			hdu_lat = attach_counterparts(job['pars'], hdu_lat)
 		except:
-			print "Unable to attach counterparts for catalogue "+cpt_url
-		
-		# Increment index
-		cpt_index = cpt_index + 1
-		
+			print "Unable to attach counterparts for catalogue "+job['url']
+	
 	# Save LAT catalogue with attached columns
 	hdu_lat.writeto('srcid.fits', clobber=True)
 
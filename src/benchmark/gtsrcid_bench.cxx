@@ -0,0 +1,644 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file gtsrcid_bench.cxx
+ * @brief Synthetic catalogue generator and gtsrcid benchmark driver.
+ * @author J. Knodlseder
+ *
+ * Generates a synthetic LAT-like source catalogue (error ellipses, Galactic
+ * plane clustering) and counterpart catalogues of configurable size, writes
+ * them as FITS files, runs gtsrcid on each counterpart catalogue with
+ * pipeline profiling enabled and reports the throughput of the filter,
+ * selection, refine, post_cat, catch22 and output stages.
+ *
+ * Usage:
+ *   gtsrcid_bench [-nsrc N] [-ncpt N1,N2,...] [-seed S] [-plane F]
+ *                 [-match F] [-dir DIR] [-exe GTSRCID] [-generate]
+ *
+ * The PFILES environment variable needs to point to the gtsrcid parameter
+ * file directory.
+ */
+
+/* Includes _________________________________________________________________ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/wait.h>
+#include <string>
+#include <vector>
+#include "fitsio.h"
+
+
+/* Definitions ______________________________________________________________ */
+#define BENCH_CHUNK      100000           // Rows written per FITS call
+#define BENCH_NAME_LEN   20               // Length of object names
+
+
+/* Constants ________________________________________________________________ */
+const double pi      = 3.1415926535897931159979635;
+const double deg2rad = 0.0174532925199432954743717;
+const double rad2deg = 57.295779513082322864647722;
+const double r95     = 2.4477468306808161;  //!< 95% radius / sigma (2 dof)
+
+// Benchmarked stages (keys of the gtsrcid profile JSON file)
+const char *c_stages[] = {"filter", "prune", "select", "refine", "reselect",
+                          "post_cat", "catch22", "compute_prob", "output",
+                          "cfits_eval", "stop"};
+
+
+/* Type defintions __________________________________________________________ */
+typedef struct {                // Benchmark options
+  long        nsrc;             //!< Number of sources
+  std::vector<double> ncpt;     //!< Numbers of counterparts
+  unsigned long seed;           //!< Random number seed
+  double      plane;            //!< Fraction of objects in Galactic plane
+  double      match;            //!< Fraction of sources with true counterpart
+  std::string dir;              //!< Working directory
+  std::string exe;              //!< gtsrcid executable
+  int         generate;         //!< Generate catalogues only
+} BenchOptions;
+
+typedef struct {                // Synthetic source
+  double ra;                    //!< Right Ascension (deg)
+  double dec;                   //!< Declination (deg)
+  double maj;                   //!< 95% semi-major axis (deg)
+  double min;                   //!< 95% semi-minor axis (deg)
+  double pa;                    //!< Position angle (deg)
+} BenchSource;
+
+
+/* Private globals __________________________________________________________ */
+static unsigned long long g_rng_state = 88172645463325252ULL;
+
+
+/* Prototypes _______________________________________________________________ */
+double rng_uniform(void);
+double rng_gauss(void);
+void   gal2equ(double l, double b, double *ra, double *dec);
+void   random_direction(double plane, double *ra, double *dec);
+void   offset_direction(double ra, double dec, double dx, double dy,
+                        double *ra_out, double *dec_out);
+int    write_src_catalogue(std::string filename, std::vector<BenchSource> &src);
+int    write_cpt_catalogue(std::string filename, long num, double plane,
+                           double match, std::vector<BenchSource> &src);
+int    run_benchmark(BenchOptions &opt, std::string srcfile,
+                     std::vector<BenchSource> &src, long ncpt);
+int    parse_options(int argc, char *argv[], BenchOptions &opt);
+
+
+/*============================================================================*/
+/*                            Synthetic catalogues                            */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Return uniform random number in [0,1[
+ *
+ * Uses a xorshift64* generator so that catalogues are reproducible across
+ * platforms for a given seed.
+ ******************************************************************************/
+double rng_uniform(void) {
+
+    // Advance state
+    g_rng_state ^= g_rng_state >> 12;
+    g_rng_state ^= g_rng_state << 25;
+    g_rng_state ^= g_rng_state >> 27;
+    unsigned long long r = g_rng_state * 2685821657736338717ULL;
+
+    // Return uniform deviate
+    return double(r >> 11) * (1.0 / 9007199254740992.0);
+
+}
+
+
+/**************************************************************************//**
+ * @brief Return Gaussian random number with zero mean and unit variance
+ ******************************************************************************/
+double rng_gauss(void) {
+
+    // Box-Muller transform
+    double u1 = rng_uniform();
+    double u2 = rng_uniform();
+    if (u1 < 1.0e-300) u1 = 1.0e-300;
+
+    // Return Gaussian deviate
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * pi * u2);
+
+}
+
+
+/**************************************************************************//**
+ * @brief Convert Galactic into equatorial (J2000) coordinates
+ *
+ * @param[in] l Galactic longitude (deg).
+ * @param[in] b Galactic latitude (deg).
+ * @param[out] ra Right Ascension (deg).
+ * @param[out] dec Declination (deg).
+ ******************************************************************************/
+void gal2equ(double l, double b, double *ra, double *dec) {
+
+    // Galactic to J2000 rotation matrix (transpose of J2000 to Galactic)
+    static const double m[3][3] = {{-0.0548755604, +0.4941094279, -0.8676661490},
+                                   {-0.8734370902, -0.4448296300, -0.1980763734},
+                                   {-0.4838350155, +0.7469822445, +0.4559837762}};
+
+    // Galactic unit vector
+    double cb = cos(b * deg2rad);
+    double x  = cb * cos(l * deg2rad);
+    double y  = cb * sin(l * deg2rad);
+    double z  = sin(b * deg2rad);
+
+    // Rotate
+    double xe = m[0][0]*x + m[0][1]*y + m[0][2]*z;
+    double ye = m[1][0]*x + m[1][1]*y + m[1][2]*z;
+    double ze = m[2][0]*x + m[2][1]*y + m[2][2]*z;
+
+    // Convert to angles
+    *ra  = atan2(ye, xe) * rad2deg;
+    if (*ra < 0.0) *ra += 360.0;
+    *dec = asin((ze > 1.0) ? 1.0 : ((ze < -1.0) ? -1.0 : ze)) * rad2deg;
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Draw random sky direction
+ *
+ * @param[in] plane Fraction of directions drawn from the Galactic plane.
+ * @param[out] ra Right Ascension (deg).
+ * @param[out] dec Declination (deg).
+ *
+ * Galactic plane directions are drawn with a Gaussian latitude distribution
+ * of 5 deg width; all other directions are isotropic.
+ ******************************************************************************/
+void random_direction(double plane, double *ra, double *dec) {
+
+    // Galactic plane direction ...
+    if (rng_uniform() < plane) {
+      double l = 360.0 * rng_uniform();
+      double b = 5.0 * rng_gauss();
+      if (b >  90.0) b =  90.0;
+      if (b < -90.0) b = -90.0;
+      gal2equ(l, b, ra, dec);
+    }
+
+    // ... or isotropic direction
+    else {
+      *ra  = 360.0 * rng_uniform();
+      *dec = asin(2.0 * rng_uniform() - 1.0) * rad2deg;
+    }
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Offset sky direction in the tangent plane
+ *
+ * @param[in] ra Right Ascension (deg).
+ * @param[in] dec Declination (deg).
+ * @param[in] dx Offset towards East (deg).
+ * @param[in] dy Offset towards North (deg).
+ * @param[out] ra_out Offset Right Ascension (deg).
+ * @param[out] dec_out Offset Declination (deg).
+ ******************************************************************************/
+void offset_direction(double ra, double dec, double dx, double dy,
+                      double *ra_out, double *dec_out) {
+
+    // Apply offset (small angle approximation)
+    double cd = cos(dec * deg2rad);
+    *dec_out  = dec + dy;
+    *ra_out   = ra + ((cd > 1.0e-6) ? dx / cd : 0.0);
+
+    // Keep position in range
+    if (*dec_out >  90.0) *dec_out =  180.0 - *dec_out;
+    if (*dec_out < -90.0) *dec_out = -180.0 - *dec_out;
+    *ra_out = fmod(*ra_out, 360.0);
+    if (*ra_out < 0.0) *ra_out += 360.0;
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Write synthetic source catalogue
+ *
+ * @param[in] filename FITS file name.
+ * @param[in] src Sources.
+ *
+ * The catalogue uses the 2FGL-like columns NAME, RAJ2000, DEJ2000,
+ * Conf_95_SemiMajor, Conf_95_SemiMinor and Conf_95_PosAng.
+ ******************************************************************************/
+int write_src_catalogue(std::string filename, std::vector<BenchSource> &src) {
+
+    // Declare local variables
+    fitsfile *fptr    = NULL;
+    int       fstatus = 0;
+    char     *ttype[] = {(char*)"NAME", (char*)"RAJ2000", (char*)"DEJ2000",
+                         (char*)"Conf_95_SemiMajor", (char*)"Conf_95_SemiMinor",
+                         (char*)"Conf_95_PosAng"};
+    char     *tform[] = {(char*)"20A", (char*)"1E", (char*)"1E",
+                         (char*)"1E", (char*)"1E", (char*)"1E"};
+    char     *tunit[] = {(char*)"", (char*)"deg", (char*)"deg",
+                         (char*)"deg", (char*)"deg", (char*)"deg"};
+
+    // Single loop for common exit point
+    do {
+
+      // Create catalogue
+      remove(filename.c_str());
+      fits_create_file(&fptr, filename.c_str(), &fstatus);
+      fits_create_tbl(fptr, BINARY_TBL, 0, 6, ttype, tform, tunit,
+                      (char*)"LAT_Point_Source_Catalog", &fstatus);
+      if (fstatus != 0)
+        continue;
+
+      // Write rows
+      long num = (long)src.size();
+      for (long i = 0; i < num; ++i) {
+        char  name[BENCH_NAME_LEN+1];
+        char *pname = name;
+        sprintf(name, "SYN_SRC_%8.8ld", i+1);
+        fits_write_col(fptr, TSTRING, 1, i+1, 1, 1, &pname,        &fstatus);
+        fits_write_col(fptr, TDOUBLE, 2, i+1, 1, 1, &src[i].ra,  &fstatus);
+        fits_write_col(fptr, TDOUBLE, 3, i+1, 1, 1, &src[i].dec, &fstatus);
+        fits_write_col(fptr, TDOUBLE, 4, i+1, 1, 1, &src[i].maj, &fstatus);
+        fits_write_col(fptr, TDOUBLE, 5, i+1, 1, 1, &src[i].min, &fstatus);
+        fits_write_col(fptr, TDOUBLE, 6, i+1, 1, 1, &src[i].pa,  &fstatus);
+      }
+
+    } while (0); // End of main do-loop
+
+    // Close catalogue
+    if (fptr != NULL)
+      fits_close_file(fptr, &fstatus);
+
+    // Return FITSIO status
+    return fstatus;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Write synthetic counterpart catalogue
+ *
+ * @param[in] filename FITS file name.
+ * @param[in] num Number of counterparts.
+ * @param[in] plane Fraction of counterparts in the Galactic plane.
+ * @param[in] match Fraction of sources that have a true counterpart.
+ * @param[in] src Sources.
+ *
+ * The first counterparts are the true counterparts of a fraction of the
+ * sources, drawn from the source error ellipses. The remaining counterparts
+ * are background objects. Rows are generated and written in chunks so that
+ * catalogues of 10^8 objects can be produced with constant memory.
+ ******************************************************************************/
+int write_cpt_catalogue(std::string filename, long num, double plane,
+                        double match, std::vector<BenchSource> &src) {
+
+    // Declare local variables
+    fitsfile *fptr    = NULL;
+    int       fstatus = 0;
+    char     *ttype[] = {(char*)"NAME", (char*)"RAJ2000", (char*)"DEJ2000",
+                         (char*)"PosErr95", (char*)"Flux"};
+    char     *tform[] = {(char*)"20A", (char*)"1D", (char*)"1D",
+                         (char*)"1E", (char*)"1E"};
+    char     *tunit[] = {(char*)"", (char*)"deg", (char*)"deg",
+                         (char*)"deg", (char*)"mJy"};
+
+    // Allocate chunk buffers
+    std::vector<std::string> names(BENCH_CHUNK);
+    std::vector<char*>       pnames(BENCH_CHUNK);
+    std::vector<double>      ra(BENCH_CHUNK);
+    std::vector<double>      dec(BENCH_CHUNK);
+    std::vector<double>      err(BENCH_CHUNK);
+    std::vector<double>      flux(BENCH_CHUNK);
+
+    // Single loop for common exit point
+    do {
+
+      // Create catalogue
+      remove(filename.c_str());
+      fits_create_file(&fptr, filename.c_str(), &fstatus);
+      fits_create_tbl(fptr, BINARY_TBL, 0, 5, ttype, tform, tunit,
+                      (char*)"CPT_CATALOGUE", &fstatus);
+      if (fstatus != 0)
+        continue;
+
+      // Generate and write counterparts in chunks
+      long numSrc = (long)src.size();
+      long iSrc   = 0;
+      for (long row = 0; row < num && fstatus == 0; row += BENCH_CHUNK) {
+        long n = (num - row < BENCH_CHUNK) ? num - row : BENCH_CHUNK;
+        for (long i = 0; i < n; ++i) {
+
+          // Draw true counterpart for next matched source ...
+          while (iSrc < numSrc && rng_uniform() >= match)
+            iSrc++;
+          if (iSrc < numSrc) {
+            double sigma = src[iSrc].maj / r95;
+            offset_direction(src[iSrc].ra, src[iSrc].dec,
+                             sigma * rng_gauss(), sigma * rng_gauss(),
+                             &ra[i], &dec[i]);
+            flux[i] = 100.0 * exp(rng_gauss());
+            iSrc++;
+          }
+
+          // ... or background object
+          else {
+            random_direction(plane, &ra[i], &dec[i]);
+            flux[i] = 10.0 * exp(rng_gauss());
+          }
+
+          // Set name and position error (1 - 10 arcsec)
+          char name[BENCH_NAME_LEN+1];
+          sprintf(name, "SYN_CPT_%9.9ld", row+i+1);
+          names[i]  = name;
+          pnames[i] = (char*)names[i].c_str();
+          err[i]    = (1.0 + 9.0 * rng_uniform()) / 3600.0;
+
+        } // endfor: looped over chunk
+
+        // Write chunk
+        fits_write_col(fptr, TSTRING, 1, row+1, 1, n, &pnames[0], &fstatus);
+        fits_write_col(fptr, TDOUBLE, 2, row+1, 1, n, &ra[0],     &fstatus);
+        fits_write_col(fptr, TDOUBLE, 3, row+1, 1, n, &dec[0],    &fstatus);
+        fits_write_col(fptr, TDOUBLE, 4, row+1, 1, n, &err[0],    &fstatus);
+        fits_write_col(fptr, TDOUBLE, 5, row+1, 1, n, &flux[0],   &fstatus);
+
+      } // endfor: looped over chunks
+
+    } while (0); // End of main do-loop
+
+    // Close catalogue
+    if (fptr != NULL)
+      fits_close_file(fptr, &fstatus);
+
+    // Return FITSIO status
+    return fstatus;
+
+}
+
+
+/*============================================================================*/
+/*                                 Benchmark                                  */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Run gtsrcid on synthetic catalogues and report throughput
+ *
+ * @param[in] opt Benchmark options.
+ * @param[in] srcfile Source catalogue file name.
+ * @param[in] src Sources.
+ * @param[in] ncpt Number of counterparts.
+ ******************************************************************************/
+int run_benchmark(BenchOptions &opt, std::string srcfile,
+                  std::vector<BenchSource> &src, long ncpt) {
+
+    // Declare local variables
+    int  rc = 0;
+    char cmd[4096];
+    char buffer[65536];
+
+    // Single loop for common exit point
+    do {
+
+      // Set file names
+      char tag[100];
+      sprintf(tag, "%ld", ncpt);
+      std::string cptfile  = opt.dir + "/bench_cpt_" + tag + ".fits";
+      std::string outfile  = opt.dir + "/bench_out_" + tag + ".fits";
+      std::string proffile = opt.dir + "/bench_prof_" + tag + ".json";
+      std::string logfile  = opt.dir + "/bench_" + tag + ".log";
+
+      // Generate counterpart catalogue
+      printf("Generate %ld counterparts ...\n", ncpt);
+      fflush(stdout);
+      rc = write_cpt_catalogue(cptfile, ncpt, opt.plane, opt.match, src);
+      if (rc != 0) {
+        fprintf(stderr, "Unable to write '%s' (FITSIO status %d).\n",
+                cptfile.c_str(), rc);
+        continue;
+      }
+      if (opt.generate)
+        continue;
+
+      // Build gtsrcid command. The exit status of gtsrcid is kept when
+      // the log file is moved.
+      int num = snprintf(cmd, sizeof(cmd),
+              "%s srcCatName=\"%s\" srcCatPrefix=\"SYN\" srcCatQty=\"*\" "
+              "cptCatName=\"%s\" cptCatPrefix=\"CPT\" cptCatQty=\"*\" "
+              "outCatName=\"%s\" probMethod=\"PROB_POST\" "
+              "probPrior=\"CATCH-22\" probThres=0.5 maxNumCpt=5 fom=\"\" "
+              "chatter=1 clobber=yes profile=yes profileFile=\"%s\" "
+              "mode=h > /dev/null 2>&1; rc=$?; mv -f gtsrcid.log \"%s\"; "
+              "exit $rc",
+              opt.exe.c_str(), srcfile.c_str(), cptfile.c_str(),
+              outfile.c_str(), proffile.c_str(), logfile.c_str());
+      if (num < 0 || num >= (int)sizeof(cmd)) {
+        fprintf(stderr, "gtsrcid command for '%s' is too long.\n",
+                opt.dir.c_str());
+        rc = 1;
+        continue;
+      }
+
+      // Run gtsrcid with profiling
+      rc = system(cmd);
+      if (rc != 0) {
+        fprintf(stderr, "gtsrcid failed (exit status %d, see '%s').\n",
+                (rc == -1) ? -1 : WEXITSTATUS(rc), logfile.c_str());
+        rc = 1;
+        continue;
+      }
+
+      // Read profile
+      FILE *fptr = fopen(proffile.c_str(), "r");
+      if (fptr == NULL) {
+        fprintf(stderr, "gtsrcid did not produce profile '%s' (see '%s').\n",
+                proffile.c_str(), logfile.c_str());
+        rc = 1;
+        continue;
+      }
+      size_t len  = fread(buffer, 1, sizeof(buffer)-1, fptr);
+      buffer[len] = '\0';
+      fclose(fptr);
+
+      // Report throughput
+      double wall = 0.0;
+      char  *ptr  = strstr(buffer, "\"wall\":");
+      if (ptr != NULL)
+        sscanf(ptr, "\"wall\": %lf", &wall);
+      printf("\n");
+      printf("Sources: %ld   Counterparts: %ld   Total wall time: %.3f s\n",
+             (long)src.size(), ncpt, wall);
+      printf("  %-14s %8s %10s %12s %12s %14s\n", "Stage", "Calls",
+             "Wall (s)", "Pairs", "Sources/s", "Pairs/s");
+      for (int i = 0; strcmp(c_stages[i], "stop") != 0; ++i) {
+        char key[100];
+        snprintf(key, sizeof(key), "\"%s\": {", c_stages[i]);
+        ptr = strstr(buffer, key);
+        if (ptr == NULL)
+          continue;
+        long   calls = 0;
+        long   count = 0;
+        double swall = 0.0;
+        double scpu  = 0.0;
+        sscanf(ptr + strlen(key), "\"calls\": %ld, \"wall\": %lf, "
+               "\"cpu\": %lf, \"count\": %ld", &calls, &swall, &scpu, &count);
+        if (calls < 1)
+          continue;
+        double src_rate  = (swall > 0.0) ? double(src.size()) / swall : 0.0;
+        double pair_rate = (swall > 0.0) ? double(count) / swall : 0.0;
+        printf("  %-14s %8ld %10.3f %12ld %12.4g %14.4g\n", c_stages[i],
+               calls, swall, count, src_rate, pair_rate);
+      }
+      printf("\n");
+      fflush(stdout);
+
+    } while (0); // End of main do-loop
+
+    // Return
+    return rc;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Parse command line options
+ *
+ * @param[in] argc Number of arguments.
+ * @param[in] argv Arguments.
+ * @param[out] opt Benchmark options.
+ ******************************************************************************/
+int parse_options(int argc, char *argv[], BenchOptions &opt) {
+
+    // Set defaults
+    opt.nsrc     = 2000;
+    opt.seed     = 1;
+    opt.plane    = 0.5;
+    opt.match    = 0.5;
+    opt.dir      = ".";
+    opt.exe      = "gtsrcid";
+    opt.generate = 0;
+    opt.ncpt.clear();
+
+    // Parse arguments
+    for (int i = 1; i < argc; ++i) {
+      std::string arg  = argv[i];
+      const char *next = (i+1 < argc) ? argv[i+1] : NULL;
+      if (arg == "-generate")
+        opt.generate = 1;
+      else if (next == NULL) {
+        fprintf(stderr, "Missing value for option '%s'.\n", arg.c_str());
+        return 1;
+      }
+      else if (arg == "-nsrc")  { opt.nsrc  = atol(next); i++; }
+      else if (arg == "-seed")  { opt.seed  = strtoul(next, NULL, 10); i++; }
+      else if (arg == "-plane") { opt.plane = atof(next); i++; }
+      else if (arg == "-match") { opt.match = atof(next); i++; }
+      else if (arg == "-dir")   { opt.dir   = next; i++; }
+      else if (arg == "-exe")   { opt.exe   = next; i++; }
+      else if (arg == "-ncpt") {
+        std::string list = next;
+        size_t      pos  = 0;
+        while (pos != std::string::npos) {
+          size_t end = list.find(",", pos);
+          opt.ncpt.push_back(atof(list.substr(pos, end-pos).c_str()));
+          pos = (end == std::string::npos) ? end : end + 1;
+        }
+        i++;
+      }
+      else {
+        fprintf(stderr, "Unknown option '%s'.\n", arg.c_str());
+        return 1;
+      }
+    }
+
+    // Default counterpart catalogue sizes
+    if (opt.ncpt.size() < 1) {
+      opt.ncpt.push_back(1.0e3);
+      opt.ncpt.push_back(1.0e4);
+      opt.ncpt.push_back(1.0e5);
+      opt.ncpt.push_back(1.0e6);
+    }
+
+    // Return
+    return 0;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Main entry point
+ *
+ * @param[in] argc Number of arguments.
+ * @param[in] argv Arguments.
+ ******************************************************************************/
+int main(int argc, char *argv[]) {
+
+    // Declare local variables
+    BenchOptions             opt;
+    std::vector<BenchSource> src;
+    int                      rc = 0;
+
+    // Single loop for common exit point
+    do {
+
+      // Parse options
+      rc = parse_options(argc, argv, opt);
+      if (rc != 0) {
+        fprintf(stderr, "Usage: gtsrcid_bench [-nsrc N] [-ncpt N1,N2,...] "
+                "[-seed S] [-plane F] [-match F] [-dir DIR] [-exe GTSRCID] "
+                "[-generate]\n");
+        continue;
+      }
+
+      // Seed random number generator
+      g_rng_state ^= (unsigned long long)opt.seed * 0x9E3779B97F4A7C15ULL;
+
+      // Generate sources. 95% error ellipses are drawn log-uniformly between
+      // 1.2' and 18'.
+      src.resize(opt.nsrc);
+      for (long i = 0; i < opt.nsrc; ++i) {
+        random_direction(opt.plane, &src[i].ra, &src[i].dec);
+        src[i].maj = 0.02 * exp(log(15.0) * rng_uniform());
+        src[i].min = src[i].maj * (0.6 + 0.4 * rng_uniform());
+        src[i].pa  = 180.0 * rng_uniform();
+      }
+
+      // Write source catalogue
+      std::string srcfile = opt.dir + "/bench_src.fits";
+      printf("Generate %ld sources ...\n", opt.nsrc);
+      rc = write_src_catalogue(srcfile, src);
+      if (rc != 0) {
+        fprintf(stderr, "Unable to write '%s' (FITSIO status %d).\n",
+                srcfile.c_str(), rc);
+        continue;
+      }
+
+      // Loop over counterpart catalogue sizes
+      for (size_t k = 0; k < opt.ncpt.size(); ++k) {
+        int krc = run_benchmark(opt, srcfile, src, long(opt.ncpt[k]));
+        if (krc != 0)
+          rc = krc;
+      }
+
+    } while (0); // End of main do-loop
+
+    // Return
+    return (rc == 0) ? 0 : 1;
+
+}
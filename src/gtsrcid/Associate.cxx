@@ -0,0 +1,138 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file Associate.cxx
+ * @brief Programmatic source association interface implementation.
+ * @author J. Knodlseder
+ */
+
+/* Includes _________________________________________________________________ */
+#include "Associate.h"
+#include "Parameters.h"
+#include "Catalogue.h"
+
+
+/* Definitions ______________________________________________________________ */
+
+
+/* Namespace definition _____________________________________________________ */
+namespace sourceIdentify {
+
+
+/* Type defintions __________________________________________________________ */
+
+
+/* Globals __________________________________________________________________ */
+
+
+/* Private Prototypes _______________________________________________________ */
+
+
+/**************************************************************************//**
+ * @brief Initialise in-memory catalogue
+ *
+ * @param[out] cat Pointer to in-memory catalogue.
+ ******************************************************************************/
+void AssocInitCatalogue(AssocCatalogue *cat) {
+
+    // Initialise catalogue
+    cat->numObjects = 0;
+    cat->ra         = NULL;
+    cat->dec        = NULL;
+    cat->err_maj    = NULL;
+    cat->err_min    = NULL;
+    cat->err_ang    = NULL;
+    cat->names      = NULL;
+    cat->colNames.clear();
+    cat->colData.clear();
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Initialise association options
+ *
+ * @param[out] opt Pointer to association options.
+ *
+ * The options are set to the defaults of the gtsrcid parameter file, except
+ * for the chatter level which is set to 0 (silent).
+ ******************************************************************************/
+void AssocInitOptions(AssocOptions *opt) {
+
+    // Initialise options
+    opt->srcPrefix   = "SRC";
+    opt->cptPrefix   = "CPT";
+    opt->srcPosError = 0.0;
+    opt->cptPosError = 0.0;
+    opt->probMethod  = "PROB_POST";
+    opt->probPrior   = "0.01";
+    opt->probThres   = 0.05;
+    opt->maxNumCpt   = 4;
+    opt->fom         = "";
+    opt->chatter     = 0;
+    opt->cptCatName  = "";
+    opt->cptDensFile = "";
+    opt->outCatQty.clear();
+    opt->select.clear();
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Associate in-memory catalogues
+ *
+ * @param[in] src Source catalogue.
+ * @param[in] cpt Counterpart catalogue.
+ * @param[in] opt Association options.
+ * @param[out] res Association results.
+ * @param[in] status Error status.
+ ******************************************************************************/
+Status associate(const AssocCatalogue &src, const AssocCatalogue &cpt,
+                 const AssocOptions &opt, AssocResult &res, Status status) {
+
+    // Declare local variables
+    Parameters par;
+    Catalogue  cat;
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Initialise results
+      res.numAssoc = 0;
+
+      // Set parameters
+      status = par.set(opt, status);
+      if (status != STATUS_OK)
+        continue;
+
+      // Associate catalogues
+      status = cat.associate(&par, src, cpt, res, status);
+      if (status != STATUS_OK)
+        continue;
+
+    } while (0); // End of main do-loop
+
+    // Return status
+    return status;
+
+}
+
+
+/* Namespace ends ___________________________________________________________ */
+}
@@ -0,0 +1,92 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file Associate.h
+ * @brief Programmatic source association interface definition.
+ * @author J. Knodlseder
+ *
+ * This interface allows to perform source association on catalogues that
+ * are held in memory, without going through parameter files, log files or
+ * FITS files on disk. All probability computations and formula evaluations
+ * are identical to those of the gtsrcid executable.
+ */
+
+#ifndef ASSOCIATE_H
+#define ASSOCIATE_H
+
+/* Includes _________________________________________________________________ */
+#include <string>
+#include <vector>
+#include "sourceIdentify.h"
+
+
+/* Namespace definition _____________________________________________________ */
+namespace sourceIdentify {
+
+
+/* Type defintions __________________________________________________________ */
+typedef struct {                      // In-memory catalogue
+  long                       numObjects; //!< Number of objects
+  const double              *ra;         //!< Right Ascension (deg)
+  const double              *dec;        //!< Declination (deg)
+  const double              *err_maj;    //!< 95% error ellipse major axis (deg)
+  const double              *err_min;    //!< 95% error ellipse minor axis (deg)
+  const double              *err_ang;    //!< Error ellipse position angle (deg)
+  const char * const        *names;      //!< Object names (optional)
+  std::vector<std::string>   colNames;   //!< Additional column names
+  std::vector<const double*> colData;    //!< Additional column values
+} AssocCatalogue;
+
+typedef struct {                      // Association options
+  std::string                srcPrefix;  //!< Source column prefix
+  std::string                cptPrefix;  //!< Counterpart column prefix
+  double                     srcPosError;//!< Default source position error
+  double                     cptPosError;//!< Default cpt. position error
+  std::string                probMethod; //!< Association probability formula
+  std::string                probPrior;  //!< Prior probability formula
+  double                     probThres;  //!< Probability threshold
+  long                       maxNumCpt;  //!< Maximum # of counterparts
+  std::string                fom;        //!< Figure of merit
+  std::vector<std::string>   outCatQty;  //!< New quantities ("NAME=formula")
+  std::vector<std::string>   select;     //!< Selection criteria
+  int                        chatter;    //!< Chatter level (0 = silent)
+  std::string                cptCatName; //!< Counterpart catalogue (resident)
+  std::string                cptDensFile;//!< Counterpart density map (resident)
+} AssocOptions;
+
+typedef struct {                      // Association results
+  long                       numAssoc;    //!< Number of associations
+  std::vector<int>           src;         //!< Source index (from 0)
+  std::vector<long>          cpt;         //!< Counterpart index (from 0)
+  std::vector<double>        prob;        //!< Association probability
+  std::vector<double>        prob_pos;    //!< Positional probability
+  std::vector<double>        prob_chance; //!< Chance coincidence probability
+  std::vector<double>        prob_prior;  //!< Prior probability
+  std::vector<double>        prob_post;   //!< Posterior probability
+  std::vector<double>        prob_post_single; //!< Single source post. prob.
+  std::vector<double>        likrat;      //!< Likelihood ratio
+  std::vector<double>        angsep;      //!< Angular separation (deg)
+  std::vector<double>        psi;         //!< Effective error radius (deg)
+  std::vector<double>        rho;         //!< Local counterpart density
+  std::vector<double>        fom;         //!< Figure of merit
+  std::vector<std::string>   qtyNames;    //!< New quantity names
+  std::vector<std::vector<double> > qtyData; //!< New quantity values
+} AssocResult;
+
+
+/* Prototypes _______________________________________________________________ */
+void   AssocInitCatalogue(AssocCatalogue *cat);
+void   AssocInitOptions(AssocOptions *opt);
+Status associate(const AssocCatalogue &src, const AssocCatalogue &cpt,
+                 const AssocOptions &opt, AssocResult &res, Status status);
+
+
+/* Namespace ends ___________________________________________________________ */
+}
+#endif // ASSOCIATE_H
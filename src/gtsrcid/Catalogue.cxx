@@ -197,10 +197,11 @@ Replace header information with CVS typeset information.
 #include "sourceIdentify.h"
 #include "Catalogue.h"
 #include "Log.h"
+#include "Profile.h"
+#include "Trace.h"
 
 
 /* Definitions ______________________________________________________________ */
-#define CATALOGUE_TIMING   0                     // Enables timing measurements
 
 
 /* Namespace definition _____________________________________________________ */
@@ -235,7 +236,7 @@ Status      get_pos_error_info(Parameters *par, InCatalogue *in,
                                std::vector <std::string> &qtyNames,
                                Status status);
 void        set_info(Parameters *par, InCatalogue *in, int &i, ObjectInfo *ptr,
-                     double &posErr);
+                     std::string &name, double &posErr);
 
 
 /*============================================================================*/
@@ -855,10 +856,14 @@ Status get_pos_error_info(Parameters *par, InCatalogue *in,
  * @param[in] in Pointer to input catalogue.
  * @param[in] i Source number (starting from 0).
  * @param[in] ptr Pointer to source information structure.
+ * @param[out] name Source name.
  * @param[in] posErr Error radius if no error is found in catalogue.
+ *
+ * The source name is returned separately since it is stored by the caller
+ * in the catalogue name pool.
  ******************************************************************************/
 void set_info(Parameters *par, InCatalogue *in, int &i, ObjectInfo *ptr,
-              double &posErr) {
+              std::string &name, double &posErr) {
 
     // Declare local variables
     double err_maj;
@@ -876,7 +881,8 @@ void set_info(Parameters *par, InCatalogue *in, int &i, ObjectInfo *ptr,
 
       // Initialise source information
       ptr->pos_valid   = 0;        // Invalid position
-      ptr->name.clear();
+      ptr->name        = NULL;
+      name.clear();
       ptr->pos_eq_ra   = 0.0;
       ptr->pos_eq_dec  = 0.0;
       ptr->pos_err_maj = posErr;
@@ -884,8 +890,8 @@ void set_info(Parameters *par, InCatalogue *in, int &i, ObjectInfo *ptr,
       ptr->pos_err_ang = 0.0;
 
       // Set source name
-      if (in->cat.getSValue(in->col_id, i, &(ptr->name)) != IS_OK)
-        ptr->name = "no-name";
+      if (in->cat.getSValue(in->col_id, i, &name) != IS_OK)
+        name = "no-name";
 
       // Set source position
       if (in->pos_type == Equatorial) {
@@ -1009,6 +1015,8 @@ void Catalogue::init_memory(void) {
       m_src.numLoad     = 0;
       m_src.numTotal    = 0;
       m_src.object      = NULL;
+      m_src.table       = NULL;
+      m_src.names.clear();
       m_src.col_e_type  = NoError;
       m_src.e_pos_scale = 1.0;
       m_src.inName.clear();
@@ -1030,6 +1038,8 @@ void Catalogue::init_memory(void) {
       m_cpt.numLoad     = 0;
       m_cpt.numTotal    = 0;
       m_cpt.object      = NULL;
+      m_cpt.table       = NULL;
+      m_cpt.names.clear();
       m_cpt.col_e_type  = NoError;
       m_cpt.e_pos_scale = 1.0;
       m_cpt.inName.clear();
@@ -1057,10 +1067,30 @@ void Catalogue::init_memory(void) {
       // Initialise list of selected counterparts
       m_cpt_sel = NULL;
 
+      // Initialise counterpart declination index
+      m_cpt_zone.clear();
+      m_cpt_zone_dec.clear();
+      m_cpt_zone_ra.clear();
+      m_cpt_no_pos = 0;
+
+      // Initialise counterpart candidate arena
+      m_cc_block.clear();
+      m_cc_size = 0;
+      m_cc_used = 0;
+
       // Initialise counterpart statistics
       m_num_Sel  = 0;
       m_cpt_stat = NULL;
 
+      // Initialise streaming association
+      m_stream_size = 0;
+      m_stream_col.clear();
+      m_stream_names.clear();
+
+      // Initialise checkpointing
+      m_chk_file = NULL;
+      m_chk_hash.clear();
+
       // Initialise counterpart density flag
       m_has_density = 0;
 
@@ -1083,6 +1113,14 @@ void Catalogue::init_memory(void) {
       m_fract_not_unique = 0.0;
       m_num_lr_div       = 0.0;
 
+      // Prior and threshold sweep
+      m_sweep_names.clear();
+      m_sweep.clear();
+      m_curve_names.clear();
+      m_curve.clear();
+      m_mc_names.clear();
+      m_mc.clear();
+
       // Initialise output catalogue quantities
       m_num_src_Qty   = 0;
       m_num_cpt_Qty   = 0;
@@ -1106,16 +1144,24 @@ void Catalogue::free_memory(void) {
     do {
 
       // Free source information
-      if (m_info != NULL) {
-        for (int i = 0; i < m_src.numLoad; ++i) {
-          if (m_info[i].cc != NULL) delete [] m_info[i].cc;
-        }
-        delete [] m_info;
-      }
+      if (m_info != NULL) delete [] m_info;
+
+      // Close checkpoint file
+      chk_close();
+
+      // Free counterpart candidate arena
+      for (int i = 0; i < (int)m_cc_block.size(); ++i)
+        delete [] m_cc_block[i];
 
       // Free temporary memory
       if (m_src.object != NULL) delete [] m_src.object;
       if (m_cpt.object != NULL) delete [] m_cpt.object;
+      std::vector<char>().swap(m_src.names);
+      std::vector<char>().swap(m_cpt.names);
+      std::vector<int>().swap(m_cpt_zone);
+      std::vector<double>().swap(m_cpt_zone_dec);
+      std::vector<double>().swap(m_cpt_zone_ra);
+      std::vector<std::vector<int> >().swap(m_stream_col);
       if (m_cpt_stat   != NULL) delete [] m_cpt_stat;
       if (m_cpt_sel    != NULL) delete [] m_cpt_sel;
 
@@ -1157,6 +1203,9 @@ Status Catalogue::get_input_descriptor(Parameters *par, std::string catName,
     if (par->logDebug())
       Log(Log_0, " ==> ENTRY: Catalogue::get_input_descriptor");
 
+    // Start profiling
+    ProfileStart(Prof_Descriptor);
+
     // Single loop for common exit point
     do {
 
@@ -1273,6 +1322,9 @@ Status Catalogue::get_input_descriptor(Parameters *par, std::string catName,
 
     } while (0); // End of main do-loop
 
+    // Stop profiling
+    ProfileStop(Prof_Descriptor, 0);
+
     // Debug mode: Entry
     if (par->logDebug())
       Log(Log_0, " <== EXIT: Catalogue::get_input_descriptor (status=%d)", 
@@ -1299,6 +1351,9 @@ Status Catalogue::get_input_catalogue(Parameters *par, InCatalogue *in,
     if (par->logDebug())
       Log(Log_0, " ==> ENTRY: Catalogue::get_input_catalogue");
 
+    // Start profiling
+    ProfileStart(Prof_Load);
+
     // Single loop for common exit point
     do {
 
@@ -1347,20 +1402,46 @@ Status Catalogue::get_input_catalogue(Parameters *par, InCatalogue *in,
         continue;
       }
 
-      // Extract object information
+      // Extract object information. The object names are appended to the
+      // name pool; as the pool may grow we first only store the offsets.
+      std::vector<long> offset(in->numLoad);
+      std::string       name;
+      std::vector<char>().swap(in->names);
       ObjectInfo *ptr = in->object;
       for (int i = 0; i < in->numLoad; i++, ptr++) {
 
         // Set source information
-        set_info(par, in, i, ptr, posErr);
+        set_info(par, in, i, ptr, name, posErr);
 
         // Assign source name
-        ptr->name = cid_assign_src_name(ptr->name, i);
+        name = cid_assign_src_name(name, i);
+
+        // Append name to name pool
+        offset[i] = in->names.size();
+        in->names.insert(in->names.end(), name.begin(), name.end());
+        in->names.push_back('\0');
 
       } // endfor: looped over all objects
 
+      // Release unused name pool memory and set name pointers
+      std::vector<char>(in->names).swap(in->names);
+      for (int i = 0; i < in->numLoad; ++i)
+        in->object[i].name = &(in->names[offset[i]]);
+
+      // Report memory footprint
+      if (par->logNormal()) {
+        double mb_obj   = double(in->numLoad * sizeof(ObjectInfo)) / 1048576.0;
+        double mb_names = double(in->names.size()) / 1048576.0;
+        Log(Log_2, " Object memory footprint ..........: %.3f MB (%ld objects"
+                   " of %d Bytes, %.3f MB names)",
+            mb_obj+mb_names, in->numLoad, (int)sizeof(ObjectInfo), mb_names);
+      }
+
     } while (0); // End of main do-loop
 
+    // Stop profiling
+    ProfileStop(Prof_Load, in->numLoad);
+
     // Debug mode: Entry
     if (par->logDebug())
       Log(Log_0, " <== EXIT: Catalogue::get_input_catalogue (status=%d)",
@@ -1372,6 +1453,76 @@ Status Catalogue::get_input_catalogue(Parameters *par, InCatalogue *in,
 }
 
 
+/**************************************************************************//**
+ * @brief Read counterpart density map
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] status Error status.
+ *
+ * Reads the optional HEALPix counterpart density map. Errors while reading
+ * the map are reported as warnings, and the density map is not used.
+ ******************************************************************************/
+Status Catalogue::get_density_map(Parameters *par, Status status) {
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::get_density_map");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Read counterpart density map
+      if (par->m_cptDensFile.length() > 0) {
+        m_has_density = 0;
+        if (par->logNormal()) {
+          Log(Log_2, "");
+          Log(Log_2, "Read counterpart catalogue density map:");
+          Log(Log_2, "=======================================");
+        }
+        try {
+          m_density     = GHealpix(par->m_cptDensFile);
+          m_has_density = 1;
+          if (par->logNormal()) {
+            Log(Log_2, " Filename .........................: %s", par->m_cptDensFile.c_str());
+            Log(Log_2, " Nside (number of divisions) ......: %d", m_density.nside());
+          }
+        }
+        catch (std::exception &e) {
+          if (par->logTerse()) {
+            Log(Warning_3, "Error occured while loading file '%s' (standard exception)",
+                            par->m_cptDensFile.c_str());
+          }
+        }
+        catch (std::string str) {
+          if (par->logTerse()) {
+            Log(Warning_3, "Error occured while loading file '%s': %s.",
+                            par->m_cptDensFile.c_str(), str.c_str());
+          }
+        }
+        catch (...) {
+          if (par->logTerse()) {
+            Log(Warning_3, "Error occured while loading file '%s' (unknown exception)",
+                            par->m_cptDensFile.c_str());
+          }
+        }
+      }
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::get_density_map (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
 /**************************************************************************//**
  * @brief Dump catalogue descriptor
  *
@@ -1588,11 +1739,16 @@ Status Catalogue::compute_prob_post_cat(Parameters *par, Status status,
     double* tmp_sum    = NULL;  // Normalization sum
     int*    tmp_k      = NULL;  // LAT source index k for each element
     int*    tmp_istart = NULL;  // First element index in each column
+    double* tmp_prod1  = NULL;  // Probability product 1 for each candidate
+    double* tmp_prod2  = NULL;  // Probability product 2 for each candidate
 
     // Debug mode: Entry
     if (par->logDebug())
       Log(Log_0, " ==> ENTRY: Catalogue::compute_prob_post_cat");
 
+    // Start profiling
+    ProfileStart(Prof_PostCat);
+
     // Single loop for common exit point
     do {
 
@@ -1645,10 +1801,14 @@ Status Catalogue::compute_prob_post_cat(Parameters *par, Status status,
       if (num_elements < 1)
         continue;
 
-      // Allocate memory for sparse matrix element values and indices
+      // Allocate memory for sparse matrix element values and indices and
+      // for the probability products (one per counterpart candidate)
       tmp_prob   = new double[num_elements];
       tmp_k      = new int[num_elements];
-      if (tmp_prob == NULL || tmp_k == NULL) {
+      tmp_prod1  = new double[num_elements];
+      tmp_prod2  = new double[num_elements];
+      if (tmp_prob == NULL || tmp_k == NULL || tmp_prod1 == NULL ||
+          tmp_prod2 == NULL) {
         status = STATUS_MEM_ALLOC;
         if (par->logTerse())
           Log(Error_2, "%d : Memory allocation failure.", (Status)status);
@@ -1702,9 +1862,10 @@ Status Catalogue::compute_prob_post_cat(Parameters *par, Status status,
         continue;
 
       // Compute probability products. This is now done quickly by multiplying
-      // down a column
-      for (int k = 0; k < m_src.numLoad; ++k) {
-        for (int i = 0; i < m_info[k].numRefine; ++i) {
+      // down a column. The products are stored in the order in which the
+      // counterpart candidates are visited.
+      for (int k = 0, n = 0; k < m_src.numLoad; ++k) {
+        for (int i = 0; i < m_info[k].numRefine; ++i, ++n) {
 
           // Get sparse matrix column
           int col = m_info[k].cc[i].index;
@@ -1714,32 +1875,32 @@ Status Catalogue::compute_prob_post_cat(Parameters *par, Status status,
           int stop  = tmp_istart[col+1];
 
           // Compute products
-          m_info[k].cc[i].prob_prod1 = 1.0; // all k'
-          m_info[k].cc[i].prob_prod2 = 1.0; // all k' except of k
+          tmp_prod1[n] = 1.0; // all k'
+          tmp_prod2[n] = 1.0; // all k' except of k
           for (int element = start; element < stop; ++element) {
-            m_info[k].cc[i].prob_prod1   *= tmp_prob[element];
+            tmp_prod1[n]   *= tmp_prob[element];
             if (k != tmp_k[element])
-              m_info[k].cc[i].prob_prod2 *= tmp_prob[element];
+              tmp_prod2[n] *= tmp_prob[element];
           }
 
         }
       }
 
       // Initialise normalization sums with Pi(H-|D)
-      for (int k = 0; k < m_src.numLoad; ++k) {
-        for (int i = 0; i < m_info[k].numRefine; ++i) {
+      for (int k = 0, n = 0; k < m_src.numLoad; ++k) {
+        for (int i = 0; i < m_info[k].numRefine; ++i, ++n) {
           int index      = m_info[k].cc[i].index;
-          tmp_sum[index] = m_info[k].cc[i].prob_prod1;
+          tmp_sum[index] = tmp_prod1[n];
         }
       }
 
       // Compute catalogue posterior probabilities and update normalization sum
-      for (int k = 0; k < m_src.numLoad; ++k) {
-        for (int i = 0; i < m_info[k].numRefine; ++i) {
+      for (int k = 0, n = 0; k < m_src.numLoad; ++k) {
+        for (int i = 0; i < m_info[k].numRefine; ++i, ++n) {
 
           // Compute posterior probability
           m_info[k].cc[i].prob_post_cat = m_info[k].cc[i].prob_post_single *
-                                          m_info[k].cc[i].prob_prod2;
+                                          tmp_prod2[n];
 
           // Update normalization sum
           int index       = m_info[k].cc[i].index;
@@ -1748,19 +1909,12 @@ Status Catalogue::compute_prob_post_cat(Parameters *par, Status status,
         }
       }
 
-      // Copy normalization sum into counterpart candidate field
-      for (int k = 0; k < m_src.numLoad; ++k) {
-        for (int i = 0; i < m_info[k].numRefine; ++i) {
-          int index                 = m_info[k].cc[i].index;
-          m_info[k].cc[i].prob_norm = tmp_sum[index];
-        }
-      }
-
       // Normalize catalogue posterior probabilities
       for (int k = 0; k < m_src.numLoad; ++k) {
         for (int i = 0; i < m_info[k].numRefine; ++i) {
-          if (m_info[k].cc[i].prob_norm > 0.0)
-            m_info[k].cc[i].prob_post_cat /= m_info[k].cc[i].prob_norm;
+          double norm = tmp_sum[m_info[k].cc[i].index];
+          if (norm > 0.0)
+            m_info[k].cc[i].prob_post_cat /= norm;
           else
             m_info[k].cc[i].prob_post_cat = 0.0;
         }
@@ -1774,17 +1928,17 @@ Status Catalogue::compute_prob_post_cat(Parameters *par, Status status,
         Log(Log_2,
             "  ------------  ------------------   --------- => ---------"
             "  ---------  ---------   -----");
-        for (int k = 0; k < m_src.numLoad; ++k) {
-          for (int i = 0; i < m_info[k].numRefine; ++i) {
+        for (int k = 0, n = 0; k < m_src.numLoad; ++k) {
+          for (int i = 0; i < m_info[k].numRefine; ++i, ++n) {
             Log(Log_2,
                 "  Source %5d: Counterpart %6d : %8.4f%% => %8.4f%%"
                 " (%8.4f%%, %8.4f%%, %6.3f)",
                 k+1, m_info[k].cc[i].index + 1,
                 m_info[k].cc[i].prob_post_single*100.0,
                 m_info[k].cc[i].prob_post_cat*100.0,
-                m_info[k].cc[i].prob_prod1*100.0,
-                m_info[k].cc[i].prob_prod2*100.0,
-                m_info[k].cc[i].prob_norm);
+                tmp_prod1[n]*100.0,
+                tmp_prod2[n]*100.0,
+                tmp_sum[m_info[k].cc[i].index]);
           }
         }
       }
@@ -1796,6 +1950,16 @@ Status Catalogue::compute_prob_post_cat(Parameters *par, Status status,
     if (tmp_k      != NULL) delete [] tmp_k;
     if (tmp_istart != NULL) delete [] tmp_istart;
     if (tmp_sum    != NULL) delete [] tmp_sum;
+    if (tmp_prod1  != NULL) delete [] tmp_prod1;
+    if (tmp_prod2  != NULL) delete [] tmp_prod2;
+
+    // Stop profiling
+    if (ProfileEnabled()) {
+      long num = 0;
+      for (int k = 0; k < m_src.numLoad; ++k)
+        num += m_info[k].numRefine;
+      ProfileStop(Prof_PostCat, num);
+    }
 
     // Debug mode: Entry
     if (par->logDebug())
@@ -1817,10 +1981,18 @@ Status Catalogue::compute_prob_post_cat(Parameters *par, Status status,
  ******************************************************************************/
 Status Catalogue::compute_prob_post(Parameters *par, Status status, int quiet) {
 
+    // Declare local variables
+    double* tmp_prod1 = NULL;  // Probability product 1 for each candidate
+    double* tmp_prod2 = NULL;  // Probability product 2 for each candidate
+    double* tmp_norm  = NULL;  // Normalization for each source
+
     // Debug mode: Entry
     if (par->logDebug())
       Log(Log_0, " ==> ENTRY: Catalogue::compute_prob_post");
 
+    // Start profiling
+    ProfileStart(Prof_Post);
+
     // Single loop for common exit point
     do {
 
@@ -1835,50 +2007,41 @@ Status Catalogue::compute_prob_post(Parameters *par, Status status, int quiet) {
       m_fract_not_unique = 0.0;
       double num         = 0.0;
 
+      // Determine total number of counterpart candidates
+      int num_cc = 0;
+      for (int k = 0; k < m_src.numLoad; ++k)
+        num_cc += m_info[k].numRefine;
+
+      // Allocate memory for probability products and normalizations
+      tmp_prod1 = new double[num_cc+1];
+      tmp_prod2 = new double[num_cc+1];
+      tmp_norm  = new double[m_src.numLoad+1];
+      if (tmp_prod1 == NULL || tmp_prod2 == NULL || tmp_norm == NULL) {
+        status = STATUS_MEM_ALLOC;
+        if (par->logTerse())
+          Log(Error_2, "%d : Memory allocation failure.", (Status)status);
+        continue;
+      }
+
       // Initialise probability products for all counterpart candidates
-      for (int k = 0; k < m_src.numLoad; ++k) {
+      for (int k = 0, n = 0; k < m_src.numLoad; ++k) {
+
+        // Initialise normalization
+        tmp_norm[k] = 0.0;
 
         // Perform computations only if there are counterparts for this source
         if (m_info[k].numRefine > 0) {
 
-          // Compute products
-          for (int i = 0; i < m_info[k].numRefine; ++i) {
-            m_info[k].cc[i].prob_prod1 = 1.0; // all i'
-            m_info[k].cc[i].prob_prod2 = 1.0; // all i' except of i
-            for (int ip = 0; ip < m_info[k].numRefine; ++ip) {
-              if (i == ip)
-                m_info[k].cc[i].prob_prod1  = (1.0 - m_info[k].cc[ip].prob_post_cat);
-              else
-                m_info[k].cc[i].prob_prod2 *= (1.0 - m_info[k].cc[ip].prob_post_cat);
-            }
-            m_info[k].cc[i].prob_prod1 *= m_info[k].cc[i].prob_prod2;
-          }
-
-          // Compute non-normalized posterior probabilities and normalization
-          // factor
-          double norm = m_info[k].cc[0].prob_prod1;
-          for (int i = 0; i < m_info[k].numRefine; ++i) {
-            m_info[k].cc[i].prob_post = m_info[k].cc[i].prob_post_cat *
-                                        m_info[k].cc[i].prob_prod2;
-            norm += m_info[k].cc[i].prob_post ;
-          }
+          // Get pointer to probability products of this source
+          double *prod1 = tmp_prod1 + n;
+          double *prod2 = tmp_prod2 + n;
+          n            += m_info[k].numRefine;
 
           // Compute unique association probabilities
-          if (norm > 0.0) {
-            for (int i = 0; i < m_info[k].numRefine; ++i) {
-              m_info[k].cc[i].prob_post /= norm;
-              m_info[k].cc[i].prob_norm  = norm;
-            }
-          }
-          else {
-            for (int i = 0; i < m_info[k].numRefine; ++i) {
-              m_info[k].cc[i].prob_post = 0.0;
-              m_info[k].cc[i].prob_norm = norm;
-            }
-          }
+          tmp_norm[k] = cid_prob_unique(&(m_info[k]), prod1, prod2);
 
           // Update fraction of non unique sources
-          m_fract_not_unique += (1.0 - norm);
+          m_fract_not_unique += (1.0 - tmp_norm[k]);
           num                += 1.0;
 
         } // endif: there were counterparts
@@ -1897,23 +2060,36 @@ Status Catalogue::compute_prob_post(Parameters *par, Status status, int quiet) {
         Log(Log_2,
             "  ------------  ------------------   --------- => ---------"
             "  ---------  ---------   -----");
-        for (int k = 0; k < m_src.numLoad; ++k) {
-          for (int i = 0; i < m_info[k].numRefine; ++i) {
+        for (int k = 0, n = 0; k < m_src.numLoad; ++k) {
+          for (int i = 0; i < m_info[k].numRefine; ++i, ++n) {
             Log(Log_2,
                 "  Source %5d: Counterpart %6d : %8.4f%% => %8.4f%%"
                 " (%8.4f%%, %8.4f%%, %6.3f)",
                 k+1, m_info[k].cc[i].index + 1,
                 m_info[k].cc[i].prob_post_cat*100.0,
                 m_info[k].cc[i].prob_post*100.0,
-                m_info[k].cc[i].prob_prod1*100.0,
-                m_info[k].cc[i].prob_prod2*100.0,
-                m_info[k].cc[i].prob_norm);
+                tmp_prod1[n]*100.0,
+                tmp_prod2[n]*100.0,
+                tmp_norm[k]);
           }
         }
       }
 
     } while (0); // End of main do-loop
 
+    // Delete temporary memory
+    if (tmp_prod1 != NULL) delete [] tmp_prod1;
+    if (tmp_prod2 != NULL) delete [] tmp_prod2;
+    if (tmp_norm  != NULL) delete [] tmp_norm;
+
+    // Stop profiling
+    if (ProfileEnabled()) {
+      long num = 0;
+      for (int k = 0; k < m_src.numLoad; ++k)
+        num += m_info[k].numRefine;
+      ProfileStop(Prof_Post, num);
+    }
+
     // Debug mode: Entry
     if (par->logDebug())
       Log(Log_0, " <== EXIT: Catalogue::compute_prob_post (status=%d)",
@@ -1937,6 +2113,9 @@ Status Catalogue::compute_prob(Parameters *par, Status status) {
     if (par->logDebug())
       Log(Log_0, " ==> ENTRY: Catalogue::compute_prob");
 
+    // Start profiling
+    ProfileStart(Prof_Prob);
+
     // Single loop for common exit point
     do {
 
@@ -1959,8 +2138,8 @@ Status Catalogue::compute_prob(Parameters *par, Status status) {
       // Loop over all sources
       for (int k = 0; k < m_src.numLoad; ++k) {
 
-        // Compute PROB
-        status = cid_prob(par, &(m_info[k]), status);
+        // Compute PROB and determine claimed counterpart candidates
+        status = cid_claim(par, &(m_info[k]), status);
         if (status != STATUS_OK) {
           if (par->logTerse())
             Log(Error_2, "%d : Unable to determine association probability.",
@@ -1968,15 +2147,6 @@ Status Catalogue::compute_prob(Parameters *par, Status status) {
           break;
         }
 
-        // Sort counterpart candidates by decreasing probability
-        status = cid_sort(par, &(m_info[k]), m_info[k].numRefine, status);
-        if (status != STATUS_OK) {
-          if (par->logTerse())
-            Log(Error_2, "%d : Unable to sort counterpart candidates.",
-                (Status)status);
-          break;
-        }
-
         // Sum up probabilities before thresholding.
         for (int iCC = 0; iCC < m_info[k].numRefine; ++iCC) {
           m_sum_pid += m_info[k].cc[iCC].prob;
@@ -1984,30 +2154,6 @@ Status Catalogue::compute_prob(Parameters *par, Status status) {
           m_sum_lr  += m_info[k].cc[iCC].likrat;
         }
 
-        // Determine the number of counterpart candidates above the probability
-        // threshold
-        int numUseCC = 0;
-        for (int iCC = 0; iCC < m_info[k].numRefine; ++iCC) {
-          if (m_info[k].cc[iCC].prob >= par->m_probThres)
-            numUseCC++;
-          else
-            break;
-        }
-
-        // Apply the maximum number of counterpart threshold
-        if (numUseCC > par->m_maxNumCpt)
-          numUseCC = par->m_maxNumCpt;
-
-        // Eliminate counterpart candidates below threshold.
-        m_info[k].numClaimed = numUseCC;
-
-        // Set unique counterpart candidate identifier (overwrite former ID)
-        char cid[OUTCAT_MAX_STRING_LEN];
-        for (int iCC = 0; iCC < m_info[k].numClaimed; ++iCC) {
-          sprintf(cid, "CC_%5.5d_%5.5d", k+1, iCC+1);
-          m_info[k].cc[iCC].id = cid;
-        }
-
         // Sum up probabilities after thresholding
         for (int iCC = 0; iCC < m_info[k].numClaimed; ++iCC) {
           m_sum_pid_thr += m_info[k].cc[iCC].prob;
@@ -2028,6 +2174,14 @@ Status Catalogue::compute_prob(Parameters *par, Status status) {
 
     } while (0); // End of main do-loop
 
+    // Stop profiling
+    if (ProfileEnabled()) {
+      long num = 0;
+      for (int k = 0; k < m_src.numLoad; ++k)
+        num += m_info[k].numRefine;
+      ProfileStop(Prof_Prob, num);
+    }
+
     // Debug mode: Entry
     if (par->logDebug())
       Log(Log_0, " <== EXIT: Catalogue::compute_prob (status=%d)",
@@ -2132,7 +2286,12 @@ Status Catalogue::catch22(Parameters *par, Status status) {
           }
         }
 
+        // Start iteration profiling
+        ProfileStart(Prof_Catch22);
+        TraceBegin("catch22", "catch22 iteration");
+
         // Re-compute PROB_POST_SINGLE for all sources
+        long num = 0;
         for (int k = 0; k < m_src.numLoad; ++k) {
 
           // Update in-memory catalogue
@@ -2183,6 +2342,9 @@ Status Catalogue::catch22(Parameters *par, Status status) {
               break;
             m_info[k].numRefine++;
           }
+          m_info[k].numSweep = (par->m_sweepPrior.size() > 0)
+                               ? m_info[k].numSelect : m_info[k].numRefine;
+          num += m_info[k].numRefine;
 
         } // endfor: looped over all sources
         if (status != STATUS_OK)
@@ -2206,8 +2368,19 @@ Status Catalogue::catch22(Parameters *par, Status status) {
           break;
         }
 
+        // Stop iteration profiling
+        TraceEnd("catch22", "catch22 iteration",
+                 "\"iter\": %d, \"prior\": %.6e, \"numRefine\": %ld",
+                 m_iter+1, m_prior, num);
+        ProfileStop(Prof_Catch22, num);
+
       } // endfor: looped over posterior probability iterations
 
+      // Stop iteration profiling (in case that the iteration was interrupted)
+      if (status != STATUS_OK)
+        TraceEnd("catch22", "catch22 iteration", NULL);
+      ProfileStop(Prof_Catch22, 0);
+
       // Signal if boundary was hit
       if (hit_boundary) {
         if (par->logNormal()) {
@@ -2259,7 +2432,12 @@ Status Catalogue::catch22(Parameters *par, Status status) {
  * counterparts that survive a given step. The first elements is the number
  * of counterpart candidates that came out of the filter step. The following
  * elements are the number of counterpart that survived the various selection
- * criteria. m_src_cpts contains for each source the number of counterparts
+ * criteria. Criteria of the selection step (SelNN) are counted in the
+ * selection step, criteria of the reselection step (ResNN) in the
+ * reselection step, which follows the refine step (see
+ * Parameters::plan_select). The numbers therefore only decrease within a
+ * step, and a ResNN column may exceed the column to its left if it was
+ * given before a criterion of the selection step. m_src_cpts contains for each source the number of counterparts
  * that survived the refine step. The names of these counterparts and their
  * associated probabilities are stored in the vector m_cpt_names.
  ******************************************************************************/
@@ -2288,7 +2466,10 @@ Status Catalogue::dump_results(Parameters *par, Status status) {
       char add[256];
       char select[256] = "";
       for (int iSel = 0; iSel < m_num_Sel; ++iSel) {
-        sprintf(add, " Sel%2.2d", iSel+1);
+        if (iSel < (int)par->m_selectPost.size() && par->m_selectPost[iSel])
+          sprintf(add, " Res%2.2d", iSel+1);
+        else
+          sprintf(add, " Sel%2.2d", iSel+1);
         strcat(select, add);
       }
       sprintf(add, " Select");
@@ -2301,6 +2482,9 @@ Status Catalogue::dump_results(Parameters *par, Status status) {
       strcat(select, add);
 
       // Dump header
+      if (par->m_numSelectPost > 0)
+        Log(Log_2, " (SelNN: selection step, ResNN: reselection step after"
+            " refine)");
       Log(Log_2, "                                      Filter%s", select);
 
       // Loop over all sources
@@ -2311,12 +2495,12 @@ Status Catalogue::dump_results(Parameters *par, Status status) {
         src = &(m_src.object[iSrc]);
 
         // Build selection string
-        sprintf(select, " %6d", m_info[iSrc].numFilter);
+        sprintf(select, " %6d", m_info[iSrc].numFilter + m_info[iSrc].numPrune);
         for (int iSel = 0; iSel < m_num_Sel; ++iSel) {
           sprintf(add, " %5d", m_cpt_stat[iSrc*(m_num_Sel+1) + iSel+1]);
           strcat(select, add);
         }
-        sprintf(add, " %6d", m_info[iSrc].numSelect);
+        sprintf(add, " %6d", m_info[iSrc].numSelect + m_info[iSrc].numPrune);
         strcat(select, add);
         sprintf(add, " %6d", m_info[iSrc].numRefine);
         strcat(select, add);
@@ -2327,7 +2511,7 @@ Status Catalogue::dump_results(Parameters *par, Status status) {
 
         // Dump information
         Log(Log_2, " Source %5d %20s : %s %s",
-            iSrc+1, src->name.c_str(), select, m_cpt_names[iSrc].c_str());
+            iSrc+1, src->name, select, m_cpt_names[iSrc].c_str());
 
         // Collect number of associated sources
         if (m_info[iSrc].numFinalSel > 0)
@@ -2386,6 +2570,210 @@ Status Catalogue::dump_results(Parameters *par, Status status) {
 }
 
 
+/**************************************************************************//**
+ * @brief Associate all sources of the source catalogue
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] status Error status.
+ *
+ * Performs the counterpart association for all sources, including the
+ * catch-22 iterations, up to the final association probabilities. This
+ * method expects that both catalogues have been loaded and that the
+ * in-memory FITS catalogue has been created.
+ ******************************************************************************/
+Status Catalogue::associate_sources(Parameters *par, Status status) {
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::associate_sources");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Allocate source information
+      m_info = new SourceInfo[m_src.numLoad];
+      if (m_info == NULL) {
+        status = STATUS_MEM_ALLOC;
+        if (par->logTerse())
+          Log(Error_2, "%d : Memory allocation failure.", (Status)status);
+        continue;
+      }
+
+      // Initialise source information
+      for (int iSrc = 0; iSrc < m_src.numLoad; ++iSrc) {
+        m_info[iSrc].iSrc         = iSrc;
+        m_info[iSrc].info         = &(m_src.object[iSrc]);
+        m_info[iSrc].numFilter    = 0;
+        m_info[iSrc].numPrune     = 0;
+        m_info[iSrc].numPruneRing = 0;
+        m_info[iSrc].numSelect    = 0;
+        m_info[iSrc].numRefine    = 0;
+        m_info[iSrc].numSweep     = 0;
+        m_info[iSrc].numClaimed   = 0;
+        m_info[iSrc].numFinalSel  = 0;
+        m_info[iSrc].cc           = NULL;
+        m_info[iSrc].filter_rad   = 0.0;
+        m_info[iSrc].ring_rad_min = 0.0;
+        m_info[iSrc].ring_rad_max = 0.0;
+        m_info[iSrc].omega        = 0.0;
+      }
+
+      // Allocate list of selected counterparts
+      m_cpt_sel = new int[m_cpt.numLoad];
+      if (m_cpt_sel == NULL) {
+        status = STATUS_MEM_ALLOC;
+        if (par->logTerse())
+          Log(Error_2, "%d : Memory allocation failure.", (Status)status);
+        continue;
+      }
+
+      // Determine number of quantity selection criteria
+      m_num_Sel = par->m_select.size();
+
+      // Set vectors dimensions
+      m_cpt_names = std::vector<std::string>(m_src.numLoad);
+
+      // Allocate selection statistics
+      m_cpt_stat = new int[m_src.numLoad*(m_num_Sel+1)];
+      if (m_cpt_stat == NULL) {
+        status = STATUS_MEM_ALLOC;
+        if (par->logTerse())
+          Log(Error_2, "%d : Memory allocation failure.", (Status)status);
+        continue;
+      }
+      for (int iSrc = 0; iSrc < m_src.numLoad; ++iSrc) {
+        for (int iSel = 0; iSel <= m_num_Sel; ++iSel)
+          m_cpt_stat[iSrc*(m_num_Sel+1) + iSel] = 0;
+      }
+
+      // Build counterpart declination index
+      status = cid_index(par, status);
+      if (status != STATUS_OK)
+        continue;
+
+      // Set source processing order
+      std::vector<int> order;
+      status = cid_order(par, order, status);
+      if (status != STATUS_OK)
+        continue;
+
+      // Open checkpoint file and optionally restore completed sources
+      std::vector<char> done;
+      std::vector<int>  pending;
+      status = chk_open(par, done, status);
+      if (status != STATUS_OK)
+        continue;
+
+      // Get plausible counterpart candidates and compute PROB_POST_SINGLE
+      // for them in the requested processing order. Sources restored from
+      // the checkpoint are skipped and completed sources are checkpointed
+      // every chkInterval sources.
+      TraceBegin("build", "cid_source loop");
+      for (int k = 0; k < m_src.numLoad; ++k) {
+        int iSrc = order[k];
+        if (done[iSrc])
+          continue;
+        status = cid_source(par, &(m_info[iSrc]), status);
+        if (status != STATUS_OK)
+          break;
+        pending.push_back(iSrc);
+        if ((long)pending.size() >= par->m_chkInterval)
+          status = chk_write(par, pending, status);
+      }
+      status = chk_write(par, pending, status);
+      chk_close();
+      TraceEnd("build", "cid_source loop", "\"sources\": %ld", m_src.numLoad);
+      if (status != STATUS_OK)
+        continue;
+
+      // Shard workers stop after the per-source steps. The catalogue level
+      // probabilities are computed by the merge step over all shards.
+      if (par->shardWorker())
+        continue;
+
+      // Compute probabilities for source catalogue association
+      TraceBegin("build", "compute_prob_post_cat");
+      status = compute_prob_post_cat(par, status);
+      TraceEnd("build", "compute_prob_post_cat", NULL);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to compute catalogue association"
+              " probabilities.", (Status)status);
+        continue;
+      }
+
+      // Compute probabilities for unique source catalogue association
+      TraceBegin("build", "compute_prob_post");
+      status = compute_prob_post(par, status);
+      TraceEnd("build", "compute_prob_post", NULL);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to compute unique catalogue association"
+              " probabilities.", (Status)status);
+        continue;
+      }
+
+      // Perform catch-22 iterations
+      TraceBegin("build", "catch22");
+      status = catch22(par, status);
+      TraceEnd("build", "catch22", NULL);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to perform catch-22 iterations.",
+              (Status)status);
+        continue;
+      }
+
+      // Compute association probabilities
+      TraceBegin("build", "compute_prob");
+      status = compute_prob(par, status);
+      TraceEnd("build", "compute_prob", NULL);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to compute association probabilities.",
+              (Status)status);
+        continue;
+      }
+
+      // Optionally sweep prior probabilities and thresholds
+      TraceBegin("build", "sweep");
+      status = sweep(par, status);
+      TraceEnd("build", "sweep", NULL);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to sweep prior probabilities and"
+              " thresholds.", (Status)status);
+        continue;
+      }
+
+      // Optionally compute reliability and completeness curves
+      TraceBegin("build", "curves");
+      status = curves(par, status);
+      TraceEnd("build", "curves", NULL);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to compute reliability and completeness"
+              " curves.", (Status)status);
+        continue;
+      }
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::associate_sources (status=%d)",
+          status);
+
+    // Return status
+    return status;
+
+}
+
+
 /**************************************************************************//**
  * @brief Build counterpart catalogue
  *
@@ -2397,6 +2785,8 @@ Status Catalogue::dump_results(Parameters *par, Status status) {
  * \verbatim
  * build
  *   |
+ *   +-- cache_get (take output catalogue from result cache)
+ *   |
  *   +-- get_input_descriptor (get source catalogue input descriptior)
  *   |
  *   +-- get_input_descriptor (get counterpart catalogue input descriptior)
@@ -2410,6 +2800,8 @@ Status Catalogue::dump_results(Parameters *par, Status status) {
  *   |   +-- cid_filter (filter step)
  *   |   |   |
  *   |   |   +-- get_input_catalogue (get counterpart catalogue)
+ *   |   |   |
+ *   |   |   +-- cid_prune (drop candidates below probability threshold)
  *   |   |
  *   |   +-- cid_select (select counterparts)
  *   |   |   |
@@ -2437,6 +2829,20 @@ Status Catalogue::dump_results(Parameters *par, Status status) {
  *   |
  *   +-- compute_prob (compute association probability)
  *   |
+ *   +-- sweep (sweep prior probabilities and thresholds)
+ *   |   +-- sweep_claim (sort claimable probabilities)
+ *   |
+ *   +-- curves (reliability and completeness curves)
+ *   |   +-- sweep_claim (sort claimable probabilities)
+ *   |
+ *   +-- montecarlo (associate shifted source catalogues)
+ *   |   |
+ *   |   N-- mc_worker (worker process)
+ *   |       |
+ *   |       N-- mc_shift (shift sources)
+ *   |       |
+ *   |       N-- associate_sources (associate shifted sources)
+ *   |
  *   N-- cfits_add (add counterpart candidates to output catalogue)
  *   |
  *   +-- cfits_eval (evaluate output catalogue quantities)
@@ -2447,13 +2853,20 @@ Status Catalogue::dump_results(Parameters *par, Status status) {
  *   |
  *   +-- cfits_set_pars (set run parameter keywords)
  *   |
+ *   +-- cfits_add_table (add sweep, curve and Monte Carlo tables)
+ *   |
  *   +-- cfits_save (save output catalogue)
  *   |
+ *   +-- cache_put (store output catalogue in result cache)
+ *   |
  *   +-- dump_results (dump results)
  * \endverbatim
  ******************************************************************************/
 Status Catalogue::build(Parameters *par, Status status) {
 
+    // Declare local variables
+    std::string cacheKey;
+
     // Debug mode: Entry
     if (par->logDebug())
       Log(Log_0, " ==> ENTRY: Catalogue::build");
@@ -2465,6 +2878,15 @@ Status Catalogue::build(Parameters *par, Status status) {
       if (status != STATUS_OK)
         continue;
 
+      // Optionally take output catalogue from result cache (shard workers
+      // write no output catalogue)
+      int hit = 0;
+      if (!par->shardWorker()) {
+        status = cache_get(par, cacheKey, hit, status);
+        if (status != STATUS_OK || hit)
+          continue;
+      }
+
       // Dump header
       if (par->logNormal()) {
         Log(Log_2, "");
@@ -2473,6 +2895,7 @@ Status Catalogue::build(Parameters *par, Status status) {
       }
 
       // Get input catalogue descriptors
+      TraceBegin("build", "get_input_descriptor");
       status = get_input_descriptor(par, par->m_srcCatName, &m_src, status);
       if (status != STATUS_OK) {
         if (par->logTerse())
@@ -2481,6 +2904,7 @@ Status Catalogue::build(Parameters *par, Status status) {
         continue;
       }
       status = get_input_descriptor(par, par->m_cptCatName, &m_cpt, status);
+      TraceEnd("build", "get_input_descriptor", NULL);
       if (status != STATUS_OK) {
         if (par->logTerse())
           Log(Error_2, "%d : Unable to load counterpart catalogue '%s'"
@@ -2499,42 +2923,12 @@ Status Catalogue::build(Parameters *par, Status status) {
       }
 
       // Optionally read counterpart density map
-      if (par->m_cptDensFile.length() > 0) {
-        m_has_density = 0;
-        if (par->logNormal()) {
-          Log(Log_2, "");
-          Log(Log_2, "Read counterpart catalogue density map:");
-          Log(Log_2, "=======================================");
-        }
-        try {
-          m_density     = GHealpix(par->m_cptDensFile);
-          m_has_density = 1;
-          if (par->logNormal()) {
-            Log(Log_2, " Filename .........................: %s", par->m_cptDensFile.c_str());
-            Log(Log_2, " Nside (number of divisions) ......: %d", m_density.nside());
-          }
-        }
-        catch (std::exception &e) {
-          if (par->logTerse()) {
-            Log(Warning_3, "Error occured while loading file '%s' (standard exception)",
-                            par->m_cptDensFile.c_str());
-          }
-        }
-        catch (std::string str) {
-          if (par->logTerse()) {
-            Log(Warning_3, "Error occured while loading file '%s': %s.",
-                            par->m_cptDensFile.c_str(), str.c_str());
-          }
-        }
-        catch (...) {
-          if (par->logTerse()) {
-            Log(Warning_3, "Error occured while loading file '%s' (unknown exception)",
-                            par->m_cptDensFile.c_str());
-          }
-        }
-      }
+      status = get_density_map(par, status);
+      if (status != STATUS_OK)
+        continue;
 
       // Create FITS catalogue in memory
+      TraceBegin("build", "cfits_create");
       status = cfits_create(&m_memFile, "mem://gtsrcid", par, status);
       if (status != STATUS_OK) {
         if (par->logTerse())
@@ -2543,9 +2937,11 @@ Status Catalogue::build(Parameters *par, Status status) {
         continue;
       }
 
-      // Create FITS output catalogue on disk
-      status = cfits_create(&m_outFile, (char*)par->m_outCatName.c_str(), par,
-                            status);
+      // Create FITS output catalogue on disk (not needed by shard workers)
+      if (!par->shardWorker())
+        status = cfits_create(&m_outFile, (char*)par->m_outCatName.c_str(),
+                              par, status);
+      TraceEnd("build", "cfits_create", NULL);
       if (status != STATUS_OK) {
         if (par->logTerse())
           Log(Error_2, "%d : Unable to create FITS output catalogue '%s'.",
@@ -2561,7 +2957,9 @@ Status Catalogue::build(Parameters *par, Status status) {
       }
 
       // Load source catalogue
+      TraceBegin("build", "get_input_catalogue");
       status = get_input_catalogue(par, &m_src, par->m_srcPosError, status);
+      TraceEnd("build", "get_input_catalogue", "\"catalogue\": \"source\"");
       if (status != STATUS_OK) {
         if (par->logTerse())
           Log(Error_2, "%d : Unable to load source catalogue '%s' data.",
@@ -2586,7 +2984,9 @@ Status Catalogue::build(Parameters *par, Status status) {
       }
 
       // Load counterpart catalogue
+      TraceBegin("build", "get_input_catalogue");
       status = get_input_catalogue(par, &m_cpt, par->m_cptPosError, status);
+      TraceEnd("build", "get_input_catalogue", "\"catalogue\": \"counterpart\"");
       if (status != STATUS_OK) {
         if (par->logTerse())
           Log(Error_2, "%d : Unable to load counterpart catalogue '%s' data.",
@@ -2610,104 +3010,38 @@ Status Catalogue::build(Parameters *par, Status status) {
           Log(Log_2, " Counterpart catalogue contains %d sources.", m_cpt.numLoad);
       }
 
-      // Allocate source information
-      m_info = new SourceInfo[m_src.numLoad];
-      if (m_info == NULL) {
-        status = STATUS_MEM_ALLOC;
-        if (par->logTerse())
-          Log(Error_2, "%d : Memory allocation failure.", (Status)status);
-        continue;
-      }
-
-      // Initialise source information
-      for (int iSrc = 0; iSrc < m_src.numLoad; ++iSrc) {
-        m_info[iSrc].iSrc         = iSrc;
-        m_info[iSrc].info         = &(m_src.object[iSrc]);
-        m_info[iSrc].numFilter    = 0;
-        m_info[iSrc].numSelect    = 0;
-        m_info[iSrc].numRefine    = 0;
-        m_info[iSrc].numClaimed   = 0;
-        m_info[iSrc].numFinalSel  = 0;
-        m_info[iSrc].cc           = NULL;
-        m_info[iSrc].filter_rad   = 0.0;
-        m_info[iSrc].ring_rad_min = 0.0;
-        m_info[iSrc].ring_rad_max = 0.0;
-        m_info[iSrc].omega        = 0.0;
-      }
-
-      // Allocate list of selected counterparts
-      m_cpt_sel = new int[m_cpt.numLoad];
-      if (m_cpt_sel == NULL) {
-        status = STATUS_MEM_ALLOC;
-        if (par->logTerse())
-          Log(Error_2, "%d : Memory allocation failure.", (Status)status);
-        continue;
-      }
-
-      // Determine number of quantity selection criteria
-      m_num_Sel = par->m_select.size();
-
-      // Set vectors dimensions
-      m_cpt_names = std::vector<std::string>(m_src.numLoad);
-
-      // Allocate selection statistics
-      m_cpt_stat = new int[m_src.numLoad*(m_num_Sel+1)];
-      if (m_cpt_stat == NULL) {
-        status = STATUS_MEM_ALLOC;
-        if (par->logTerse())
-          Log(Error_2, "%d : Memory allocation failure.", (Status)status);
-        continue;
-      }
-      for (int iSrc = 0; iSrc < m_src.numLoad; ++iSrc) {
-        for (int iSel = 0; iSel <= m_num_Sel; ++iSel)
-          m_cpt_stat[iSrc*(m_num_Sel+1) + iSel] = 0;
-      }
-
-      // Get plausible counterpart candidates and compute PROB_POST_SINGLE
-      // for them
-      for (int iSrc = 0; iSrc < m_src.numLoad; ++iSrc)
-        status = cid_source(par, &(m_info[iSrc]), status);
+      // Associate all sources
+      status = associate_sources(par, status);
       if (status != STATUS_OK)
         continue;
 
-      // Compute probabilities for source catalogue association
-      status = compute_prob_post_cat(par, status);
-      if (status != STATUS_OK) {
-        if (par->logTerse())
-          Log(Error_2, "%d : Unable to compute catalogue association"
-              " probabilities.", (Status)status);
-        continue;
-      }
-
-      // Compute probabilities for unique source catalogue association
-      status = compute_prob_post(par, status);
-      if (status != STATUS_OK) {
+      // Shard workers only write their checkpoint file
+      if (par->shardWorker()) {
         if (par->logTerse())
-          Log(Error_2, "%d : Unable to compute unique catalogue association"
-              " probabilities.", (Status)status);
+          Log(Log_1, " Shard %d of %d written to checkpoint; run shard=-1"
+              " to merge.", par->m_shard, par->m_numShards);
         continue;
       }
 
-      // Perform catch-22 iterations
-      status = catch22(par, status);
+      // Optionally associate shifted source catalogues
+      TraceBegin("build", "montecarlo");
+      status = montecarlo(par, status);
+      TraceEnd("build", "montecarlo", "\"realisations\": %d", par->m_mcNum);
       if (status != STATUS_OK) {
         if (par->logTerse())
-          Log(Error_2, "%d : Unable to perform catch-22 iterations.",
-              (Status)status);
+          Log(Error_2, "%d : Unable to estimate false associations from"
+              " shifted source catalogues.", (Status)status);
         continue;
       }
 
-      // Compute association probabilities
-      status = compute_prob(par, status);
-      if (status != STATUS_OK) {
-        if (par->logTerse())
-          Log(Error_2, "%d : Unable to compute association probabilities.",
-              (Status)status);
-        continue;
-      }
+      // Start output profiling
+      ProfileStart(Prof_Output);
+      TraceBegin("build", "output");
 
       // Save claimed counterpart candidates for all sources
+      long numOut = 0;
       for (int iSrc = 0; iSrc < m_src.numLoad; ++iSrc) {
+        numOut += m_info[iSrc].numClaimed;
         status = cfits_add(m_outFile, par, &(m_info[iSrc]), 
                            m_info[iSrc].numClaimed, status);
         if (status != STATUS_OK) {
@@ -2782,6 +3116,40 @@ Status Catalogue::build(Parameters *par, Status status) {
         continue;
       }
 
+      // Write sweep table
+      if (m_sweep.size() > 0) {
+        status = cfits_add_table(m_outFile, par, (char*)OUTCAT_SWEEP_EXT_NAME,
+                                 m_sweep_names, m_sweep, status);
+        if (status != STATUS_OK) {
+          if (par->logTerse())
+            Log(Error_2, "%d : Unable to write sweep table.", (Status)status);
+          continue;
+        }
+      }
+
+      // Write curve table
+      if (m_curve.size() > 0) {
+        status = cfits_add_table(m_outFile, par, (char*)OUTCAT_CURVES_EXT_NAME,
+                                 m_curve_names, m_curve, status);
+        if (status != STATUS_OK) {
+          if (par->logTerse())
+            Log(Error_2, "%d : Unable to write curve table.", (Status)status);
+          continue;
+        }
+      }
+
+      // Write Monte Carlo table
+      if (m_mc.size() > 0) {
+        status = cfits_add_table(m_outFile, par, (char*)OUTCAT_MC_EXT_NAME,
+                                 m_mc_names, m_mc, status);
+        if (status != STATUS_OK) {
+          if (par->logTerse())
+            Log(Error_2, "%d : Unable to write Monte Carlo table.",
+                (Status)status);
+          continue;
+        }
+      }
+
       // Save output catalogue counterparts
       status = cfits_save(m_outFile, par, status);
       if (status != STATUS_OK) {
@@ -2791,6 +3159,13 @@ Status Catalogue::build(Parameters *par, Status status) {
         continue;
       }
 
+      // Store output catalogue in result cache
+      status = cache_put(par, cacheKey, status);
+
+      // Stop output profiling
+      TraceEnd("build", "output", "\"rows\": %ld", numOut);
+      ProfileStop(Prof_Output, numOut);
+
       // Dump counterpart results
       if (par->logTerse()) {
         status = dump_results(par, status);
@@ -151,23 +151,34 @@ Replace header information with CVS typeset information.
 
 /* Includes _________________________________________________________________ */
 #include <cfloat>
+#include <cstdio>
+#include <deque>
+#include <utility>
 #include "sourceIdentify.h"
 #include "Parameters.h"
 #include "catalogAccess/catalog.h"
 #include "catalogAccess/quantity.h"
 #include "fitsio.h"
 #include "GHealpix.h"
+#include "Associate.h"
 
 /* Namespace definition _____________________________________________________ */
 namespace sourceIdentify {
 
 /* Definitions ______________________________________________________________ */
+#ifndef OBJECT_COMPACT
+#define OBJECT_COMPACT                0   // Single precision error ellipses
+#endif                                    // (select with -DOBJECT_COMPACT=1)
+//
 #define OUTCAT_PRE_CHAR               '@'
 #define OUTCAT_PRE_STRING             "@"
 //
 #define OUTCAT_MAX_STRING_LEN         8192
 #define OUTCAT_MAX_KEY_LEN            256
 #define OUTCAT_EXT_NAME               "GLAST_CAT"
+#define OUTCAT_SWEEP_EXT_NAME         "SWEEP"
+#define OUTCAT_CURVES_EXT_NAME        "CURVES"
+#define OUTCAT_MC_EXT_NAME            "MCFALSE"
 //
 #define OUTCAT_NUM_GENERIC            23
 //
@@ -175,6 +186,7 @@ namespace sourceIdentify {
 #define OUTCAT_COL_ID_NAME            "ID"
 #define OUTCAT_COL_ID_FORM            "20A"
 #define OUTCAT_COL_ID_UCD             "ID_MAIN"
+#define OUTCAT_COL_ID_FMT             "CC_%5.5d_%5.5d"
 //
 #define OUTCAT_COL_RA_COLNUM          2
 #define OUTCAT_COL_RA_NAME            "RAJ2000"
@@ -313,10 +325,14 @@ namespace sourceIdentify {
 /* Class constants __________________________________________________________ */
 const double c_filter_maxsep  = 4.0;     //!< Minimum filter radius
 const double c_prob_min       = 1.0e-20; //!< Minimum probability threshold
+const double c_prune_margin   = 1.0e-3;  //!< Log-probability margin for pruning
 const int    c_iter_max       = 10;      //!< Maximum number of catch-22 iterations
 const double c_prob_prior     = 0.1;     //!< Initial catch-22 prior
 const double c_prob_prior_min = 1.0e-20; //!< Minimum catch-22 prior
 const double c_prob_prior_max = 1.00;    //!< Maximum catch-22 prior
+const long   c_cc_block       = 65536;   //!< Candidate arena block size
+const long   c_stream_block   = 1024;    //!< Stream source block size
+const int    c_mc_tries       = 100;     //!< Maximum draws per shifted source
 //const double c_erposabs       = 0.0;     //!< Default absolute position error
 const double c_erposabs       = 1.0e-4;  //!< Small position error to avoid round-off
 
@@ -375,12 +391,6 @@ typedef enum {                  // Position error probability
 } PosErrorProb;
 
 typedef struct {                // Counterpart candidate object information
-  std::string id;               //!< Unique identifier
-  double      pos_eq_ra;        //!< Right Ascension (deg)
-  double      pos_eq_dec;       //!< Declination (deg)
-  double      pos_err_maj;      //!< 95% uncertainty ellipse major axis (deg)
-  double      pos_err_min;      //!< 95% uncertainty ellipse minor axis (deg)
-  double      pos_err_ang;      //!< 95% uncertainty ellipse PA (deg)
   double      prob;             //!< Counterpart probability
   //
   long        index;            //!< Index of CCs in CPT catalogue
@@ -399,28 +409,36 @@ typedef struct {                // Counterpart candidate object information
   double      likrat;           //!< Likelihood ratio
   double      rho;              //!< Local counterpart density
   double      fom;              //!< Figure of merit
-  double      prob_prod1;       //!< Probability product 1 (working variable)
-  double      prob_prod2;       //!< Probability product 2 (working variable)
-  double      prob_norm;        //!< Probability normalization (working variable)
   int         likrat_div;       //!< Signals LR divergence
 } CCElement;
 
+#if OBJECT_COMPACT
+typedef float  ObjError;              // Error ellipse type
+typedef char   ObjValid;              // Position validity type
+#else
+typedef double ObjError;              // Error ellipse type
+typedef int    ObjValid;              // Position validity type
+#endif
+
 typedef struct {                      // Catalogue object information
-  std::string             name;         //!< Object name
-  int                     pos_valid;    //!< Position validity (1=valid)
+  const char             *name;         //!< Object name (in name pool)
   double                  pos_eq_ra;    //!< Right Ascension (deg)
   double                  pos_eq_dec;   //!< Declination (deg)
-  double                  pos_err_maj;  //!< Position error major axis
-  double                  pos_err_min;  //!< Position error minor axis
-  double                  pos_err_ang;  //!< Position error angle
+  ObjError                pos_err_maj;  //!< Position error major axis
+  ObjError                pos_err_min;  //!< Position error minor axis
+  ObjError                pos_err_ang;  //!< Position error angle
+  ObjValid                pos_valid;    //!< Position validity (1=valid)
 } ObjectInfo;
 
 typedef struct {                      // Source information
   int                     iSrc;         //!< Source index
   ObjectInfo             *info;         //!< Source information
   int                     numFilter;    //!< Number of filter step candidates
+  int                     numPrune;     //!< Number of pruned candidates
+  int                     numPruneRing; //!< Pruned candidates in density ring
   int                     numSelect;    //!< Number of selection step candidates
   int                     numRefine;    //!< Number of refine step candidates
+  int                     numSweep;     //!< Number of prior sweep candidates
   int                     numClaimed;   //!< Number of claimed candidates
   int                     numFinalSel;  //!< Number of finally selected candidates
   CCElement              *cc;           //!< List of counterpart candidates
@@ -457,6 +475,8 @@ typedef struct {                      // Input catalogue
   double                  e_pos_scale;  //!< Position error scaling
   double                  erposabs;     //!< Absolute position error
   ObjectInfo             *object;       //!< Object information
+  std::vector<char>       names;        //!< Object name pool
+  const AssocCatalogue   *table;        //!< In-memory catalogue (or NULL)
 } InCatalogue;
 
 class Catalogue {
@@ -468,6 +488,16 @@ public:
 
   // Public methods
   Status build(Parameters *par, Status status);
+  Status associate(Parameters *par, const AssocCatalogue &src,
+                   const AssocCatalogue &cpt, AssocResult &res,
+                   Status status);
+  Status load(Parameters *par, Status status);
+  Status query(Parameters *par, const AssocCatalogue &src, AssocResult &res,
+               Status status);
+  Status stream(Parameters *par, const AssocCatalogue &src, AssocResult &prov,
+                std::vector<int> &update, AssocResult &res, Status status);
+  const char *object_name(long iCpt);       // Inline
+  const char *source_name(long iSrc);       // Inline
 
   // Private methods
 private:
@@ -480,17 +510,59 @@ private:
                               InCatalogue *in,  Status status);
   Status get_input_catalogue(Parameters *par, InCatalogue *in, double posErr,
                              Status status);
+  Status get_input_table(Parameters *par, InCatalogue *in,
+                         const AssocCatalogue *table, double posErr,
+                         Status status);
+  Status get_output_table(Parameters *par, fitsfile *fptr, AssocResult &res,
+                          Status status);
+  Status get_results(Parameters *par, AssocResult &res, Status status,
+                     const std::vector<int> *srcs = NULL);
+  void   get_candidates(SourceInfo *src, int num, AssocResult &res);
+  void   clear_sources(void);
+  Status stream_init(Parameters *par, Status status);
+  Status stream_grow(Parameters *par, long num, Status status);
+  Status stream_post(Parameters *par, int first, std::vector<int> &update,
+                     Status status);
+  Status chk_open(Parameters *par, std::vector<char> &done, Status status);
+  Status chk_write(Parameters *par, std::vector<int> &pending, Status status);
+  void   chk_close(void);
+  Status chk_read(Parameters *par, std::string filename,
+                  std::vector<char> &done, long &numDone, long &offset,
+                  int &valid, Status status,
+                  const std::vector<int> *map = NULL);
+  Status chk_prev(Parameters *par, std::vector<char> &done, Status status);
+  Status chk_shard(Parameters *par, std::vector<char> &done, long &num,
+                   Status status);
+  std::string chk_filename(Parameters *par, int shard);
+  std::string chk_signature(Parameters *par, const std::string &srcCatName);
+  std::string cache_file_hash(const std::string &filename);
+  Status cache_get(Parameters *par, std::string &key, int &hit,
+                   Status status);
+  Status cache_put(Parameters *par, const std::string &key, Status status);
+  Status get_density_map(Parameters *par, Status status);
   Status dump_descriptor(Parameters *par, InCatalogue *in, Status status);
+  Status associate_sources(Parameters *par, Status status);
   Status compute_prob_post_cat(Parameters *par, Status status, int quiet = 0);
   Status compute_prob_post(Parameters *par, Status status, int quiet = 0);
   Status compute_prob(Parameters *par, Status status);
   Status catch22(Parameters *par, Status status);
+  Status sweep(Parameters *par, Status status);
+  Status curves(Parameters *par, Status status);
+  double sweep_claim(Parameters *par, std::vector<double> &prob,
+                     std::vector<double> &cum);
+  Status montecarlo(Parameters *par, Status status);
+  Status mc_worker(Parameters *par, int job, int numJobs,
+                   std::vector<double> &thresholds, int fd, Status status);
+  void   mc_shift(Parameters *par, int iter,
+                  std::vector<ObjectInfo> &orig,
+                  std::vector<std::pair<double,int> > &zone);
   Status dump_results(Parameters *par, Status status);
   //
   // Low-level source identification methods
   // ---------------------------------------
   Status      cid_source(Parameters *par, SourceInfo *src, Status status);
   Status      cid_filter(Parameters *par, SourceInfo *src, Status status);
+  Status      cid_prune(Parameters *par, SourceInfo *src, Status status);
   Status      cid_select(Parameters *par, SourceInfo *src, Status status);
   Status      cid_refine(Parameters *par, SourceInfo *src, Status status);
   Status      cid_reselect(Parameters *par, SourceInfo *src, Status status);
@@ -499,11 +571,19 @@ private:
   Status      cid_prob_chance(Parameters *par, SourceInfo *src, Status status);
   Status      cid_prob_prior(Parameters *par, SourceInfo *src, Status status);
   Status      cid_prob_post_single(Parameters *par, SourceInfo *src, Status status);
+  void        cid_post_single(Parameters *par, CCElement *cc);
   Status      cid_prob(Parameters *par, SourceInfo *src, Status status);
+  double      cid_prob_unique(SourceInfo *src, double *prod1, double *prod2);
+  Status      cid_claim(Parameters *par, SourceInfo *src, Status status);
   Status      cid_local_density(Parameters *par, SourceInfo *src, Status status);
   Status      cid_global_density(Parameters *par, SourceInfo *src, Status status);
   Status      cid_map_density(Parameters *par, SourceInfo *src, Status status);
   Status      cid_sort(Parameters *par, SourceInfo *src, int num, Status status);
+  CCElement  *cid_alloc(int num);
+  void        cid_trim(SourceInfo *src, int num);
+  Status      cid_index(Parameters *par, Status status);
+  Status      cid_order(Parameters *par, std::vector<int> &order,
+                        Status status);
   Status      cid_dump(Parameters *par, SourceInfo *src, Status status);
   std::string cid_assign_src_name(std::string name, int row);
   //
@@ -514,7 +594,8 @@ private:
   Status cfits_clear(fitsfile *fptr, Parameters *par, Status status);
   Status cfits_add(fitsfile *fptr, Parameters *par, SourceInfo *src, int num,
                    Status status);
-  Status cfits_eval(fitsfile *fptr, Parameters *par, Status status);
+  Status cfits_eval(fitsfile *fptr, Parameters *par, Status status,
+                    int lazy = 0);
   Status cfits_eval_column(fitsfile *fptr, Parameters *par, std::string column,
                            std::string formula, Status status);
   Status cfits_eval_regular_expression(fitsfile *fptr, Parameters *par,
@@ -529,10 +610,19 @@ private:
                                      std::string column_arg, int nargs,
                                      Status status);
   Status cfits_eval_clear(fitsfile *fptr, Parameters *par, Status status);
+  Status cfits_eval_plan(fitsfile *fptr, Parameters *par,
+                         const std::vector<int> &ids,
+                         std::vector<std::vector<double> > &res,
+                         std::vector<FormulaType> &types, Status status);
+  Status cfits_eval_formula(fitsfile *fptr, Parameters *par,
+                            std::string column, std::string formula, int id,
+                            std::vector<double> &res, Status status);
+  Status cfits_check_plan(fitsfile *fptr, Parameters *par, std::string formula,
+                          const std::vector<double> &res, Status status);
   Status cfits_update(fitsfile *fptr, Parameters *par, SourceInfo *src, int num,
                       Status status);
   Status cfits_select(fitsfile *fptr, Parameters *par, SourceInfo *src,
-                      Status status);
+                      Status status, int post);
   Status cfits_select(fitsfile *fptr, Parameters *par, Status status);
   Status cfits_collect(fitsfile *fptr, Parameters *par, std::vector<int> &stat,
                        Status status);
@@ -543,6 +633,9 @@ private:
   Status cfits_set_col(fitsfile *fptr, Parameters *par, std::string colname,
                        std::vector<double> &col, Status status);
   Status cfits_set_pars(fitsfile *fptr, Parameters *par, Status status);
+  Status cfits_add_table(fitsfile *fptr, Parameters *par, char *extname,
+                         std::vector<std::string> &names,
+                         std::vector<std::vector<double> > &cols, Status status);
   Status cfits_save(fitsfile *fptr, Parameters *par, Status status);
 private:
   //
@@ -562,11 +655,31 @@ private:
   // Counterpart working vector
   int                     *m_cpt_sel;        //!< List of selected counterparts
   //
+  // Counterpart declination index
+  std::vector<int>         m_cpt_zone;       //!< Counterparts sorted by Dec.
+  std::vector<double>      m_cpt_zone_dec;   //!< Sorted declinations
+  std::vector<double>      m_cpt_zone_ra;    //!< Right Ascensions in Dec. order
+  long                     m_cpt_no_pos;     //!< Counterparts without position
+  //
+  // Counterpart candidate arena
+  std::vector<CCElement*>  m_cc_block;       //!< Arena blocks
+  long                     m_cc_size;        //!< Size of last arena block
+  long                     m_cc_used;        //!< Used elements in last block
+  //
   // Counterpart statistics
   int                      m_num_Sel;        //!< Number of selection criteria
   int                     *m_cpt_stat;       //!< Counterpart statistics
   std::vector<std::string> m_cpt_names;      //!< Counterpart names for each source
   //
+  // Streaming association
+  long                     m_stream_size;    //!< Allocated stream sources
+  std::vector<std::vector<int> > m_stream_col; //!< Stream sources per counterpart
+  std::deque<std::string>  m_stream_names;   //!< Stream source names
+  //
+  // Checkpointing
+  FILE                    *m_chk_file;       //!< Checkpoint file (or NULL)
+  std::string              m_chk_hash;       //!< Counterpart file hashes
+  //
   // Catch-22
   double        m_prior;            //!< Catch-22 prior probability
   double        m_prior_min;        //!< Minimum prior probability
@@ -586,6 +699,14 @@ private:
   double        m_completeness;     //!< Completeness
   double        m_fract_not_unique; //!< Fraction of non-unique sources
   //
+  // Prior and threshold sweep
+  std::vector<std::string>          m_sweep_names; //!< Sweep table columns
+  std::vector<std::vector<double> > m_sweep;       //!< Sweep table
+  std::vector<std::string>          m_curve_names; //!< Curve table columns
+  std::vector<std::vector<double> > m_curve;       //!< Curve table
+  std::vector<std::string>          m_mc_names;    //!< MC table columns
+  std::vector<std::vector<double> > m_mc;          //!< MC table
+  //
   // Output cataloge: source catalogue quantities
   int                      m_num_src_Qty;    //!< Number of src. cat. quantities
   std::vector<int>         m_src_Qty_colnum; //!< Vector of column numbers
@@ -593,6 +714,7 @@ private:
   std::vector<std::string> m_src_Qty_tform;  //!< Vector of column formats
   std::vector<std::string> m_src_Qty_tunit;  //!< Vector of column units
   std::vector<std::string> m_src_Qty_tbucd;  //!< Vector of column UCDs
+  std::vector<int>         m_src_Qty_table;  //!< In-memory catalogue columns
   //
   // Output cataloge: counterpart catalogue quantities
   int                      m_num_cpt_Qty;    //!< Number of cpt. cat. quantities
@@ -601,9 +723,16 @@ private:
   std::vector<std::string> m_cpt_Qty_tform;  //!< Vector of column formats
   std::vector<std::string> m_cpt_Qty_tunit;  //!< Vector of column units
   std::vector<std::string> m_cpt_Qty_tbucd;  //!< Vector of column UCDs
+  std::vector<int>         m_cpt_Qty_table;  //!< In-memory catalogue columns
 };
 inline Catalogue::Catalogue(void) { init_memory(); }
 inline Catalogue::~Catalogue(void) { free_memory(); }
+inline const char *Catalogue::object_name(long iCpt) {
+  return (iCpt >= 0 && iCpt < m_cpt.numLoad) ? m_cpt.object[iCpt].name : "";
+}
+inline const char *Catalogue::source_name(long iSrc) {
+  return (iSrc >= 0 && iSrc < m_src.numLoad) ? m_src.object[iSrc].name : "";
+}
 
 
 /* Prototypes _______________________________________________________________ */
@@ -0,0 +1,674 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file Catalogue_api.cxx
+ * @brief Implements in-memory association methods of Catalogue class.
+ * @author J. Knodlseder
+ */
+
+/* Includes _________________________________________________________________ */
+#include <cstdlib>
+#include "sourceIdentify.h"
+#include "Catalogue.h"
+#include "Log.h"
+
+
+/* Definitions ______________________________________________________________ */
+#define API_MEM_NAME  "mem://gtsrcid"      // In-memory working catalogue
+#define API_OUT_NAME  "mem://gtsrcid_out"  // In-memory output catalogue
+
+
+/* Namespace definition _____________________________________________________ */
+namespace sourceIdentify {
+
+
+/* Type defintions __________________________________________________________ */
+
+
+/* Globals __________________________________________________________________ */
+
+
+/* Private Prototypes _______________________________________________________ */
+
+
+/*============================================================================*/
+/*                         In-memory association methods                      */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Associate in-memory catalogues
+ *
+ * @param[in] par Pointer to gtsrcid parameters (see Parameters::set).
+ * @param[in] src Source catalogue.
+ * @param[in] cpt Counterpart catalogue.
+ * @param[out] res Association results.
+ * @param[in] status Error status.
+ *
+ * Performs the same association as build(), but takes both catalogues from
+ * memory and returns the claimed associations in @p res. The working and
+ * output catalogues are FITS catalogues in memory, hence all formulae and
+ * selections are evaluated in the same way as for the gtsrcid executable.
+ * The additional catalogue columns are accessible in formulae under the
+ * names <prefix>_<column>.
+ ******************************************************************************/
+Status Catalogue::associate(Parameters *par, const AssocCatalogue &src,
+                            const AssocCatalogue &cpt, AssocResult &res,
+                            Status status) {
+
+    // Declare local variables
+    int fstatus;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::associate");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Load source catalogue
+      status = get_input_table(par, &m_src, &src, par->m_srcPosError, status);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to load in-memory source catalogue.",
+              (Status)status);
+        continue;
+      }
+
+      // Load counterpart catalogue
+      status = get_input_table(par, &m_cpt, &cpt, par->m_cptPosError, status);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to load in-memory counterpart catalogue.",
+              (Status)status);
+        continue;
+      }
+
+      // Stop if one of the catalogues is empty
+      if (m_src.numLoad < 1 || m_cpt.numLoad < 1) {
+        status = STATUS_CAT_EMPTY;
+        if (par->logTerse())
+          Log(Error_2, "%d : In-memory catalogue is empty.", (Status)status);
+        continue;
+      }
+
+      // Create working and output FITS catalogues in memory
+      status = cfits_create(&m_memFile, (char*)API_MEM_NAME, par, status);
+      status = cfits_create(&m_outFile, (char*)API_OUT_NAME, par, status);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to create FITS memory catalogues.",
+              (Status)status);
+        continue;
+      }
+
+      // Associate all sources
+      status = associate_sources(par, status);
+      if (status != STATUS_OK)
+        continue;
+
+      // Extract results
+      status = get_results(par, res, status);
+      if (status != STATUS_OK)
+        continue;
+
+    } while (0); // End of main do-loop
+
+    // Close FITS memory catalogues
+    if (m_memFile != NULL) {
+      fstatus = 0;
+      fits_close_file(m_memFile, &fstatus);
+      m_memFile = NULL;
+    }
+    if (m_outFile != NULL) {
+      fstatus = 0;
+      fits_close_file(m_outFile, &fstatus);
+      m_outFile = NULL;
+    }
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::associate (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Load resident counterpart catalogue
+ *
+ * @param[in] par Pointer to gtsrcid parameters (see Parameters::set).
+ * @param[in] status Error status.
+ *
+ * Loads the counterpart catalogue par->m_cptCatName together with its
+ * optional density map, builds the declination index and creates the FITS
+ * memory catalogues that are reused by all subsequent query() calls. The
+ * source catalogue columns are empty as queries only provide positions.
+ ******************************************************************************/
+Status Catalogue::load(Parameters *par, Status status) {
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::load");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Get counterpart catalogue descriptor
+      status = get_input_descriptor(par, par->m_cptCatName, &m_cpt, status);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to load counterpart catalogue '%s'"
+              " descriptor.", (Status)status, par->m_cptCatName.c_str());
+        continue;
+      }
+
+      // Optionally read counterpart density map
+      status = get_density_map(par, status);
+      if (status != STATUS_OK)
+        continue;
+
+      // Load counterpart catalogue
+      status = get_input_catalogue(par, &m_cpt, par->m_cptPosError, status);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to load counterpart catalogue '%s' data.",
+              (Status)status, par->m_cptCatName.c_str());
+        continue;
+      }
+      if (m_cpt.numLoad < 1) {
+        status = STATUS_CAT_EMPTY;
+        if (par->logTerse())
+          Log(Error_2, "%d : Counterpart catalogue is empty.", (Status)status);
+        continue;
+      }
+
+      // Build counterpart declination index
+      status = cid_index(par, status);
+      if (status != STATUS_OK)
+        continue;
+
+      // Create FITS memory catalogues
+      status = cfits_create(&m_memFile, (char*)API_MEM_NAME, par, status);
+      status = cfits_create(&m_outFile, (char*)API_OUT_NAME, par, status);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to create FITS memory catalogues.",
+              (Status)status);
+        continue;
+      }
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::load (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Associate sources with resident counterpart catalogue
+ *
+ * @param[in] par Pointer to gtsrcid parameters (see Parameters::set).
+ * @param[in] src Source catalogue (positions and error ellipses).
+ * @param[out] res Association results.
+ * @param[in] status Error status.
+ *
+ * Requires a prior call to load(). Catalogue level quantities such as
+ * PROB_POST_CAT, nsrc() or the catch-22 prior are computed over the sources
+ * of this query only.
+ ******************************************************************************/
+Status Catalogue::query(Parameters *par, const AssocCatalogue &src,
+                        AssocResult &res, Status status) {
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::query");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Initialise results
+      res.numAssoc = 0;
+
+      // Release information of previous query
+      clear_sources();
+
+      // Load sources
+      status = get_input_table(par, &m_src, &src, par->m_srcPosError, status);
+      if (status != STATUS_OK)
+        continue;
+      if (m_src.numLoad < 1)
+        continue;
+
+      // Clear FITS memory catalogues
+      status = cfits_clear(m_memFile, par, status);
+      status = cfits_clear(m_outFile, par, status);
+      if (status != STATUS_OK)
+        continue;
+
+      // Associate sources
+      status = associate_sources(par, status);
+      if (status != STATUS_OK)
+        continue;
+
+      // Extract results
+      status = get_results(par, res, status);
+      if (status != STATUS_OK)
+        continue;
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::query (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Release source information of previous association
+ *
+ * Frees all per-source information and resets the catch-22 and association
+ * results and the streaming state, but keeps the counterpart catalogue, its
+ * declination index and the FITS memory catalogues. The last candidate arena
+ * block is kept for reuse.
+ ******************************************************************************/
+void Catalogue::clear_sources(void) {
+
+    // Free source information
+    if (m_info     != NULL) delete [] m_info;
+    if (m_cpt_stat != NULL) delete [] m_cpt_stat;
+    if (m_cpt_sel  != NULL) delete [] m_cpt_sel;
+    m_info     = NULL;
+    m_cpt_stat = NULL;
+    m_cpt_sel  = NULL;
+
+    // Reset counterpart candidate arena (keep last block)
+    if (m_cc_block.size() > 1) {
+      for (int i = 0; i < (int)m_cc_block.size()-1; ++i)
+        delete [] m_cc_block[i];
+      m_cc_block.erase(m_cc_block.begin(), m_cc_block.end()-1);
+    }
+    m_cc_used = 0;
+
+    // Reset streaming association
+    m_stream_size = 0;
+    std::vector<std::vector<int> >().swap(m_stream_col);
+    m_stream_names.clear();
+
+    // Reset catch-22
+    m_prior     = c_prob_prior;
+    m_prior_min = c_prob_prior_min;
+    m_prior_max = c_prob_prior_max;
+    m_iter      = 0;
+
+    // Reset association results
+    m_num_claimed      = 0.0;
+    m_sum_pid          = 0.0;
+    m_sum_pc           = 0.0;
+    m_sum_lr           = 0.0;
+    m_sum_pid_thr      = 0.0;
+    m_sum_pc_thr       = 0.0;
+    m_sum_lr_thr       = 0.0;
+    m_reliability      = 0.0;
+    m_completeness     = 0.0;
+    m_fract_not_unique = 0.0;
+    m_num_lr_div       = 0.0;
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Extract association results
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[out] res Association results.
+ * @param[in] status Error status.
+ * @param[in] srcs Source indices (NULL: all sources).
+ *
+ * Adds the claimed counterpart candidates of all sources (or of the sources
+ * in @p srcs) to the output catalogue, evaluates the new output quantities,
+ * performs the final selection and extracts the results.
+ ******************************************************************************/
+Status Catalogue::get_results(Parameters *par, AssocResult &res,
+                              Status status, const std::vector<int> *srcs) {
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::get_results");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Add claimed counterpart candidates to output catalogue
+      int num = (srcs != NULL) ? (int)srcs->size() : (int)m_src.numLoad;
+      for (int i = 0; i < num; ++i) {
+        int iSrc = (srcs != NULL) ? (*srcs)[i] : i;
+        status = cfits_add(m_outFile, par, &(m_info[iSrc]),
+                           m_info[iSrc].numClaimed, status);
+        if (status != STATUS_OK) {
+          if (par->logTerse())
+            Log(Error_2, "%d : Unable to add counterpart candidates for source"
+                " %d to output catalogue.", (Status)status, iSrc+1);
+          break;
+        }
+      }
+      if (status != STATUS_OK)
+        continue;
+
+      // Evaluate output catalogue quantities and perform final selection
+      status = cfits_eval(m_outFile, par, status);
+      status = cfits_select(m_outFile, par, status);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to evaluate or select output catalogue.",
+              (Status)status);
+        continue;
+      }
+
+      // Extract results
+      status = get_output_table(par, m_outFile, res, status);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to extract association results.",
+              (Status)status);
+        continue;
+      }
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::get_results (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Append counterpart candidates to association results
+ *
+ * @param[in] src Pointer to source information.
+ * @param[in] num Number of counterpart candidates.
+ * @param[out] res Association results.
+ *
+ * Copies the first @p num counterpart candidates of a source directly into
+ * the results, without going through the output catalogue. New output
+ * quantities are not evaluated.
+ ******************************************************************************/
+void Catalogue::get_candidates(SourceInfo *src, int num, AssocResult &res) {
+
+    // Append counterpart candidates
+    for (int iCC = 0; iCC < num; ++iCC) {
+      CCElement *cc = &(src->cc[iCC]);
+      res.src.push_back(src->iSrc);
+      res.cpt.push_back(cc->index);
+      res.prob.push_back(cc->prob);
+      res.prob_pos.push_back(cc->prob_pos);
+      res.prob_chance.push_back(cc->prob_chance);
+      res.prob_prior.push_back(cc->prob_prior);
+      res.prob_post.push_back(cc->prob_post);
+      res.prob_post_single.push_back(cc->prob_post_single);
+      res.likrat.push_back(cc->likrat);
+      res.angsep.push_back(cc->angsep);
+      res.psi.push_back(cc->psi);
+      res.rho.push_back(cc->rho);
+      res.fom.push_back(cc->fom);
+      res.numAssoc++;
+    }
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Load catalogue from memory
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] in Pointer to input catalogue.
+ * @param[in] table In-memory catalogue.
+ * @param[in] posErr Error radius if no error is given.
+ * @param[in] status Error status.
+ *
+ * Equivalent of get_input_catalogue() for in-memory catalogues. Positions
+ * are given in equatorial coordinates and error ellipses are expected at
+ * the 95% confidence level. Missing error ellipse arrays are replaced by
+ * @p posErr (major axis), the major axis (minor axis) and 0 (position angle).
+ * Objects with non-finite positions are flagged as invalid.
+ ******************************************************************************/
+Status Catalogue::get_input_table(Parameters *par, InCatalogue *in,
+                                  const AssocCatalogue *table, double posErr,
+                                  Status status) {
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::get_input_table");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Check catalogue
+      if (table->ra == NULL || table->dec == NULL ||
+          table->colNames.size() != table->colData.size()) {
+        status = STATUS_CAT_NO_POS;
+        if (par->logTerse())
+          Log(Error_2, "%d : In-memory catalogue has no positions or"
+              " inconsistent columns.", (Status)status);
+        continue;
+      }
+
+      // Set catalogue information
+      in->table       = table;
+      in->inName      = "memory";
+      in->numLoad     = table->numObjects;
+      in->numTotal    = table->numObjects;
+      in->e_pos_scale = 1.0;
+      in->erposabs    = c_erposabs * 2.4860;
+
+      // Fall through if there are no objects
+      if (in->numLoad < 1)
+        continue;
+
+      // Allocate memory for object information
+      if (in->object != NULL) delete [] in->object;
+      in->object = new ObjectInfo[in->numLoad];
+      if (in->object == NULL) {
+        status = STATUS_MEM_ALLOC;
+        if (par->logTerse())
+          Log(Error_2, "%d : Memory allocation failure.", (Status)status);
+        continue;
+      }
+
+      // Extract object information
+      std::vector<long> offset(in->numLoad);
+      std::string       name;
+      std::vector<char>().swap(in->names);
+      for (int i = 0; i < in->numLoad; ++i) {
+
+        // Set position
+        ObjectInfo *ptr  = &(in->object[i]);
+        ptr->name        = NULL;
+        ptr->pos_eq_ra   = table->ra[i];
+        ptr->pos_eq_dec  = table->dec[i];
+        ptr->pos_valid   = (ptr->pos_eq_ra  == ptr->pos_eq_ra &&
+                            ptr->pos_eq_dec == ptr->pos_eq_dec);
+        if (ptr->pos_valid) {
+          ptr->pos_eq_ra = ptr->pos_eq_ra -
+                           double(long(ptr->pos_eq_ra / 360.0) * 360.0);
+          if (ptr->pos_eq_ra < 0.0)
+            ptr->pos_eq_ra += 360.0;
+        }
+
+        // Set error ellipse
+        ptr->pos_err_maj = (table->err_maj != NULL) ? table->err_maj[i] : posErr;
+        ptr->pos_err_min = (table->err_min != NULL) ? table->err_min[i]
+                                                    : ptr->pos_err_maj;
+        ptr->pos_err_ang = (table->err_ang != NULL) ? table->err_ang[i] : 0.0;
+
+        // Avoid position errors smaller than the absolute position error
+        if (ptr->pos_err_maj < in->erposabs && ptr->pos_err_min < in->erposabs) {
+          ptr->pos_err_maj = in->erposabs;
+          ptr->pos_err_min = in->erposabs;
+          ptr->pos_err_ang = 0.0;
+        }
+
+        // Append name to name pool
+        if (table->names != NULL && table->names[i] != NULL)
+          name = table->names[i];
+        else
+          name = "no-name";
+        name      = cid_assign_src_name(name, i);
+        offset[i] = in->names.size();
+        in->names.insert(in->names.end(), name.begin(), name.end());
+        in->names.push_back('\0');
+
+      } // endfor: looped over all objects
+
+      // Set name pointers
+      for (int i = 0; i < in->numLoad; ++i)
+        in->object[i].name = &(in->names[offset[i]]);
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::get_input_table (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Extract association results from output catalogue
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] fptr Pointer to output FITS catalogue.
+ * @param[out] res Association results.
+ * @param[in] status Error status.
+ *
+ * The source index is recovered from the counterpart identifier and the
+ * counterpart index from the REF column.
+ ******************************************************************************/
+Status Catalogue::get_output_table(Parameters *par, fitsfile *fptr,
+                                   AssocResult &res, Status status) {
+
+    // Declare local variables
+    std::vector<std::string> col_id;
+    std::vector<double>      col_ref;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::get_output_table");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Read identifier and reference columns
+      status = cfits_get_col_str(fptr, par, OUTCAT_COL_ID_NAME, col_id, status);
+      status = cfits_get_col(fptr, par, OUTCAT_COL_REF_NAME, col_ref, status);
+      if (status != STATUS_OK)
+        continue;
+
+      // Set source and counterpart indices
+      res.numAssoc = (long)col_id.size();
+      res.src      = std::vector<int>(res.numAssoc);
+      res.cpt      = std::vector<long>(res.numAssoc);
+      for (long i = 0; i < res.numAssoc; ++i) {
+        res.src[i] = (col_id[i].length() > 3) ? atoi(col_id[i].c_str()+3) - 1 : -1;
+        res.cpt[i] = long(col_ref[i] + 0.5);
+      }
+
+      // Read generic columns
+      status = cfits_get_col(fptr, par, OUTCAT_COL_PROB_NAME, res.prob, status);
+      status = cfits_get_col(fptr, par, OUTCAT_COL_PROB_POS_NAME,
+                             res.prob_pos, status);
+      status = cfits_get_col(fptr, par, OUTCAT_COL_PROB_CHANCE_NAME,
+                             res.prob_chance, status);
+      status = cfits_get_col(fptr, par, OUTCAT_COL_PROB_PRIOR_NAME,
+                             res.prob_prior, status);
+      status = cfits_get_col(fptr, par, OUTCAT_COL_PROB_POST_NAME,
+                             res.prob_post, status);
+      status = cfits_get_col(fptr, par, OUTCAT_COL_PROB_POST_S_NAME,
+                             res.prob_post_single, status);
+      status = cfits_get_col(fptr, par, OUTCAT_COL_LR_NAME, res.likrat, status);
+      status = cfits_get_col(fptr, par, OUTCAT_COL_ANGSEP_NAME, res.angsep,
+                             status);
+      status = cfits_get_col(fptr, par, OUTCAT_COL_PSI_NAME, res.psi, status);
+      status = cfits_get_col(fptr, par, OUTCAT_COL_RHO_NAME, res.rho, status);
+      status = cfits_get_col(fptr, par, OUTCAT_COL_FOM_NAME, res.fom, status);
+      if (status != STATUS_OK)
+        continue;
+
+      // Read new output quantities
+      int numQty   = (int)par->m_outCatQtyName.size();
+      res.qtyNames = par->m_outCatQtyName;
+      res.qtyData  = std::vector<std::vector<double> >(numQty);
+      for (int iQty = 0; iQty < numQty; ++iQty) {
+        status = cfits_get_col(fptr, par, par->m_outCatQtyName[iQty],
+                               res.qtyData[iQty], status);
+        if (status != STATUS_OK)
+          break;
+      }
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::get_output_table (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/* Namespace ends ___________________________________________________________ */
+}
@@ -0,0 +1,389 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file Catalogue_cache.cxx
+ * @brief Implements result cache methods of Catalogue class.
+ * @author J. Knodlseder
+ */
+
+/* Includes _________________________________________________________________ */
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "sourceIdentify.h"
+#include "Catalogue.h"
+#include "Log.h"
+
+
+/* Definitions ______________________________________________________________ */
+#define CACHE_VERSION  1                          // Cache key version
+#define CACHE_BUFFER   65536                      // File buffer size
+
+
+/* Namespace definition _____________________________________________________ */
+namespace sourceIdentify {
+
+
+/* Type defintions __________________________________________________________ */
+
+
+/* Globals __________________________________________________________________ */
+
+
+/* Private Prototypes _______________________________________________________ */
+static void cache_hash(unsigned long long *hash, const char *buf, size_t len);
+static int  cache_hash_file(std::string filename, unsigned long long *hash);
+static int  cache_copy(std::string from, std::string to);
+
+
+/**************************************************************************//**
+ * @brief Update 64-bit FNV-1a hash
+ *
+ * @param[in,out] hash Hash value.
+ * @param[in] buf Data.
+ * @param[in] len Number of bytes.
+ ******************************************************************************/
+static void cache_hash(unsigned long long *hash, const char *buf, size_t len) {
+
+    // Hash bytes
+    for (size_t i = 0; i < len; ++i) {
+      *hash ^= (unsigned char)buf[i];
+      *hash *= 1099511628211ULL;
+    }
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Hash file contents
+ *
+ * @param[in] filename File name (an extension specifier "[...]" is ignored).
+ * @param[in,out] hash Hash value.
+ *
+ * Returns 0 on success and -1 if the file can not be read, e.g. for
+ * catalogues that are queried from the web.
+ ******************************************************************************/
+static int cache_hash_file(std::string filename, unsigned long long *hash) {
+
+    // Open file, stripping an extension specifier if needed
+    FILE *fptr = fopen(filename.c_str(), "rb");
+    if (fptr == NULL && filename.find('[') != std::string::npos)
+      fptr = fopen(filename.substr(0, filename.find('[')).c_str(), "rb");
+    if (fptr == NULL)
+      return -1;
+
+    // Hash contents and size
+    std::vector<char> buf(CACHE_BUFFER);
+    unsigned long long size = 0;
+    size_t             n;
+    while ((n = fread(&buf[0], 1, buf.size(), fptr)) > 0) {
+      cache_hash(hash, &buf[0], n);
+      size += n;
+    }
+    int error = ferror(fptr);
+    fclose(fptr);
+    cache_hash(hash, (const char*)&size, sizeof(size));
+
+    // Return
+    return (error) ? -1 : 0;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Copy file atomically
+ *
+ * @param[in] from Source file name.
+ * @param[in] to Destination file name.
+ *
+ * Copies into a unique temporary file next to @p to (created by mkstemp,
+ * hence also unique for hosts that share the directory) and renames it, so
+ * that concurrent readers never see a partially written file. Returns 0 on
+ * success and -1 on failure.
+ ******************************************************************************/
+static int cache_copy(std::string from, std::string to) {
+
+    // Open source file
+    FILE *in = fopen(from.c_str(), "rb");
+    if (in == NULL)
+      return -1;
+
+    // Create temporary file
+    std::string       tmp = to + ".tmp.XXXXXX";
+    std::vector<char> name(tmp.begin(), tmp.end());
+    name.push_back('\0');
+    int fd = mkstemp(&name[0]);
+    if (fd < 0) {
+      fclose(in);
+      return -1;
+    }
+    tmp = &name[0];
+    fchmod(fd, 0644);
+    FILE *out = fdopen(fd, "wb");
+    if (out == NULL) {
+      close(fd);
+      remove(tmp.c_str());
+      fclose(in);
+      return -1;
+    }
+
+    // Copy contents
+    std::vector<char> buf(CACHE_BUFFER);
+    size_t            n;
+    int               error = 0;
+    while ((n = fread(&buf[0], 1, buf.size(), in)) > 0) {
+      if (fwrite(&buf[0], 1, n, out) != n) {
+        error = 1;
+        break;
+      }
+    }
+    if (ferror(in))
+      error = 1;
+    fclose(in);
+    if (fclose(out) != 0)
+      error = 1;
+
+    // Move temporary file in place
+    if (!error && rename(tmp.c_str(), to.c_str()) != 0)
+      error = 1;
+    if (error)
+      remove(tmp.c_str());
+
+    // Return
+    return (error) ? -1 : 0;
+
+}
+
+
+/*============================================================================*/
+/*                             Result cache methods                           */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Return hash of file contents
+ *
+ * @param[in] filename File name (an extension specifier "[...]" is ignored).
+ *
+ * Returns the hash as hexadecimal string, or an empty string if the file
+ * can not be read (e.g. for catalogues that are queried from the web).
+ ******************************************************************************/
+std::string Catalogue::cache_file_hash(const std::string &filename) {
+
+    // Hash file
+    unsigned long long hash = 14695981039346656037ULL;
+    if (filename.length() < 1 || cache_hash_file(filename, &hash) != 0)
+      return "";
+
+    // Return hash string
+    char buffer[32];
+    sprintf(buffer, "%016llx", hash);
+    return std::string(buffer);
+
+}
+
+
+/**************************************************************************//**
+ * @brief Get result from cache
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[out] key Cache key (empty if results can not be cached).
+ * @param[out] hit Signals that the output catalogue was taken from the cache.
+ * @param[in] status Error status.
+ *
+ * Does nothing if no cache directory is given. The cache key is a hash of
+ * the contents of the source catalogue, the counterpart catalogue, the
+ * density map and, for incremental association, the previous source
+ * catalogue and checkpoint, and of all parameters that affect the output
+ * catalogue, including the full file names (the file hash ignores extension
+ * specifiers such as "[...]", which select different data). Catalogues that are not readable files (e.g. web catalogues)
+ * disable the cache. If the cache directory holds an output catalogue for
+ * the key, it is copied to the output catalogue and @p hit is set.
+ ******************************************************************************/
+Status Catalogue::cache_get(Parameters *par, std::string &key, int &hit,
+                            Status status) {
+
+    // Declare local variables
+    unsigned long long hash = 14695981039346656037ULL;
+    std::ostringstream sig;
+    std::ostringstream name;
+    std::string        filename;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::cache_get");
+
+    // Single loop for common exit point
+    do {
+
+      // Initialise results
+      key.clear();
+      hit = 0;
+
+      // Fall through in case of an error or if no cache is requested
+      if (status != STATUS_OK || par->m_cacheDir.length() < 1)
+        continue;
+
+      // Hash input catalogues and density map
+      if (cache_hash_file(par->m_srcCatName, &hash) != 0 ||
+          cache_hash_file(par->m_cptCatName, &hash) != 0 ||
+          (par->m_cptDensFile.length() > 0 &&
+           cache_hash_file(par->m_cptDensFile, &hash) != 0) ||
+          (par->m_prevCatName.length() > 0 &&
+           (cache_hash_file(par->m_prevCatName, &hash) != 0 ||
+            cache_hash_file(par->m_prevChkFile, &hash) != 0))) {
+        if (par->logTerse())
+          Log(Warning_2, " Input catalogues are not readable files; result"
+              " cache disabled.");
+        continue;
+      }
+
+      // Hash parameters that affect the output catalogue. The source
+      // processing order, sharding, checkpointing, the number of Monte Carlo
+      // workers and the logging parameters do not affect it
+      sig.precision(17);
+      sig << CACHE_VERSION            << "|" << TOOL_VERSION            << "|"
+          << par->m_srcCatName        << "|" << par->m_cptCatName       << "|"
+          << par->m_cptDensFile       << "|" << par->m_prevCatName      << "|"
+          << par->m_prevChkFile       << "|"
+          << par->m_srcCatPrefix      << "|" << par->m_srcCatQty        << "|"
+          << par->m_srcPosError       << "|" << par->m_cptCatPrefix     << "|"
+          << par->m_cptCatQty         << "|" << par->m_cptPosError      << "|"
+          << par->m_probMethod        << "|" << par->m_probPrior        << "|"
+          << par->m_probThres         << "|" << par->m_maxNumCpt        << "|"
+          << par->m_FoM               << "|" << par->m_catch22          << "|"
+          << par->m_probCurves        << "|"
+          << par->m_mcNum             << "|" << par->m_mcShift          << "|"
+          << par->m_mcSeed            << "|" << par->m_prevTol;
+      for (int i = 0; i < (int)par->m_outCatQtyName.size(); ++i)
+        sig << "|" << par->m_outCatQtyName[i] << "=" << par->m_outCatQtyFormula[i];
+      for (int i = 0; i < (int)par->m_select.size(); ++i)
+        sig << "|" << par->m_select[i];
+      for (int i = 0; i < (int)par->m_sweepPrior.size(); ++i)
+        sig << "|p" << par->m_sweepPrior[i];
+      for (int i = 0; i < (int)par->m_sweepThres.size(); ++i)
+        sig << "|t" << par->m_sweepThres[i];
+      cache_hash(&hash, sig.str().c_str(), sig.str().length());
+
+      // Set cache key and file name
+      char buffer[32];
+      sprintf(buffer, "%016llx", hash);
+      key      = buffer;
+      name << par->m_cacheDir << "/" << key << ".fits";
+      filename = name.str();
+
+      // Dump cache key
+      if (par->logNormal()) {
+        Log(Log_2, "");
+        Log(Log_2, "Result cache:");
+        Log(Log_2, "=============");
+        Log(Log_2, " Cache key ........................: %s", key.c_str());
+      }
+
+      // Fall through if result is not in cache
+      if (access(filename.c_str(), R_OK) != 0) {
+        if (par->logNormal())
+          Log(Log_2, " Cache miss; associate sources.");
+        continue;
+      }
+
+      // Refuse to overwrite output catalogue without clobber
+      if (!par->m_clobber && access(par->m_outCatName.c_str(), F_OK) == 0) {
+        status = STATUS_PAR_BAD_PARAMETER;
+        if (par->logTerse())
+          Log(Error_2, "%d : Output catalogue '%s' exists and clobber=no.",
+              (Status)status, par->m_outCatName.c_str());
+        continue;
+      }
+
+      // Copy cached output catalogue
+      if (cache_copy(filename, par->m_outCatName) != 0) {
+        status = STATUS_PAR_BAD_PARAMETER;
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to copy cached catalogue '%s' to '%s'.",
+              (Status)status, filename.c_str(), par->m_outCatName.c_str());
+        continue;
+      }
+      hit = 1;
+
+      // Log cache hit
+      if (par->logTerse())
+        Log(Log_1, " Output catalogue '%s' taken from result cache '%s'.",
+            par->m_outCatName.c_str(), filename.c_str());
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::cache_get (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Put result into cache
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] key Cache key (see cache_get()).
+ * @param[in] status Error status.
+ *
+ * Copies the output catalogue into the cache directory (created if needed)
+ * under the cache key. The copy is atomic, hence concurrent runs with the
+ * same key never read a partial entry. Failing to populate the cache only
+ * issues a warning.
+ ******************************************************************************/
+Status Catalogue::cache_put(Parameters *par, const std::string &key,
+                            Status status) {
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::cache_put");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error or if results are not cached
+      if (status != STATUS_OK || key.length() < 1)
+        continue;
+
+      // Copy output catalogue into cache
+      std::string filename = par->m_cacheDir + "/" + key + ".fits";
+      mkdir(par->m_cacheDir.c_str(), 0777);
+      if (cache_copy(par->m_outCatName, filename) != 0) {
+        if (par->logTerse())
+          Log(Warning_2, " Unable to store output catalogue in result cache"
+              " '%s'.", filename.c_str());
+        continue;
+      }
+      if (par->logNormal())
+        Log(Log_2, " Output catalogue stored in result cache '%s'.",
+            filename.c_str());
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::cache_put (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/* Namespace ends ___________________________________________________________ */
+}
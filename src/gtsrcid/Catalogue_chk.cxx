@@ -0,0 +1,806 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file Catalogue_chk.cxx
+ * @brief Implements checkpoint methods of Catalogue class.
+ * @author J. Knodlseder
+ */
+
+/* Includes _________________________________________________________________ */
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <unistd.h>
+#include "sourceIdentify.h"
+#include "Catalogue.h"
+#include "Log.h"
+
+
+/* Definitions ______________________________________________________________ */
+#define CHK_MAGIC    "GTSRCCHK"                   // Checkpoint file magic
+#define CHK_VERSION  3                            // Checkpoint file version
+
+
+/* Namespace definition _____________________________________________________ */
+namespace sourceIdentify {
+
+
+/* Type defintions __________________________________________________________ */
+typedef struct {                      // Checkpoint file header
+  char                    magic[8];     //!< File magic (CHK_MAGIC)
+  int                     version;      //!< File version
+  int                     sizeCC;       //!< Size of CCElement
+  long                    numSrc;       //!< Number of sources
+  long                    numCpt;       //!< Number of counterparts
+  int                     numSel;       //!< Number of selection criteria
+  int                     lenSig;       //!< Length of parameter signature
+} ChkHeader;
+
+typedef struct {                      // Checkpoint source record
+  int                     iSrc;         //!< Source index
+  int                     numFilter;    //!< Number of filter step candidates
+  int                     numPrune;     //!< Number of pruned candidates
+  int                     numSelect;    //!< Number of selection step candidates
+  int                     numRefine;    //!< Number of refine step candidates
+  int                     numSweep;     //!< Number of prior sweep candidates
+  double                  filter_rad;   //!< Filter step radius
+  double                  ring_rad_min; //!< Density ring minimum
+  double                  ring_rad_max; //!< Density ring maximum
+  double                  omega;        //!< Solid angle of error ellipse
+} ChkRecord;
+
+
+/* Globals __________________________________________________________________ */
+
+
+/* Private Prototypes _______________________________________________________ */
+static void chk_set_header(ChkHeader *hdr, long numSrc, long numCpt,
+                           int numSel, const std::string &sig);
+
+
+/**************************************************************************//**
+ * @brief Set checkpoint file header
+ *
+ * @param[out] hdr Checkpoint file header.
+ * @param[in] numSrc Number of sources.
+ * @param[in] numCpt Number of counterparts.
+ * @param[in] numSel Number of selection criteria.
+ * @param[in] sig Parameter signature.
+ ******************************************************************************/
+static void chk_set_header(ChkHeader *hdr, long numSrc, long numCpt,
+                           int numSel, const std::string &sig) {
+
+    // Set header (clear padding so that headers can be compared)
+    memset(hdr, 0, sizeof(ChkHeader));
+    memcpy(hdr->magic, CHK_MAGIC, sizeof(hdr->magic));
+    hdr->version = CHK_VERSION;
+    hdr->sizeCC  = (int)sizeof(CCElement);
+    hdr->numSrc  = numSrc;
+    hdr->numCpt  = numCpt;
+    hdr->numSel  = numSel;
+    hdr->lenSig  = (int)sig.length();
+
+    // Return
+    return;
+
+}
+
+
+/*============================================================================*/
+/*                              Checkpoint methods                            */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Return parameter signature of checkpoint
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] srcCatName Source catalogue name.
+ *
+ * The signature collects all parameters that affect the per-source results,
+ * and the contents of the counterpart catalogue and the density map, so
+ * that a checkpoint is only resumed or reused with the same counterparts
+ * and parameters. The files are only hashed on the first call; the hashes
+ * are kept in m_chk_hash.
+ ******************************************************************************/
+std::string Catalogue::chk_signature(Parameters *par,
+                                     const std::string &srcCatName) {
+
+    // Hash counterpart catalogue and density map once
+    if (m_chk_hash.length() < 1)
+      m_chk_hash = cache_file_hash(par->m_cptCatName) + "|" +
+                   cache_file_hash(par->m_cptDensFile);
+
+    // Collect parameters
+    std::ostringstream sig;
+    sig.precision(17);
+    sig << srcCatName          << "|" << par->m_srcCatPrefix << "|"
+        << par->m_srcCatQty    << "|" << par->m_cptCatName   << "|"
+        << par->m_cptCatPrefix << "|" << par->m_cptCatQty    << "|"
+        << par->m_cptDensFile  << "|" << par->m_srcPosError  << "|"
+        << par->m_cptPosError  << "|" << par->m_probMethod   << "|"
+        << par->m_probPrior    << "|" << par->m_FoM          << "|"
+        << par->m_probThres    << "|" << par->m_catch22      << "|"
+        << (par->m_sweepPrior.size() > 0) << "|" << m_chk_hash;
+    for (int i = 0; i < (int)par->m_outCatQtyName.size(); ++i)
+      sig << "|" << par->m_outCatQtyName[i] << "=" << par->m_outCatQtyFormula[i];
+    for (int i = 0; i < (int)par->m_select.size(); ++i)
+      sig << "|" << par->m_select[i];
+
+    // Return signature
+    return sig.str();
+
+}
+
+
+/**************************************************************************//**
+ * @brief Open checkpoint file
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[out] done Flags the sources that need not be processed.
+ * @param[in] status Error status.
+ *
+ * Does nothing if no checkpoint file is given. If resume is requested and
+ * the checkpoint file was written with the same catalogues and parameters,
+ * the refine step results (candidates, densities, FoMs, ...) and the
+ * selection statistics of all sources in the file are restored and flagged
+ * in @p done. The file is then opened for appending further sources.
+ * Otherwise a new checkpoint file is created. Unchanged sources of a
+ * previous association are finally restored by chk_prev().
+ *
+ * In sharded mode (numShards > 1) a worker (shard >= 0) uses its own
+ * checkpoint file (see chk_filename()) and flags all sources outside its
+ * shard in @p done. The merge step (shard = -1) restores the sources of all
+ * shard checkpoint files and does not write a checkpoint itself.
+ *
+ * A checkpoint file is a header followed by one record per completed
+ * source. Records are appended in blocks by chk_write(), hence an
+ * incomplete last record (interrupted write) is simply ignored.
+ ******************************************************************************/
+Status Catalogue::chk_open(Parameters *par, std::vector<char> &done,
+                           Status status) {
+
+    // Declare local variables
+    ChkHeader   hdr;
+    std::string sig;
+    std::string filename;
+    long        numDone = 0;
+    long        offset  = 0;
+    int         valid   = 0;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::chk_open");
+
+    // Single loop for common exit point
+    do {
+
+      // Initialise flags
+      done = std::vector<char>(m_src.numLoad, 0);
+
+      // Sharded mode exchanges results through checkpoint files
+      if (status == STATUS_OK && par->m_numShards > 1 &&
+          par->m_chkFile.length() < 1) {
+        status = STATUS_PAR_BAD_PARAMETER;
+        if (par->logTerse())
+          Log(Error_2, "%d : Sharded mode requires a checkpoint file"
+              " (chkFile).", (Status)status);
+        continue;
+      }
+
+      // Fall through in case of an error or if no checkpoint is requested
+      if (status != STATUS_OK || par->m_chkFile.length() < 1)
+        continue;
+
+      // Merge step: restore sources of all shards
+      if (par->m_numShards > 1 && par->m_shard < 0) {
+        for (int shard = 0; shard < par->m_numShards; ++shard) {
+          filename = chk_filename(par, shard);
+          status   = chk_read(par, filename, done, numDone, offset, valid,
+                              status);
+          if (status != STATUS_OK)
+            break;
+          if (!valid && par->logTerse())
+            Log(Warning_2, " Checkpoint file '%s' not found or not matching;"
+                " its sources are associated now.", filename.c_str());
+        }
+        if (status != STATUS_OK)
+          continue;
+        if (par->logNormal())
+          Log(Log_2, " Merged sources from %3d shards ...: %ld of %ld",
+              par->m_numShards, numDone, m_src.numLoad);
+        continue;
+      }
+
+      // Set checkpoint file name
+      filename = chk_filename(par, par->m_shard);
+
+      // Optionally restore sources from checkpoint
+      if (par->m_resume) {
+        status = chk_read(par, filename, done, numDone, offset, valid, status);
+        if (status != STATUS_OK)
+          continue;
+        if (valid) {
+          if (truncate(filename.c_str(), offset) == 0)
+            m_chk_file = fopen(filename.c_str(), "ab");
+          if (par->logNormal())
+            Log(Log_2, " Resumed sources from checkpoint ..: %ld of %ld",
+                numDone, m_src.numLoad);
+        }
+        else if (par->logTerse())
+          Log(Warning_2, " Checkpoint file '%s' not found or not matching;"
+              " start from scratch.", filename.c_str());
+      }
+
+      // Create new checkpoint file if needed
+      if (m_chk_file == NULL) {
+        for (int k = 0; k < m_src.numLoad; ++k)
+          done[k] = 0;
+        sig = chk_signature(par, par->m_srcCatName);
+        chk_set_header(&hdr, m_src.numLoad, m_cpt.numLoad, m_num_Sel, sig);
+        m_chk_file = fopen(filename.c_str(), "wb");
+        if (m_chk_file == NULL ||
+            fwrite(&hdr, sizeof(hdr), 1, m_chk_file) != 1 ||
+            fwrite(sig.c_str(), 1, hdr.lenSig, m_chk_file) !=
+                                                  (size_t)hdr.lenSig) {
+          status = STATUS_PAR_BAD_PARAMETER;
+          if (par->logTerse())
+            Log(Error_2, "%d : Unable to create checkpoint file '%s'.",
+                (Status)status, filename.c_str());
+          continue;
+        }
+        fflush(m_chk_file);
+      }
+
+      // Worker: skip sources outside of shard
+      if (par->m_numShards > 1) {
+        long num = 0;
+        status   = chk_shard(par, done, num, status);
+        if (status != STATUS_OK)
+          continue;
+        if (par->logNormal())
+          Log(Log_2, " Sources in shard %3d of %3d ......: %ld of %ld",
+              par->m_shard, par->m_numShards, num, m_src.numLoad);
+      }
+
+    } while (0); // End of main do-loop
+
+    // Optionally reuse unchanged sources of previous association
+    status = chk_prev(par, done, status);
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::chk_open (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Restore sources from checkpoint file
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] filename Checkpoint file name.
+ * @param[in,out] done Flags the restored sources.
+ * @param[in,out] numDone Number of restored sources.
+ * @param[out] offset File offset after the last complete record.
+ * @param[out] valid Signals that the checkpoint file matches (1) or not (0).
+ * @param[in] status Error status.
+ * @param[in] map Source index for each source of the previous source
+ *                catalogue (NULL: checkpoint of this source catalogue).
+ *
+ * If @p map is given, the checkpoint file was written for the previous
+ * source catalogue par->m_prevCatName. Its records are restored into the
+ * sources given by @p map; records of sources that are mapped to -1 or that
+ * are already done are skipped.
+ ******************************************************************************/
+Status Catalogue::chk_read(Parameters *par, std::string filename,
+                           std::vector<char> &done, long &numDone,
+                           long &offset, int &valid, Status status,
+                           const std::vector<int> *map) {
+
+    // Declare local variables
+    ChkHeader              hdr;
+    ChkHeader              in;
+    ChkRecord              rec;
+    std::vector<CCElement> skip_cc;
+
+    // Initialise results
+    offset = 0;
+    valid  = 0;
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Open checkpoint file
+      FILE *fptr = fopen(filename.c_str(), "rb");
+      if (fptr == NULL)
+        continue;
+
+      // Check header
+      long              numSrc = (map != NULL) ? (long)map->size()
+                                               : m_src.numLoad;
+      std::string       sig    = chk_signature(par, (map != NULL)
+                                                    ? par->m_prevCatName
+                                                    : par->m_srcCatName);
+      std::vector<char> in_sig(sig.length()+1, 0);
+      chk_set_header(&hdr, numSrc, m_cpt.numLoad, m_num_Sel, sig);
+      valid = (fread(&in, sizeof(in), 1, fptr) == 1 &&
+               memcmp(&in, &hdr, sizeof(hdr)) == 0 &&
+               fread(&(in_sig[0]), 1, hdr.lenSig, fptr) == (size_t)hdr.lenSig &&
+               sig == std::string(&(in_sig[0])));
+
+      // Read source records
+      offset = ftell(fptr);
+      std::vector<int> stat(m_num_Sel+1);
+      while (valid && fread(&rec, sizeof(rec), 1, fptr) == 1) {
+
+        // Check record
+        if (rec.iSrc < 0 || rec.iSrc >= numSrc || rec.numSelect < 0 ||
+            rec.numRefine < 0 || rec.numRefine > rec.numSweep ||
+            rec.numSweep > rec.numSelect)
+          break;
+
+        // Determine source (records of unmapped sources are skipped)
+        int iSrc = (map != NULL) ? (*map)[rec.iSrc] : rec.iSrc;
+        int skip = (iSrc < 0 || (map != NULL && done[iSrc]));
+
+        // Read counterpart candidates and selection statistics
+        CCElement *cc = NULL;
+        if (rec.numSelect > 0 && skip) {
+          skip_cc.resize(rec.numSelect);
+          cc = &(skip_cc[0]);
+        }
+        else if (rec.numSelect > 0)
+          cc = cid_alloc(rec.numSelect);
+        if (rec.numSelect > 0 && cc == NULL) {
+          status = STATUS_MEM_ALLOC;
+          if (par->logTerse())
+            Log(Error_2, "%d : Memory allocation failure.", (Status)status);
+          break;
+        }
+        if ((rec.numSelect > 0 &&
+             fread(cc, sizeof(CCElement), rec.numSelect, fptr) !=
+                                                 (size_t)rec.numSelect) ||
+            fread(&(stat[0]), sizeof(int), m_num_Sel+1, fptr) !=
+                                                 (size_t)(m_num_Sel+1))
+          break;
+
+        // Skip record
+        if (skip) {
+          offset = ftell(fptr);
+          continue;
+        }
+
+        // Restore source
+        SourceInfo *src   = &(m_info[iSrc]);
+        src->numFilter    = rec.numFilter;
+        src->numPrune     = rec.numPrune;
+        src->numSelect    = rec.numSelect;
+        src->numRefine    = rec.numRefine;
+        src->numSweep     = rec.numSweep;
+        src->cc           = cc;
+        src->filter_rad   = rec.filter_rad;
+        src->ring_rad_min = rec.ring_rad_min;
+        src->ring_rad_max = rec.ring_rad_max;
+        src->omega        = rec.omega;
+        for (int iSel = 0; iSel <= m_num_Sel; ++iSel)
+          m_cpt_stat[iSrc*(m_num_Sel+1) + iSel] = stat[iSel];
+        if (!done[iSrc])
+          numDone++;
+        done[iSrc] = 1;
+
+        // Remember end of last complete record
+        offset = ftell(fptr);
+
+      } // endwhile: looped over records
+
+      // Close checkpoint file
+      fclose(fptr);
+
+    } while (0); // End of main do-loop
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Reuse unchanged sources of previous association
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in,out] done Flags the sources that need not be processed.
+ * @param[in] status Error status.
+ *
+ * Does nothing if no previous source catalogue is given. Otherwise the
+ * sources of the previous source catalogue par->m_prevCatName are matched
+ * by name to the current sources. A source is unchanged if its position
+ * moved by no more than par->m_prevTol and its error ellipse is the same.
+ * The refine step results of unchanged sources (candidates with their LR,
+ * density and FoM, and the selection statistics) are restored from the
+ * checkpoint file par->m_prevChkFile of the previous association; added,
+ * moved and changed sources are associated again. The catalogue level
+ * probabilities are then computed over the merged set of sources.
+ *
+ * Reuse assumes that the refine step results of a source only depend on
+ * its position and error ellipse. If a selection, the prior, the FoM or the
+ * probability formula references a source catalogue quantity (directly or
+ * through a new output catalogue quantity), all sources are associated
+ * again.
+ *
+ * The reused sources are also written to the checkpoint file of this
+ * association, so that it can serve as previous association of the next
+ * release. Incremental association is not available in sharded mode.
+ ******************************************************************************/
+Status Catalogue::chk_prev(Parameters *par, std::vector<char> &done,
+                           Status status) {
+
+    // Declare local variables
+    InCatalogue                prev;
+    std::map<std::string, int> index;
+    std::map<std::string, int> current;
+    std::vector<int>           map;
+    std::vector<int>           pending;
+    long                       numDone  = 0;
+    long                       offset   = 0;
+    int                        valid    = 0;
+    long                       numAdded = 0;
+    long                       numMoved = 0;
+    long                       numGone  = 0;
+
+    // Initialise previous source catalogue
+    prev.numLoad     = 0;
+    prev.numTotal    = 0;
+    prev.object      = NULL;
+    prev.table       = NULL;
+    prev.col_e_type  = NoError;
+    prev.e_pos_scale = 1.0;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::chk_prev");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error or if no previous association
+      // is given
+      if (status != STATUS_OK || par->m_prevCatName.length() < 1)
+        continue;
+
+      // Incremental association needs the previous checkpoint and is not
+      // available in sharded mode
+      if (par->m_prevChkFile.length() < 1) {
+        status = STATUS_PAR_BAD_PARAMETER;
+        if (par->logTerse())
+          Log(Error_2, "%d : Incremental association requires the checkpoint"
+              " file of the previous association (prevChkFile).",
+              (Status)status);
+        continue;
+      }
+      if (par->m_numShards > 1) {
+        if (par->logTerse())
+          Log(Warning_2, " Incremental association is not available in"
+              " sharded mode; associate all sources.");
+        continue;
+      }
+      if (par->m_srcQtyUsed) {
+        if (par->logTerse())
+          Log(Warning_2, " Association formulas reference source catalogue"
+              " quantities (%s...), which may have changed; associate all"
+              " sources.", par->m_srcCatPrefix.c_str());
+        continue;
+      }
+
+      // Load previous source catalogue
+      status = get_input_descriptor(par, par->m_prevCatName, &prev, status);
+      status = get_input_catalogue(par, &prev, par->m_srcPosError, status);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to load previous source catalogue '%s'.",
+              (Status)status, par->m_prevCatName.c_str());
+        continue;
+      }
+
+      // Index previous and current sources by name (duplicate names are
+      // never matched)
+      for (int j = 0; j < prev.numLoad; ++j) {
+        std::string name = prev.object[j].name;
+        index[name] = (index.find(name) == index.end()) ? j : -1;
+      }
+      for (int k = 0; k < m_src.numLoad; ++k)
+        current[m_src.object[k].name] = k;
+
+      // Map unchanged previous sources to current sources
+      map = std::vector<int>(prev.numLoad, -1);
+      for (int k = 0; k < m_src.numLoad; ++k) {
+
+        // Skip sources that are already done
+        if (done[k])
+          continue;
+
+        // Find previous source
+        std::map<std::string, int>::iterator it =
+          index.find(m_src.object[k].name);
+        if (it == index.end() || it->second < 0) {
+          numAdded++;
+          continue;
+        }
+        ObjectInfo *obj = &(m_src.object[k]);
+        ObjectInfo *old = &(prev.object[it->second]);
+
+        // Check position and error ellipse
+        int same = (obj->pos_valid && old->pos_valid);
+        if (same) {
+          double ddec = (obj->pos_eq_dec - old->pos_eq_dec) * deg2rad;
+          double dra  = (obj->pos_eq_ra  - old->pos_eq_ra)  * deg2rad;
+          double arg  = sin(0.5*ddec) * sin(0.5*ddec) +
+                        cos(obj->pos_eq_dec * deg2rad) *
+                        cos(old->pos_eq_dec * deg2rad) *
+                        sin(0.5*dra) * sin(0.5*dra);
+          double sep  = 2.0 * asin(sqrt((arg < 1.0) ? arg : 1.0)) * rad2deg;
+          same = (sep <= par->m_prevTol &&
+                  obj->pos_err_maj == old->pos_err_maj &&
+                  obj->pos_err_min == old->pos_err_min &&
+                  obj->pos_err_ang == old->pos_err_ang);
+        }
+        if (!same) {
+          numMoved++;
+          continue;
+        }
+
+        // Map source
+        map[it->second] = k;
+
+      } // endfor: looped over sources
+
+      // Count removed sources
+      for (int j = 0; j < prev.numLoad; ++j) {
+        if (current.find(prev.object[j].name) == current.end())
+          numGone++;
+      }
+
+      // Restore unchanged sources from previous checkpoint
+      std::vector<char> before = done;
+      status = chk_read(par, par->m_prevChkFile, done, numDone, offset, valid,
+                        status, &map);
+      if (status != STATUS_OK)
+        continue;
+      if (!valid && par->logTerse())
+        Log(Warning_2, " Checkpoint file '%s' not found or not matching;"
+            " associate all sources.", par->m_prevChkFile.c_str());
+
+      // Write reused sources to checkpoint of this association
+      for (int k = 0; k < m_src.numLoad; ++k) {
+        if (done[k] && !before[k])
+          pending.push_back(k);
+      }
+      status = chk_write(par, pending, status);
+
+      // Dump incremental association statistics
+      if (par->logNormal()) {
+        Log(Log_2, " Added sources ....................: %ld", numAdded);
+        Log(Log_2, " Removed sources ..................: %ld", numGone);
+        Log(Log_2, " Moved or changed sources .........: %ld", numMoved);
+        Log(Log_2, " Reused sources from previous run .: %ld of %ld",
+            numDone, m_src.numLoad);
+      }
+
+    } while (0); // End of main do-loop
+
+    // Free previous source catalogue
+    if (prev.object != NULL) delete [] prev.object;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::chk_prev (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Flag sources outside the shard of a sharded worker
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in,out] done Flags the sources that need not be processed.
+ * @param[out] num Number of sources in the shard.
+ * @param[in] status Error status.
+ *
+ * The sky is divided into the pixels of an equatorial NESTED HEALPix map
+ * with at least 8 pixels per shard. Consecutive pixel ranges, which form
+ * compact sky regions, are assigned to the shards. Sources without
+ * position belong to shard 0.
+ *
+ * No counterpart halo is needed as each worker loads the full counterpart
+ * catalogue, so that the refine step results of a source do not depend on
+ * the shard. Counterparts shared by sources of different shards are
+ * reconciled by the merge step, which computes the catalogue association
+ * probabilities over the sources of all shards.
+ ******************************************************************************/
+Status Catalogue::chk_shard(Parameters *par, std::vector<char> &done,
+                            long &num, Status status) {
+
+    // Initialise number of sources
+    num = 0;
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Check shard
+      if (par->m_shard < 0 || par->m_shard >= par->m_numShards) {
+        status = STATUS_PAR_BAD_PARAMETER;
+        if (par->logTerse())
+          Log(Error_2, "%d : Invalid shard %d (expect 0-%d).",
+              (Status)status, par->m_shard, par->m_numShards-1);
+        continue;
+      }
+
+      // Setup shard map
+      int nside = 1;
+      while (12 * nside * nside < 8 * par->m_numShards && nside < 8192)
+        nside *= 2;
+      GHealpix map(nside, "NESTED", "EQU");
+      long     npix = map.npix();
+
+      // Flag sources outside of shard
+      for (int k = 0; k < m_src.numLoad; ++k) {
+        int shard = 0;
+        if (m_src.object[k].pos_valid) {
+          GSkyDir dir;
+          dir.radec_deg(m_src.object[k].pos_eq_ra, m_src.object[k].pos_eq_dec);
+          shard = int(map.ang2pix(dir) * (long)par->m_numShards / npix);
+        }
+        if (shard != par->m_shard)
+          done[k] = 1;
+        else if (!done[k])
+          num++;
+      }
+
+    } while (0); // End of main do-loop
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Return checkpoint file name
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] shard Shard.
+ *
+ * In sharded mode the shard number replaces a "%d" in chkFile; without
+ * "%d" it is appended as ".<shard>".
+ ******************************************************************************/
+std::string Catalogue::chk_filename(Parameters *par, int shard) {
+
+    // Return plain file name if not sharded
+    if (par->m_numShards < 2)
+      return par->m_chkFile;
+
+    // Build shard file name
+    std::ostringstream number;
+    number << shard;
+    std::string            filename = par->m_chkFile;
+    std::string::size_type pos      = filename.find("%d");
+    if (pos != std::string::npos)
+      filename.replace(pos, 2, number.str());
+    else
+      filename += "." + number.str();
+
+    // Return file name
+    return filename;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Append sources to checkpoint file
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in,out] pending Indices of sources to be written (cleared on exit).
+ * @param[in] status Error status.
+ *
+ * Writes the refine step results and selection statistics of the pending
+ * sources and flushes the checkpoint file. A write failure only disables
+ * further checkpointing, as the association itself is not affected.
+ ******************************************************************************/
+Status Catalogue::chk_write(Parameters *par, std::vector<int> &pending,
+                            Status status) {
+
+    // Declare local variables
+    ChkRecord rec;
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error or if no checkpoint is open
+      if (status != STATUS_OK || m_chk_file == NULL)
+        continue;
+
+      // Write source records
+      int ok = 1;
+      for (int i = 0; i < (int)pending.size() && ok; ++i) {
+        SourceInfo *src  = &(m_info[pending[i]]);
+        memset(&rec, 0, sizeof(rec));
+        rec.iSrc         = src->iSrc;
+        rec.numFilter    = src->numFilter;
+        rec.numPrune     = src->numPrune;
+        rec.numSelect    = (src->cc != NULL) ? src->numSelect : 0;
+        rec.numRefine    = (src->cc != NULL) ? src->numRefine : 0;
+        rec.numSweep     = (src->cc != NULL) ? src->numSweep  : 0;
+        rec.filter_rad   = src->filter_rad;
+        rec.ring_rad_min = src->ring_rad_min;
+        rec.ring_rad_max = src->ring_rad_max;
+        rec.omega        = src->omega;
+        ok = (fwrite(&rec, sizeof(rec), 1, m_chk_file) == 1 &&
+              fwrite(src->cc, sizeof(CCElement), rec.numSelect, m_chk_file) ==
+                                                     (size_t)rec.numSelect &&
+              fwrite(&(m_cpt_stat[src->iSrc*(m_num_Sel+1)]), sizeof(int),
+                     m_num_Sel+1, m_chk_file) == (size_t)(m_num_Sel+1));
+      }
+
+      // Flush checkpoint
+      if (ok)
+        ok = (fflush(m_chk_file) == 0);
+
+      // Disable checkpointing in case of a write failure
+      if (!ok) {
+        if (par->logTerse())
+          Log(Warning_2, " Unable to write checkpoint file '%s'; checkpointing"
+              " disabled.", par->m_chkFile.c_str());
+        chk_close();
+      }
+
+    } while (0); // End of main do-loop
+
+    // Clear pending sources
+    pending.clear();
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Close checkpoint file
+ ******************************************************************************/
+void Catalogue::chk_close(void) {
+
+    // Close file
+    if (m_chk_file != NULL) {
+      fclose(m_chk_file);
+      m_chk_file = NULL;
+    }
+
+    // Return
+    return;
+
+}
+
+
+/* Namespace ends ___________________________________________________________ */
+}
@@ -118,9 +118,12 @@ creation and allow in memory catalogues and FITS disk catalogues.
 
 /* Includes _________________________________________________________________ */
 #include <cstring>
+#include <limits>
 #include "sourceIdentify.h"
 #include "Catalogue.h"
 #include "Log.h"
+#include "Profile.h"
+#include "Trace.h"
 
 
 /* Definitions ______________________________________________________________ */
@@ -647,6 +650,24 @@ Status Catalogue::cfits_create(fitsfile **fptr, char *filename, Parameters *par,
           m_src_Qty_tform.push_back(form);
           m_src_Qty_tunit.push_back(qtyUnits[iQty]);
           m_src_Qty_tbucd.push_back(qtyUCDs[iQty]);
+          m_src_Qty_table.push_back(-1);
+        }
+      }
+
+      // Add source columns of in-memory catalogue
+      if (m_src.table != NULL) {
+        for (iQty = 0; iQty < (long)m_src.table->colNames.size(); iQty++) {
+          if ((par->m_srcCatQty.find("*", 0) != std::string::npos) ||
+              (par->m_srcCatQty.find(m_src.table->colNames[iQty], 0) !=
+               std::string::npos)) {
+            m_num_src_Qty++;
+            num_col++;
+            m_src_Qty_ttype.push_back(m_src.table->colNames[iQty]);
+            m_src_Qty_tform.push_back("1D");
+            m_src_Qty_tunit.push_back("");
+            m_src_Qty_tbucd.push_back("");
+            m_src_Qty_table.push_back(iQty);
+          }
         }
       }
 
@@ -671,6 +692,24 @@ Status Catalogue::cfits_create(fitsfile **fptr, char *filename, Parameters *par,
           m_cpt_Qty_tform.push_back(form);
           m_cpt_Qty_tunit.push_back(qtyUnits[iQty]);
           m_cpt_Qty_tbucd.push_back(qtyUCDs[iQty]);
+          m_cpt_Qty_table.push_back(-1);
+        }
+      }
+
+      // Add counterpart columns of in-memory catalogue
+      if (m_cpt.table != NULL) {
+        for (iQty = 0; iQty < (long)m_cpt.table->colNames.size(); iQty++) {
+          if ((par->m_cptCatQty.find("*", 0) != std::string::npos) ||
+              (par->m_cptCatQty.find(m_cpt.table->colNames[iQty], 0) !=
+               std::string::npos)) {
+            m_num_cpt_Qty++;
+            num_col++;
+            m_cpt_Qty_ttype.push_back(m_cpt.table->colNames[iQty]);
+            m_cpt_Qty_tform.push_back("1D");
+            m_cpt_Qty_tunit.push_back("");
+            m_cpt_Qty_tbucd.push_back("");
+            m_cpt_Qty_table.push_back(iQty);
+          }
         }
       }
 
@@ -1126,9 +1165,10 @@ Status Catalogue::cfits_add(fitsfile *fptr, Parameters *par, SourceInfo *src,
       if (status != STATUS_OK)
         continue;
 
-      // Add unique counterpart identifier
+      // Add unique counterpart identifier. The identifier is built from the
+      // source number and the rank of the candidate.
       for (row = 0; row < nrows; row++)
-        sprintf(cptr[row], "%s", src->cc[row].id.c_str());
+        sprintf(cptr[row], OUTCAT_COL_ID_FMT, src->iSrc+1, int(row)+1);
       fstatus = fits_write_col_str(fptr, OUTCAT_COL_ID_COLNUM, 
                                    frow, 1, nrows, cptr, &fstatus);
       if (fstatus != 0) {
@@ -1140,7 +1180,7 @@ Status Catalogue::cfits_add(fitsfile *fptr, Parameters *par, SourceInfo *src,
 
       // Add Counterpart Right Ascention
       for (row = 0; row < nrows; row++)
-        dptr[row] = src->cc[row].pos_eq_ra;
+        dptr[row] = m_cpt.object[src->cc[row].index].pos_eq_ra;
       fstatus = fits_write_col(fptr, TDOUBLE, OUTCAT_COL_RA_COLNUM,
                                frow, 1, nrows, dptr, &fstatus);
       if (fstatus != 0) {
@@ -1152,7 +1192,7 @@ Status Catalogue::cfits_add(fitsfile *fptr, Parameters *par, SourceInfo *src,
 
       // Add Counterpart Declination
       for (row = 0; row < nrows; row++)
-        dptr[row] = src->cc[row].pos_eq_dec;
+        dptr[row] = m_cpt.object[src->cc[row].index].pos_eq_dec;
       fstatus = fits_write_col(fptr, TDOUBLE, OUTCAT_COL_DEC_COLNUM,
                                frow, 1, nrows, dptr, &fstatus);
       if (fstatus != 0) {
@@ -1164,7 +1204,7 @@ Status Catalogue::cfits_add(fitsfile *fptr, Parameters *par, SourceInfo *src,
 
       // Add Counterpart Error Ellipse Major Axis
       for (row = 0; row < nrows; row++)
-        dptr[row] = src->cc[row].pos_err_maj;
+        dptr[row] = m_cpt.object[src->cc[row].index].pos_err_maj;
       fstatus = fits_write_col(fptr, TDOUBLE, OUTCAT_COL_MAJERR_COLNUM,
                                frow, 1, nrows, dptr, &fstatus);
       if (fstatus != 0) {
@@ -1176,7 +1216,7 @@ Status Catalogue::cfits_add(fitsfile *fptr, Parameters *par, SourceInfo *src,
 
       // Add Counterpart Error Ellipse Minor Axis
       for (row = 0; row < nrows; row++)
-        dptr[row] = src->cc[row].pos_err_min;
+        dptr[row] = m_cpt.object[src->cc[row].index].pos_err_min;
       fstatus = fits_write_col(fptr, TDOUBLE, OUTCAT_COL_MINERR_COLNUM,
                                frow, 1, nrows, dptr, &fstatus);
       if (fstatus != 0) {
@@ -1188,7 +1228,7 @@ Status Catalogue::cfits_add(fitsfile *fptr, Parameters *par, SourceInfo *src,
 
       // Add Counterpart Error Ellipse Position Angle
       for (row = 0; row < nrows; row++)
-        dptr[row] = src->cc[row].pos_err_ang;
+        dptr[row] = m_cpt.object[src->cc[row].index].pos_err_ang;
       fstatus = fits_write_col(fptr, TDOUBLE, OUTCAT_COL_POSANGLE_COLNUM,
                                frow, 1, nrows, dptr, &fstatus);
       if (fstatus != 0) {
@@ -1429,7 +1469,10 @@ Status Catalogue::cfits_add(fitsfile *fptr, Parameters *par, SourceInfo *src,
 
         // Add double precision numerical quantities
         else if (form.find("D", 0) != std::string::npos) {
-          m_src.cat.getNValue(name, src->iSrc, &NValue);
+          if (m_src_Qty_table[iQty] >= 0)
+            NValue = m_src.table->colData[m_src_Qty_table[iQty]][src->iSrc];
+          else
+            m_src.cat.getNValue(name, src->iSrc, &NValue);
           for (row = 0; row < nrows; row++)
             dptr[row] = NValue;
           fstatus = fits_write_col(fptr, TDOUBLE, colnum, frow, 1, nrows,
@@ -1493,7 +1536,10 @@ Status Catalogue::cfits_add(fitsfile *fptr, Parameters *par, SourceInfo *src,
         else if (form.find("D", 0) != std::string::npos) {
           for (row = 0; row < nrows; row++) {
             iCpt = src->cc[row].index;
-            m_cpt.cat.getNValue(name, iCpt, &NValue);
+            if (m_cpt_Qty_table[iQty] >= 0)
+              NValue = m_cpt.table->colData[m_cpt_Qty_table[iQty]][iCpt];
+            else
+              m_cpt.cat.getNValue(name, iCpt, &NValue);
             dptr[row] = NValue;
           }
           fstatus = fits_write_col(fptr, TDOUBLE, colnum, frow, 1, nrows,
@@ -1562,8 +1608,15 @@ Status Catalogue::cfits_add(fitsfile *fptr, Parameters *par, SourceInfo *src,
  * @param[in] fptr Pointer to FITS file.
  * @param[in] par Pointer to gtsrcid parameters.
  * @param[in] status Error status.
+ * @param[in] lazy Only evaluate quantities used in the association.
+ *
+ * In lazy mode only the quantities that are referenced by a selection, the
+ * prior, the FoM or the probability formula are evaluated (see
+ * Parameters::compile_formulas). This is used for the in-memory catalogue,
+ * while the output catalogue gets all quantities.
  ******************************************************************************/
-Status Catalogue::cfits_eval(fitsfile *fptr, Parameters *par, Status status) {
+Status Catalogue::cfits_eval(fitsfile *fptr, Parameters *par, Status status,
+                             int lazy) {
 
     // Debug mode: Entry
     if (par->logDebug())
@@ -1589,15 +1642,56 @@ Status Catalogue::cfits_eval(fitsfile *fptr, Parameters *par, Status status) {
       if (numRows < 1)
         continue;
 
+      // Determine the quantities to be evaluated
+      std::vector<int> eval(numQty, 1);
+      std::vector<int> ids = par->m_outCatQtyId;
+      if (lazy) {
+        for (int iQty = 0; iQty < numQty; ++iQty) {
+          if (!par->m_outCatQtyUsed[iQty]) {
+            eval[iQty] = 0;
+            ids[iQty]  = -1;
+          }
+        }
+      }
+
+      // Evaluate all compiled quantities in one pass of the formula plan
+      std::vector<std::vector<double> > res;
+      std::vector<FormulaType>          types;
+      status = cfits_eval_plan(fptr, par, ids, res, types, status);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to evaluate formula plan.",
+              (Status)status);
+        continue;
+      }
+
       // Add all new output catalogue quantities
       for (int iQty = 0; iQty < numQty; ++iQty) {
 
+        // Skip quantities that are not needed
+        if (!eval[iQty])
+          continue;
+
         // Get column and formula
         std::string column  = par->m_outCatQtyName[iQty];
         std::string formula = par->m_outCatQtyFormula[iQty];
 
-        // Evaluate column
-        status = cfits_eval_column(fptr, par,column, formula, status);
+        // Write floating point quantities from the plan. All other
+        // quantities are evaluated by the CFITSIO calculator, which sets the
+        // column format from the formula
+        if (types[iQty] == Fml_Double && (long)res[iQty].size() == numRows) {
+          status = cfits_set_col(fptr, par, column, res[iQty], status);
+          if (status == STATUS_OK && par->logVerbose()) {
+            Log(Log_2, "    New quantity ..................: %s = %s",
+                column.c_str(), formula.c_str());
+          }
+        }
+        else
+          status = cfits_eval_column(fptr, par,column, formula, status);
+
+        // Debug mode: check plan against CFITSIO calculator
+        if (par->logDebug() && types[iQty] != Fml_Invalid)
+          status = cfits_check_plan(fptr, par, formula, res[iQty], status);
         if (status != STATUS_OK) {
           if (par->logTerse())
             Log(Error_2, "%d : Unable to evaluate expression <%s='%s'> in"
@@ -1649,6 +1743,10 @@ Status Catalogue::cfits_eval_column(fitsfile *fptr, Parameters *par,
     if (par->logDebug())
       Log(Log_0, " ==> ENTRY: Catalogue::cfits_eval_column");
 
+    // Start profiling
+    ProfileStart(Prof_Eval);
+    TraceBegin("cfitsio", "cfits_eval_column");
+
     // Single loop for common exit point
     do {
 
@@ -1693,6 +1791,11 @@ Status Catalogue::cfits_eval_column(fitsfile *fptr, Parameters *par,
 
     } while (0); // End of main do-loop
 
+    // Stop profiling
+    TraceEnd("cfitsio", "cfits_eval_column", "\"column\": \"%s\"",
+             TraceEnabled() ? TraceEscape(column).c_str() : "");
+    ProfileStop(Prof_Eval, 0);
+
     // Debug mode: Entry
     if (par->logDebug())
       Log(Log_0, " <== EXIT: Catalogue::cfits_eval_column"
@@ -1704,6 +1807,350 @@ Status Catalogue::cfits_eval_column(fitsfile *fptr, Parameters *par,
 }
 
 
+/**************************************************************************//**
+ * @brief Evaluate compiled formulas
+ *
+ * @param[in] fptr Pointer to FITS file.
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] ids Plan indices of formulas (-1 for formulas not in the plan).
+ * @param[out] res Formula values.
+ * @param[out] types Formula result types.
+ * @param[in] status Error status.
+ *
+ * Evaluates formulas of the compiled formula plan over all rows of the
+ * catalogue. The columns used by the formulas are read once, and every
+ * node of the plan is evaluated only once.
+ *
+ * Formulas that use columns that do not exist or that are no numerical
+ * scalar columns get an empty result vector and the type Fml_Invalid. They
+ * have to be evaluated by the CFITSIO calculator (which will also report
+ * the errors).
+ ******************************************************************************/
+Status Catalogue::cfits_eval_plan(fitsfile *fptr, Parameters *par,
+                                  const std::vector<int> &ids,
+                                  std::vector<std::vector<double> > &res,
+                                  std::vector<FormulaType> &types,
+                                  Status status) {
+
+    // Declare local variables
+    int                               fstatus;
+    long                              numRows;
+    std::vector<std::string>          names;
+    std::vector<FormulaType>          col_types;
+    std::vector<std::vector<double> > col_values;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::cfits_eval_plan");
+
+    // Start profiling
+    ProfileStart(Prof_Eval);
+
+    // Initialise results
+    res   = std::vector<std::vector<double> >(ids.size());
+    types = std::vector<FormulaType>(ids.size(), Fml_Invalid);
+
+    // Initialise FITSIO status
+    fstatus = (int)status;
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Determine number of rows in table. Fall through if there are none
+      fstatus = fits_get_num_rows(fptr, &numRows, &fstatus);
+      if (fstatus != 0) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to determine number of rows in"
+              " catalogue.", fstatus);
+        continue;
+      }
+      if (numRows < 1)
+        continue;
+
+      // Get names of columns used by the formulas
+      par->m_plan.columns(ids, names);
+      int numCols = (int)names.size();
+      col_types   = std::vector<FormulaType>(numCols, Fml_Invalid);
+      col_values  = std::vector<std::vector<double> >(numCols);
+
+      // Read columns
+      for (int iCol = 0; iCol < numCols; ++iCol) {
+
+        // Get column number. Skip columns that do not exist
+        int colnum;
+        fstatus = fits_get_colnum(fptr, CASEINSEN, (char*)names[iCol].c_str(),
+                                  &colnum, &fstatus);
+        if (fstatus != 0) {
+          fstatus = 0;
+          continue;
+        }
+
+        // Get column type. Skip vector and non-numerical columns
+        int  typecode;
+        long repeat;
+        long width;
+        fstatus = fits_get_eqcoltype(fptr, colnum, &typecode, &repeat, &width,
+                                     &fstatus);
+        if (fstatus != 0 || repeat != 1) {
+          fstatus = 0;
+          continue;
+        }
+        if (typecode == TFLOAT || typecode == TDOUBLE)
+          col_types[iCol] = Fml_Double;
+        else if (typecode == TLOGICAL)
+          col_types[iCol] = Fml_Bool;
+        else if (typecode == TBYTE  || typecode == TSBYTE  ||
+                 typecode == TSHORT || typecode == TUSHORT ||
+                 typecode == TINT   || typecode == TUINT   ||
+                 typecode == TLONG  || typecode == TULONG  ||
+                 typecode == TLONGLONG)
+          col_types[iCol] = Fml_Long;
+        else
+          continue;
+
+        // Read column values. NULL values are read as NaN, so that they
+        // propagate through the plan as in the CFITSIO calculator
+        int    anynul;
+        double nulval = std::numeric_limits<double>::quiet_NaN();
+        col_values[iCol] = std::vector<double>(numRows);
+        fstatus = fits_read_col(fptr, TDOUBLE, colnum, 1, 1, numRows, &nulval,
+                                &(col_values[iCol][0]), &anynul, &fstatus);
+        if (fstatus != 0) {
+          if (par->logTerse())
+            Log(Error_2, "%d : Unable to read data from column %s in"
+                " catalogue.", fstatus, names[iCol].c_str());
+          break;
+        }
+
+      } // endfor: looped over columns
+      if (fstatus != 0)
+        continue;
+
+      // Evaluate plan
+      par->m_plan.eval(ids, numRows, names, col_types, col_values,
+                       double(m_src.numTotal), double(m_cpt.numTotal),
+                       res, types);
+
+    } while (0); // End of main do-loop
+
+    // Set FITSIO status
+    if (status == STATUS_OK)
+      status = (Status)fstatus;
+
+    // Stop profiling
+    ProfileStop(Prof_Eval, 0);
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::cfits_eval_plan"
+          " (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Evaluate formula
+ *
+ * @param[in] fptr Pointer to FITS file.
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] column Name of the column (used by the CFITSIO calculator).
+ * @param[in] formula Formula to be evaluated.
+ * @param[in] id Plan index of formula (-1 if the formula is not in the plan).
+ * @param[out] res Formula values.
+ * @param[in] status Error status.
+ *
+ * Evaluates the formula using the compiled formula plan. If this is not
+ * possible, the formula is evaluated by the CFITSIO calculator into the
+ * specified column, and the column is returned.
+ ******************************************************************************/
+Status Catalogue::cfits_eval_formula(fitsfile *fptr, Parameters *par,
+                                     std::string column, std::string formula,
+                                     int id, std::vector<double> &res,
+                                     Status status) {
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::cfits_eval_formula");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Evaluate formula plan
+      if (id >= 0) {
+        std::vector<int>                  ids(1, id);
+        std::vector<std::vector<double> > values;
+        std::vector<FormulaType>          types;
+        status = cfits_eval_plan(fptr, par, ids, values, types, status);
+        if (status != STATUS_OK)
+          continue;
+        if (types[0] != Fml_Invalid) {
+          res = values[0];
+          if (par->logDebug())
+            status = cfits_check_plan(fptr, par, formula, res, status);
+          continue;
+        }
+      }
+
+      // ... otherwise evaluate column using CFITSIO calculator
+      status = cfits_eval_column(fptr, par, column, formula, status);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to evaluate expression <%s='%s'> in"
+                       " formula.",
+                       (Status)status, column.c_str(), formula.c_str());
+        continue;
+      }
+
+      // Extract column
+      status = cfits_get_col(fptr, par, column, res, status);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to extract column <%s> from"
+                       "in-memory FITS catalogue.",
+                       (Status)status, column.c_str());
+        continue;
+      }
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::cfits_eval_formula"
+          " (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Check formula plan result against CFITSIO calculator
+ *
+ * @param[in] fptr Pointer to FITS file.
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] formula Formula.
+ * @param[in] res Formula values obtained from the compiled formula plan.
+ * @param[in] status Error status.
+ *
+ * Evaluates the formula by the CFITSIO calculator into a temporary column
+ * and compares the result to the plan values (NULL values have to match
+ * NaN). Differences, e.g. due to a different operator precedence, are
+ * reported as warning. The check is only done in debug mode.
+ ******************************************************************************/
+Status Catalogue::cfits_check_plan(fitsfile *fptr, Parameters *par,
+                                   std::string formula,
+                                   const std::vector<double> &res,
+                                   Status status) {
+
+    // Declare local variables
+    int                 fstatus;
+    int                 colnum;
+    int                 anynul;
+    long                numRows;
+    long                numDiff = 0;
+    long                first   = -1;
+    double              nulval  = std::numeric_limits<double>::quiet_NaN();
+    std::string         column  = "_plan_check";
+    std::vector<double> ref;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::cfits_check_plan");
+
+    // Initialise FITSIO status
+    fstatus = (int)status;
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Determine number of rows in table. Fall through if it does not
+      // match the plan result
+      fstatus = fits_get_num_rows(fptr, &numRows, &fstatus);
+      if (fstatus != 0 || numRows < 1 || (long)res.size() != numRows)
+        continue;
+
+      // Evaluate formula using CFITSIO calculator
+      status = cfits_eval_column(fptr, par, column, formula, status);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to evaluate expression <%s='%s'> in"
+                       " formula.",
+                       (Status)status, column.c_str(), formula.c_str());
+        continue;
+      }
+
+      // Read result column
+      ref     = std::vector<double>(numRows);
+      fstatus = fits_get_colnum(fptr, CASESEN, (char*)column.c_str(), &colnum,
+                                &fstatus);
+      fstatus = fits_read_col(fptr, TDOUBLE, colnum, 1, 1, numRows, &nulval,
+                              &(ref[0]), &anynul, &fstatus);
+      fstatus = fits_delete_col(fptr, colnum, &fstatus);
+      if (fstatus != 0) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to read and remove column %s.",
+              fstatus, column.c_str());
+        continue;
+      }
+
+      // Compare results
+      for (long row = 0; row < numRows; ++row) {
+        double a = res[row];
+        double b = ref[row];
+        if (a != a && b != b)
+          continue;
+        double tol = 1.0e-10 * ((fabs(a) > fabs(b)) ? fabs(a) : fabs(b));
+        if (fabs(a - b) <= tol)
+          continue;
+        if (first < 0)
+          first = row;
+        numDiff++;
+      }
+
+      // Report differences
+      if (numDiff > 0) {
+        if (par->logTerse())
+          Log(Warning_2, " Formula plan differs from CFITSIO calculator for"
+              " <%s> in %ld rows (row %ld: %e != %e).",
+              formula.c_str(), numDiff, first+1, res[first], ref[first]);
+      }
+      else
+        Log(Log_0, "  Formula plan matches CFITSIO calculator for <%s>.",
+            formula.c_str());
+
+    } while (0); // End of main do-loop
+
+    // Set FITSIO status
+    if (status == STATUS_OK)
+      status = (Status)fstatus;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::cfits_check_plan"
+          " (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
 /**************************************************************************//**
  * @brief Evaluate special expressions in formula
  *
@@ -2165,8 +2612,9 @@ Status Catalogue::cfits_update(fitsfile *fptr, Parameters *par, SourceInfo *src,
         continue;
       }
 
-        // Evaluate in-memory catalogue quantities
-        status = cfits_eval(m_memFile, par, status);
+        // Evaluate in-memory catalogue quantities that are used in the
+        // association (all quantities are evaluated for the output catalogue)
+        status = cfits_eval(m_memFile, par, status, 1);
         if (status != STATUS_OK) {
           if (par->logTerse())
             Log(Error_2, "%d : Unable to evaluate new quantities in in-memory"
@@ -2194,12 +2642,18 @@ Status Catalogue::cfits_update(fitsfile *fptr, Parameters *par, SourceInfo *src,
  * @param[in] par Pointer to gtsrcid parameters.
  * @param[in] src Pointer of source information.
  * @param[in] status Error status.
+ * @param[in] post Apply criteria of reselection step (see
+ *                 Parameters::plan_select).
  *
  * Performs table row selection for one specific catalogue source. The result
  * of the selection process is stored in the m_cpt_stat table.
+ *
+ * Only the criteria of the given step are applied. In the selection step,
+ * the criteria of the reselection step keep the current number of
+ * counterparts in m_cpt_stat, until the reselection step updates them.
  ******************************************************************************/
 Status Catalogue::cfits_select(fitsfile *fptr, Parameters *par, SourceInfo *src,
-                               Status status) {
+                               Status status, int post) {
 
     // Declare local variables
     int  fstatus;
@@ -2243,6 +2697,16 @@ Status Catalogue::cfits_select(fitsfile *fptr, Parameters *par, SourceInfo *src,
         if (numBefore < 1)
           break;
 
+        // Skip criteria of the other step. In the selection step, the
+        // criteria of the reselection step keep the current number
+        // (including the pruned candidates, see Catalogue::cid_prune)
+        if (par->m_selectPost[iSel] != post) {
+          if (!post)
+            m_cpt_stat[src->iSrc*(m_num_Sel+1) + iSel+1] = numBefore +
+                                                           src->numPrune;
+          continue;
+        }
+
         // Perform selection
         fstatus = fits_select_rows(fptr, fptr,
                                    (char*)par->m_select[iSel].c_str(),
@@ -2482,9 +2946,9 @@ Status Catalogue::cfits_collect(fitsfile *fptr, Parameters *par,
       for (int i = 0; i < (int)col_id.size(); ++i) {
 
         // Get source number. Note that we have to subtract 1 since the
-        // sources index starts with 1
-        std::string src_row = col_id[i].substr(3,5);
-        int         iSrc    = atoi(src_row.c_str()) - 1;
+        // sources index starts with 1. The number is read up to the next
+        // underscore so that more than 99999 sources are supported.
+        int iSrc = (col_id[i].length() > 3) ? atoi(col_id[i].c_str()+3) - 1 : -1;
 
         // Fall through if index is invalid
         if (iSrc < 0 || iSrc >= m_src.numLoad)
@@ -2974,6 +3438,112 @@ Status Catalogue::cfits_set_pars(fitsfile *fptr, Parameters *par, Status status)
 }
 
 
+/**************************************************************************//**
+ * @brief Append binary table extension to catalogue
+ *
+ * @param[in] fptr Pointer to FITS file.
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] extname Extension name.
+ * @param[in] names Column names.
+ * @param[in] cols Column values (one vector per column, all of equal length).
+ * @param[in] status Error status.
+ *
+ * Appends a binary table with double precision columns at the end of the
+ * FITS file. The new extension becomes the current HDU, hence this method
+ * should only be called once the catalogue table is complete.
+ ******************************************************************************/
+Status Catalogue::cfits_add_table(fitsfile *fptr, Parameters *par,
+                                  char *extname,
+                                  std::vector<std::string> &names,
+                                  std::vector<std::vector<double> > &cols,
+                                  Status status) {
+
+    // Declare local variables
+    int                 fstatus;
+    int                 num_col;
+    int                 num_hdu;
+    std::vector<char*>  ttype;
+    std::vector<char*>  tform;
+    std::vector<char*>  tunit;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::cfits_add_table");
+
+    // Initialise FITSIO status
+    fstatus = (int)status;
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Fall through if there are no columns
+      num_col = (int)names.size();
+      if (num_col < 1 || (int)cols.size() != num_col)
+        continue;
+
+      // Set column definitions
+      for (int col = 0; col < num_col; ++col) {
+        ttype.push_back((char*)names[col].c_str());
+        tform.push_back((char*)"1D");
+        tunit.push_back((char*)"");
+      }
+
+      // Move to end of file
+      fstatus = fits_get_num_hdus(fptr, &num_hdu, &fstatus);
+      fstatus = fits_movabs_hdu(fptr, num_hdu, NULL, &fstatus);
+      if (fstatus != 0) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to move to end of catalogue.", fstatus);
+        continue;
+      }
+
+      // Create binary table
+      fstatus = fits_create_tbl(fptr, BINARY_TBL, 0, num_col,
+                                &(ttype[0]), &(tform[0]), &(tunit[0]),
+                                extname, &fstatus);
+      if (fstatus != 0) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to create table '%s'.", fstatus, extname);
+        continue;
+      }
+
+      // Write columns
+      for (int col = 0; col < num_col; ++col) {
+        long nrows = (long)cols[col].size();
+        if (nrows < 1)
+          continue;
+        fstatus = fits_write_col(fptr, TDOUBLE, col+1, 1, 1, nrows,
+                                 &(cols[col][0]), &fstatus);
+        if (fstatus != 0) {
+          if (par->logTerse())
+            Log(Error_2, "%d : Unable to write column '%s' to table '%s'.",
+                fstatus, names[col].c_str(), extname);
+          break;
+        }
+      }
+      if (fstatus != 0)
+        continue;
+
+    } while (0); // End of main do-loop
+
+    // Set FITSIO status
+    if (status == STATUS_OK)
+      status = (Status)fstatus;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::cfits_add_table (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
 /**************************************************************************//**
  * @brief Save catalogue
  *
@@ -144,16 +144,22 @@ level.
 /* Includes _________________________________________________________________ */
 #include <iostream>
 #include <stdexcept>
+#include <algorithm>
+#include <utility>
+#include <limits>
 #include "sourceIdentify.h"
 #include "Catalogue.h"
 #include "Log.h"
+#include "Profile.h"
+#include "Trace.h"
 
 /* Definitions ______________________________________________________________ */
-#define CATALOGUE_TIMING     0             // Enables timing measurements
 #define JEAN_BALLET_FORMULA  1             // Uses Jean Ballet's formula
 #define ADAPTIVE_DENSITY     1             // Uses adaptive local density
 #define LOW_LEVEL_DEBUG      0             // Enable low-level debugging
 #define FOM_IN_NOMINATOR     0             // Uses FOM in probability nominator
+#define ORDER_MAX_NSIDE      256           // Max. nside of HEALPix order
+#define ORDER_HILBERT_BITS   16            // Bits per axis of Hilbert order
 
 
 /* Namespace definition _____________________________________________________ */
@@ -162,9 +168,24 @@ using namespace catalogAccess;
 
 
 /* Type defintions __________________________________________________________ */
+class CCSortOrder {                    // Candidate sort order
+public:
+  CCSortOrder(const CCElement *cc) : m_cc(cc) {}
+  bool operator()(int a, int b) const {
+    double prob_a = key(m_cc[a].prob);
+    double prob_b = key(m_cc[b].prob);
+    if (prob_a != prob_b)
+      return (prob_a > prob_b);                  // Decreasing probability
+    return (m_cc[a].angsep < m_cc[b].angsep);    // Increasing separation
+  }
+private:
+  static double key(double prob) { return (prob == prob) ? prob : -1.0; }
+  const CCElement *m_cc;
+};
 
 
 /* Private Prototypes _______________________________________________________ */
+static long long cid_hilbert(double ra, double dec);
 
 
 /**************************************************************************//**
@@ -198,6 +219,9 @@ Status Catalogue::cid_source(Parameters *par, SourceInfo *src, Status status) {
     if (par->logDebug())
       Log(Log_0, " ==> ENTRY: Catalogue::cid_source");
 
+    // Begin trace span
+    TraceBegin("source", "cid_source");
+
     // Single loop for common exit point
     do {
 
@@ -205,7 +229,7 @@ Status Catalogue::cid_source(Parameters *par, SourceInfo *src, Status status) {
       if (par->logNormal()) {
         if (src->info->pos_valid) {
           Log(Log_2, " Source %5d .....................: %20s" SRC_FORMAT,
-              src->iSrc+1, src->info->name.c_str(),
+              src->iSrc+1, src->info->name,
               src->info->pos_eq_ra, src->info->pos_eq_dec,
               src->info->pos_err_maj, src->info->pos_err_min,
               src->info->pos_err_ang);
@@ -213,7 +237,7 @@ Status Catalogue::cid_source(Parameters *par, SourceInfo *src, Status status) {
         else {
           Log(Log_2, " Source %5d .....................: %20s"
               " No position information found.",
-              src->iSrc+1, src->info->name.c_str());
+              src->iSrc+1, src->info->name);
         }
       }
 
@@ -233,6 +257,8 @@ Status Catalogue::cid_source(Parameters *par, SourceInfo *src, Status status) {
       // Selection step: Select only relevant counterparts. At this point we
       // cannot do any selection that is based on ANGSEP, but we may do any
       // other downselection that helps reducing the number of counterparts.
+      // Criteria based on ANGSEP or the probabilities are deferred to the
+      // reselection step (see Parameters::plan_select).
       status = cid_select(par, src, status);
       if (status != STATUS_OK) {
         if (par->logTerse())
@@ -251,7 +277,7 @@ Status Catalogue::cid_source(Parameters *par, SourceInfo *src, Status status) {
       }
 
       // Selection step: Select only relevant counterparts. Now we can do selections
-      // based on ANGSEP.
+      // based on ANGSEP (only the criteria not applied in the selection step).
       status = cid_reselect(par, src, status);
       if (status != STATUS_OK) {
         if (par->logTerse())
@@ -264,8 +290,17 @@ Status Catalogue::cid_source(Parameters *par, SourceInfo *src, Status status) {
       if (par->logNormal())
         cid_dump(par, src, status);
 
+      // Return candidates that are not needed by catch-22 to the arena
+      cid_trim(src, src->numSelect);
+
      } while (0); // End of main do-loop
 
+    // End trace span
+    TraceEnd("source", "cid_source",
+             "\"src\": %d, \"numFilter\": %d, \"numSelect\": %d, "
+             "\"numRefine\": %d", src->iSrc+1, src->numFilter,
+             src->numSelect, src->numRefine);
+
     // Debug mode: Entry
     if (par->logDebug())
       Log(Log_0, " <== EXIT: Catalogue::cid_source (status=%d)",
@@ -297,6 +332,9 @@ Status Catalogue::cid_source(Parameters *par, SourceInfo *src, Status status) {
  * and from -m_filter_rad/cos(dec) to +m_filter_rad/cos(dec) in Right
  * Ascension.
  *
+ * Candidates that can never be associated are pruned before they are
+ * materialised (see cid_prune).
+ *
  * This method sets the number of filter step candidates in src->numFilter.
  ******************************************************************************/
 Status Catalogue::cid_filter(Parameters *par, SourceInfo *src, Status status) {
@@ -312,15 +350,6 @@ Status Catalogue::cid_filter(Parameters *par, SourceInfo *src, Status status) {
     double      cpt_ra_min;
     double      cpt_ra_max;
     double      filter_maxsep;
-    ObjectInfo *cpt;
-
-    // Timing measurements
-    #if CATALOGUE_TIMING
-    clock_t t_start_loop;
-    clock_t t_start_tot   = clock();
-    float   t_elapse      = 0.0;
-    float   t_elapse_loop = 0.0;
-    #endif
 
     // Debug mode: Entry
     #if LOW_LEVEL_DEBUG
@@ -329,6 +358,9 @@ Status Catalogue::cid_filter(Parameters *par, SourceInfo *src, Status status) {
     if (par->logDebug())
       Log(Log_0, " ==> ENTRY: Catalogue::cid_filter");
 
+    // Start profiling
+    ProfileStart(Prof_Filter);
+
     // Single loop for common exit point
     do {
 
@@ -373,41 +405,38 @@ Status Catalogue::cid_filter(Parameters *par, SourceInfo *src, Status status) {
       cpt_ra_max = cpt_ra_max - double(long(cpt_ra_max / 360.0) * 360.0);
       if (cpt_ra_max < 0.0) cpt_ra_max += 360.0;
 
-      // Start timing
-      #if CATALOGUE_TIMING
-      t_start_loop = clock();
-      #endif
-
       // Determine number of counterpart candidates that fall in the
-      // bounding box and that have a valid position
+      // bounding box and that have a valid position. Only the declination
+      // zone of the declination index needs to be scanned. The Right
+      // Ascensions are read from the index, which stores them contiguously
+      // in the same order.
+      std::vector<double>::iterator first =
+        std::lower_bound(m_cpt_zone_dec.begin(), m_cpt_zone_dec.end(),
+                         cpt_dec_min);
+      std::vector<double>::iterator last  =
+        std::upper_bound(first, m_cpt_zone_dec.end(), cpt_dec_max);
+      int iFirst     = first - m_cpt_zone_dec.begin();
+      int iLast      = last  - m_cpt_zone_dec.begin();
+      numNoPos       = m_cpt_no_pos;
+      numDec         = (long)m_cpt_zone.size() - (iLast - iFirst);
       src->numFilter = 0;
-      cpt            = m_cpt.object;
-      for (int iCpt = 0; iCpt < m_cpt.numLoad; iCpt++, cpt++) {
-
-        // Filter counterparts that have no positional information
-        if (!cpt->pos_valid) {
-          numNoPos++;
-          continue;
-        }
+      for (int iZone = iFirst; iZone < iLast; ++iZone) {
 
-        // Filter counterpart if it falls outside the declination range.
-        if (cpt->pos_eq_dec < cpt_dec_min ||
-            cpt->pos_eq_dec > cpt_dec_max) {
-          numDec++;
-          continue;
-        }
+        // Get counterpart
+        int    iCpt   = m_cpt_zone[iZone];
+        double cpt_ra = m_cpt_zone_ra[iZone];
 
         // Filter source if it falls outside the Right Ascension range. The
         // first case handles no R.A. wrap around ...
         if (cpt_ra_min < cpt_ra_max) {
-          if (cpt->pos_eq_ra < cpt_ra_min || cpt->pos_eq_ra > cpt_ra_max) {
+          if (cpt_ra < cpt_ra_min || cpt_ra > cpt_ra_max) {
             numRA++;
             continue;
           }
         }
         // ... and this one R.A wrap around
         else {
-          if (cpt->pos_eq_ra < cpt_ra_min && cpt->pos_eq_ra > cpt_ra_max) {
+          if (cpt_ra < cpt_ra_min && cpt_ra > cpt_ra_max) {
             numRA++;
             continue;
           }
@@ -419,13 +448,27 @@ Status Catalogue::cid_filter(Parameters *par, SourceInfo *src, Status status) {
         // Increment number of counterparts
         src->numFilter++;
 
-      } // endfor: looped over all counterpart candidates
+      } // endfor: looped over declination zone
+
+      // Restore catalogue order of counterpart candidates
+      std::sort(m_cpt_sel, m_cpt_sel + src->numFilter);
+
+      // Prune counterpart candidates that can never be associated. Only the
+      // surviving candidates are materialised below, the others are only
+      // counted for the local counterpart density
+      status = cid_prune(par, src, status);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to prune counterpart candidates.",
+              (Status)status);
+        continue;
+      }
 
       // Collect all counterpart candidates
       if (src->numFilter > 0) {
 
         // Allocate memory for counterpart candidates
-        src->cc = new CCElement[src->numFilter];
+        src->cc = cid_alloc(src->numFilter);
         if (src->cc == NULL) {
           status = STATUS_MEM_ALLOC;
           if (par->logTerse())
@@ -435,12 +478,6 @@ Status Catalogue::cid_filter(Parameters *par, SourceInfo *src, Status status) {
 
         // Initialise all counterpart candidates
         for (int i = 0; i < src->numFilter; ++i) {
-          src->cc[i].id               = "NULL";
-          src->cc[i].pos_eq_ra        = 0.0;
-          src->cc[i].pos_eq_dec       = 0.0;
-          src->cc[i].pos_err_maj      = 0.0;
-          src->cc[i].pos_err_min      = 0.0;
-          src->cc[i].pos_err_ang      = 0.0;
           src->cc[i].prob             = 0.0;
           src->cc[i].index            = m_cpt_sel[i];
           src->cc[i].angsep           = 0.0;
@@ -458,9 +495,6 @@ Status Catalogue::cid_filter(Parameters *par, SourceInfo *src, Status status) {
           src->cc[i].likrat           = 0.0;
           src->cc[i].rho              = 0.0;
           src->cc[i].fom              = 0.0;
-          src->cc[i].prob_prod1       = 0.0;
-          src->cc[i].prob_prod2       = 0.0;
-          src->cc[i].prob_norm        = 0.0;
           src->cc[i].likrat_div       = 0;
 
         } // endfor: looped over all counterpart candidates
@@ -468,7 +502,11 @@ Status Catalogue::cid_filter(Parameters *par, SourceInfo *src, Status status) {
 
       // Optionally dump counterpart filter statistics
       if (par->logExplicit()) {
-        Log(Log_2, "  Filter step candidates ..........: %5d", src->numFilter);
+        Log(Log_2, "  Filter step candidates ..........: %5d",
+            src->numFilter + src->numPrune);
+        if (src->numPrune > 0)
+          Log(Log_2, "    Pruned candidates .............: %5d (%d in ring)",
+              src->numPrune, src->numPruneRing);
         if (par->logVerbose()) {
           Log(Log_2, "    Filter bounding box radius ....: %7.3f deg",
               src->filter_rad);
@@ -482,19 +520,11 @@ Status Catalogue::cid_filter(Parameters *par, SourceInfo *src, Status status) {
         if (numNoPos > 0)
           Log(Warning_2, "    No positions ..................: %5d", numNoPos);
       }
-      #if CATALOGUE_TIMING
-      t_elapse_loop += (float)(clock() - t_start_loop) / (float)CLOCKS_PER_SEC;
-      #endif
 
     } while (0); // End of main do-loop
 
-    // Timing measurements
-    #if CATALOGUE_TIMING
-    t_elapse += (float)(clock() - t_start_tot) / (float)CLOCKS_PER_SEC;
-    Log(Log_0, "  Filter step timing ..............:");
-    Log(Log_0, "    Total CPU sec used ............: %.5f", t_elapse);
-    Log(Log_0, "    CPU sec spent in loop .........: %.5f", t_elapse_loop);
-    #endif
+    // Stop profiling
+    ProfileStop(Prof_Filter, src->numFilter);
 
     // Debug mode: Entry
     if (par->logDebug())
@@ -510,6 +540,224 @@ Status Catalogue::cid_filter(Parameters *par, SourceInfo *src, Status status) {
 }
 
 
+/**************************************************************************//**
+ * @brief Prune step of counterpart identification
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] src Pointer to source information.
+ * @param[in] status Error status.
+ *
+ * Drops all filter step candidates whose posterior probability
+ * PROB_POST_SINGLE can never reach the probability threshold of the refine
+ * step. The method works on the counterpart indices in m_cpt_sel, hence
+ * pruned candidates are never materialised as counterpart candidates.
+ *
+ * The best-case posterior probability of a candidate is computed from its
+ * angular separation, the counterpart density and the prior probability,
+ * using the major axis of the source error ellipse as upper limit for the
+ * error ellipse radius in the direction of the candidate. Pruning is only
+ * done when these quantities are exactly known before the selection step,
+ * i.e. if no selection criterion is applied in the selection step, if no
+ * figure of merit is specified, if no catch-22 iteration is requested, if
+ * no prior sweep is requested (a candidate may pass the threshold at a swept
+ * prior, see sweep), and if the prior does not depend on catalogue columns.
+ * Pruned candidates
+ * inside the local counterpart density ring are counted in
+ * src->numPruneRing, so that the local counterpart density is unchanged.
+ *
+ * This method expects src->numFilter counterpart indices in m_cpt_sel. It
+ * sets the number of remaining candidates in src->numFilter and the number
+ * of pruned candidates in src->numPrune.
+ ******************************************************************************/
+Status Catalogue::cid_prune(Parameters *par, SourceInfo *src, Status status) {
+
+    // Declare local variables
+    std::vector<int>                  ids;
+    std::vector<std::string>          names;
+    std::vector<FormulaType>          types;
+    std::vector<std::vector<double> > values;
+    std::vector<std::vector<double> > res;
+    std::vector<FormulaType>          res_types;
+
+    // Debug mode: Entry
+    #if LOW_LEVEL_DEBUG
+    printf(" ==> ENTRY: Catalogue::cid_prune (%d candidates)\n", src->numFilter);
+    #endif
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::cid_prune (%d candidates)",
+          src->numFilter);
+
+    // Start profiling
+    ProfileStart(Prof_Prune);
+
+    // Initialise number of pruned candidates
+    src->numPrune     = 0;
+    src->numPruneRing = 0;
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Fall through if there are no counterpart candidates
+      if (src->numFilter < 1)
+        continue;
+
+      // Fall through if the selection step applies any criterion, as the
+      // local counterpart density only counts selected candidates
+      if (par->m_numSelectPost < (int)par->m_select.size())
+        continue;
+
+      // Fall through if a figure of merit is used (the local counterpart
+      // density depends on the FoM of all candidates) or if the prior is
+      // determined by catch-22 iterations
+      if (par->m_FoM.length() > 0 || par->m_catch22)
+        continue;
+
+      // Fall through if a prior sweep is requested
+      if (par->m_sweepPrior.size() > 0)
+        continue;
+
+      // Fall through if there is no probability threshold
+      double prob_thres = (par->m_probThres < c_prob_min) ? par->m_probThres : c_prob_min;
+      if (prob_thres <= 0.0)
+        continue;
+
+      // Fall through if the source has no error ellipse
+      double err_max = src->info->pos_err_maj;
+      if (src->info->pos_err_min > err_max) err_max = src->info->pos_err_min;
+      double norm    = pi * src->info->pos_err_maj * src->info->pos_err_min;
+      if (err_max <= 0.0 || norm <= 0.0)
+        continue;
+
+      // Evaluate prior. Fall through if the prior formula can not be
+      // evaluated without catalogue columns
+      ids.push_back(par->m_probPriorId);
+      if (par->m_probPriorId < 0)
+        continue;
+      par->m_plan.eval(ids, 1, names, types, values,
+                       double(m_src.numTotal), double(m_cpt.numTotal),
+                       res, res_types);
+      if (res_types[0] == Fml_Invalid || res[0].size() != 1)
+        continue;
+      double prior = res[0][0];
+      if (prior >= 1.0)
+        continue;
+
+      // Compute logarithm of prior odds (candidates with a vanishing prior
+      // all have vanishing posterior probabilities)
+      double log_eta = (prior > 0.0) ? log(prior) - log(1.0 - prior) : -1.0e30;
+
+      // Compute angular separations of all candidates and count the
+      // candidates within the local counterpart density ring
+      double              dec         = src->info->pos_eq_dec * deg2rad;
+      double              src_dec_sin = sin(dec);
+      double              src_dec_cos = cos(dec);
+      std::vector<double> angsep(src->numFilter, -1.0);
+      int                 numRing     = 0;
+      for (int iCC = 0; iCC < src->numFilter; ++iCC) {
+        ObjectInfo *cpt = &(m_cpt.object[m_cpt_sel[iCC]]);
+        if (!cpt->pos_valid)
+          continue;
+        double ra_diff = (cpt->pos_eq_ra - src->info->pos_eq_ra) * deg2rad;
+        double dec     = cpt->pos_eq_dec * deg2rad;
+        double arg     = src_dec_sin * sin(dec) +
+                         src_dec_cos * cos(dec) * cos(ra_diff);
+        if (arg <= -1.0)
+          angsep[iCC] = 180.0;
+        else if (arg >= 1.0)
+          angsep[iCC] = 0.0;
+        else
+          angsep[iCC] = acos(arg) * rad2deg;
+        if (angsep[iCC] >= src->ring_rad_min &&
+            angsep[iCC] <= src->ring_rad_max)
+          numRing++;
+      }
+
+      // Compute local counterpart density (see cid_local_density)
+      double rho = 0.0;
+      if (m_has_density == 0) {
+        double omega = twopi * (cos(src->ring_rad_min * deg2rad) -
+                                cos(src->ring_rad_max * deg2rad)) * rad2deg * rad2deg;
+        if (omega > 0.0)
+          rho = double((numRing > 0) ? numRing : 1) / omega;
+      }
+
+      // Set logarithm of threshold
+      double log_thres = log(prob_thres) - c_prune_margin;
+
+      // Keep all candidates that may reach the threshold
+      int num = 0;
+      for (int iCC = 0; iCC < src->numFilter; ++iCC) {
+
+        // Keep candidates without position
+        int keep = (angsep[iCC] < 0.0);
+
+        // Determine best-case logarithm of posterior odds. As PROB_POST_SINGLE
+        // never exceeds the posterior odds, the candidate can be dropped if
+        // the odds are below the threshold
+        if (!keep) {
+
+          // Get counterpart density from map (see cid_map_density)
+          if (m_has_density) {
+            ObjectInfo *cpt = &(m_cpt.object[m_cpt_sel[iCC]]);
+            GSkyDir     dir;
+            dir.radec_deg(cpt->pos_eq_ra, cpt->pos_eq_dec);
+            rho = m_density(m_density.ang2pix(dir));
+          }
+
+          // Compute PDF_CHANCE (see cid_prob_chance). A vanishing PDF_CHANCE
+          // gives a vanishing posterior probability
+          #if JEAN_BALLET_FORMULA
+          double pdf_chance = rho;
+          #else
+          double pdf_chance = rho * exp(-pi * angsep[iCC] * angsep[iCC] * rho);
+          #endif
+          if (pdf_chance > 0.0) {
+            double log_pdf_pos = log(dnorm / norm) -
+                                 dnorm * angsep[iCC] * angsep[iCC] /
+                                 (err_max * err_max);
+            double log_odds    = log_pdf_pos - log(pdf_chance) + log_eta;
+            keep               = (log_odds >= log_thres);
+          }
+        }
+
+        // Keep candidate ...
+        if (keep)
+          m_cpt_sel[num++] = m_cpt_sel[iCC];
+
+        // ... or count pruned candidate within the density ring
+        else if (angsep[iCC] >= src->ring_rad_min &&
+                 angsep[iCC] <= src->ring_rad_max)
+          src->numPruneRing++;
+
+      } // endfor: looped over all counterpart candidates
+
+      // Set number of remaining candidates
+      src->numPrune  = src->numFilter - num;
+      src->numFilter = num;
+
+    } while (0); // End of main do-loop
+
+    // Stop profiling
+    ProfileStop(Prof_Prune, src->numPrune);
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::cid_prune (status=%d)",
+          status);
+    #if LOW_LEVEL_DEBUG
+    printf(" <== EXIT: Catalogue::cid_prune (status=%d)\n", status);
+    #endif
+
+    // Return status
+    return status;
+
+}
+
+
 /**************************************************************************//**
  * @brief Selection step of counterpart identification
  *
@@ -526,7 +774,7 @@ Status Catalogue::cid_filter(Parameters *par, SourceInfo *src, Status status) {
 Status Catalogue::cid_select(Parameters *par, SourceInfo *src, Status status) {
 
     // Declare local variables
-    std::vector<std::string> col_id;
+    std::vector<double> col_ref;
 
     // Debug mode: Entry
     #if LOW_LEVEL_DEBUG
@@ -536,6 +784,9 @@ Status Catalogue::cid_select(Parameters *par, SourceInfo *src, Status status) {
       Log(Log_0, " ==> ENTRY: Catalogue::cid_select (%d candidates)",
           src->numFilter);
 
+    // Start profiling
+    ProfileStart(Prof_Select);
+
     // Single loop for common exit point
     do {
 
@@ -547,17 +798,14 @@ Status Catalogue::cid_select(Parameters *par, SourceInfo *src, Status status) {
       src->numSelect = src->numFilter;
 
       // Store number of counterpart candidates before selection
-      m_cpt_stat[src->iSrc*(m_num_Sel+1)] = src->numFilter;
+      m_cpt_stat[src->iSrc*(m_num_Sel+1)] = src->numFilter + src->numPrune;
 
-      // Fall through if there are no counterpart candidates
-      if (src->numFilter < 1)
+      // Fall through if there are no counterpart candidates. Pruned
+      // candidates pass all criteria of the selection step (see cid_prune)
+      if (src->numFilter < 1) {
+        for (int iSel = 0; iSel < m_num_Sel; ++iSel)
+          m_cpt_stat[src->iSrc*(m_num_Sel+1) + iSel+1] = src->numPrune;
         continue;
-
-      // Set unique counterpart candidate identifier for in-memory catalogue
-      char cid[OUTCAT_MAX_STRING_LEN];
-      for (int iCC = 0; iCC < src->numFilter; ++iCC) {
-        sprintf(cid, "CC_%5.5d_%5.5d", src->iSrc+1, iCC+1);
-        src->cc[iCC].id = cid;
       }
 
       // Update in-memory catalogue
@@ -584,7 +832,7 @@ Status Catalogue::cid_select(Parameters *par, SourceInfo *src, Status status) {
 //      }
 
       // Select counterparts in memory
-      status = cfits_select(m_memFile, par, src, status);
+      status = cfits_select(m_memFile, par, src, status, 0);
       if (status != STATUS_OK) {
         if (par->logTerse())
           Log(Error_2, "%d : Unable to select catalogue counterparts.",
@@ -592,31 +840,38 @@ Status Catalogue::cid_select(Parameters *par, SourceInfo *src, Status status) {
         continue;
       }
 
-      // Get list of counterpart IDs that survived
-      status = cfits_get_col_str(m_memFile, par, OUTCAT_COL_ID_NAME, col_id,
-                                 status);
+      // Fall through if all criteria are applied in the reselection step
+      if (par->m_numSelectPost >= m_num_Sel)
+        continue;
+
+      // Get list of counterpart references that survived. The reference
+      // is the counterpart catalogue row, which is unique among the
+      // candidates of a source
+      status = cfits_get_col(m_memFile, par, OUTCAT_COL_REF_NAME, col_ref,
+                             status);
       if (status != STATUS_OK) {
         if (par->logTerse())
-          Log(Error_2, "%d : Unable to read counterpart IDs from memory.",
-              (Status)status);
+          Log(Error_2, "%d : Unable to read counterpart references from"
+                       " memory.", (Status)status);
         continue;
       }
 
       // If list is empty then stop now
-      int nSelected = (int)col_id.size();
+      int nSelected = (int)col_ref.size();
       if (nSelected < 1) {
         src->numSelect = 0;
         continue;
       }
 
-      // Collect all counterparts that survived
+      // Collect all counterparts that survived. As the selection preserves
+      // the order of the table rows, a single pass over the candidates
+      // suffices
       int inx = 0;
-      for (int iCC = 0; iCC < src->numFilter; ++iCC) {
-        for (int i = 0; i < nSelected; ++i) {
-          if (src->cc[iCC].id == col_id[i]) {
+      for (int iCC = 0; iCC < src->numFilter && inx < nSelected; ++iCC) {
+        if (src->cc[iCC].index == long(col_ref[inx] + 0.5)) {
+          if (inx != iCC)
             src->cc[inx] = src->cc[iCC];
-            inx++;
-          }
+          inx++;
         }
       }
 
@@ -634,6 +889,9 @@ Status Catalogue::cid_select(Parameters *par, SourceInfo *src, Status status) {
 
     } while (0); // End of main do-loop
 
+    // Stop profiling
+    ProfileStop(Prof_Select, src->numSelect);
+
     // Debug mode: Entry
     if (par->logDebug())
       Log(Log_0, " <== EXIT: Catalogue::cid_select (status=%d)",
@@ -660,7 +918,10 @@ Status Catalogue::cid_select(Parameters *par, SourceInfo *src, Status status) {
  * probability.
  *
  * This method expects src->numSelect counterparts. It sets the number of refine
- * step candidates in src->numRefine.
+ * step candidates in src->numRefine. If a prior sweep is requested, the
+ * candidates below the probability threshold are kept behind the refine step
+ * candidates, as they may pass the threshold at a swept prior, and the total
+ * number is set in src->numSweep (otherwise src->numSweep = src->numRefine).
  ******************************************************************************/
 Status Catalogue::cid_refine(Parameters *par, SourceInfo *src, Status status) {
 
@@ -674,6 +935,9 @@ Status Catalogue::cid_refine(Parameters *par, SourceInfo *src, Status status) {
       Log(Log_0, " ==> ENTRY: Catalogue::cid_refine (%d candidates)",
           src->numSelect);
 
+    // Start profiling
+    ProfileStart(Prof_Refine);
+
     // Single loop for common exit point
     do {
 
@@ -683,6 +947,7 @@ Status Catalogue::cid_refine(Parameters *par, SourceInfo *src, Status status) {
 
       // Initialise number of refine step candidates
       src->numRefine = src->numSelect;
+      src->numSweep  = src->numSelect;
 
       // Fall through if there are no counterpart candidates
       if (src->numSelect < 1)
@@ -771,7 +1036,7 @@ Status Catalogue::cid_refine(Parameters *par, SourceInfo *src, Status status) {
               src->cc[iCC].psi*60.0,
               src->cc[iCC].angsep*60.0,
               src->cc[iCC].posang,
-              cpt->name.c_str(),
+              cpt->name,
               cpt->pos_eq_ra, cpt->pos_eq_dec);
         }
       }
@@ -785,6 +1050,10 @@ Status Catalogue::cid_refine(Parameters *par, SourceInfo *src, Status status) {
         src->numRefine++;
       }
 
+      // Keep all candidates for a prior sweep
+      src->numSweep = (par->m_sweepPrior.size() > 0) ? src->numSelect
+                                                     : src->numRefine;
+
       // Fall through if no counterparts are left
       if (src->numRefine < 1) {
         if (par->logExplicit())
@@ -808,6 +1077,9 @@ Status Catalogue::cid_refine(Parameters *par, SourceInfo *src, Status status) {
 
     } while (0); // End of main do-loop
 
+    // Stop profiling
+    ProfileStop(Prof_Refine, src->numRefine);
+
     // Debug mode: Entry
     if (par->logDebug())
       Log(Log_0, " <== EXIT: Catalogue::cid_refine (status=%d)",
@@ -833,12 +1105,14 @@ Status Catalogue::cid_refine(Parameters *par, SourceInfo *src, Status status) {
  * to be deleted.
  *
  * This method expects src->numRefine counterparts. It sets the number of
- * selected candidates in src->numRefine.
+ * selected candidates in src->numRefine. The candidates that are only kept
+ * for a prior sweep (see cid_refine) are moved behind the selected
+ * candidates and src->numSweep is updated.
  ******************************************************************************/
 Status Catalogue::cid_reselect(Parameters *par, SourceInfo *src, Status status) {
 
     // Declare local variables
-    std::vector<std::string> col_id;
+    std::vector<double> col_ref;
 
     // Debug mode: Entry
     #if LOW_LEVEL_DEBUG
@@ -848,6 +1122,9 @@ Status Catalogue::cid_reselect(Parameters *par, SourceInfo *src, Status status)
       Log(Log_0, " ==> ENTRY: Catalogue::cid_reselect (%d candidates)",
           src->numRefine);
 
+    // Start profiling
+    ProfileStart(Prof_Reselect);
+
     // Single loop for common exit point
     do {
 
@@ -859,12 +1136,10 @@ Status Catalogue::cid_reselect(Parameters *par, SourceInfo *src, Status status)
       if (src->numRefine < 1)
         continue;
 
-      // Set unique counterpart candidate identifier for in-memory catalogue
-      char cid[OUTCAT_MAX_STRING_LEN];
-      for (int iCC = 0; iCC < src->numRefine; ++iCC) {
-        sprintf(cid, "CC_%5.5d_%5.5d", src->iSrc+1, iCC+1);
-        src->cc[iCC].id = cid;
-      }
+      // Fall through if no selection strings are applied in the
+      // reselection step (see Parameters::plan_select)
+      if (par->m_numSelectPost < 1)
+        continue;
 
       // Update in-memory catalogue
       status = cfits_update(m_memFile, par, src, src->numRefine, status);
@@ -875,13 +1150,8 @@ Status Catalogue::cid_reselect(Parameters *par, SourceInfo *src, Status status)
         continue;
       }
 
-      // Fall through if no selection strings are specified.
-      int m_num_Sel = par->m_select.size();
-      if (m_num_Sel < 1)
-        continue;
-
       // Select counterparts in memory
-      status = cfits_select(m_memFile, par, src, status);
+      status = cfits_select(m_memFile, par, src, status, 1);
       if (status != STATUS_OK) {
         if (par->logTerse())
           Log(Error_2, "%d : Unable to select catalogue counterparts.",
@@ -889,31 +1159,30 @@ Status Catalogue::cid_reselect(Parameters *par, SourceInfo *src, Status status)
         continue;
       }
 
-      // Get list of counterpart IDs that survived
-      status = cfits_get_col_str(m_memFile, par, OUTCAT_COL_ID_NAME, col_id,
-                                 status);
+      // Get list of counterpart references that survived. The reference
+      // is the counterpart catalogue row, which is unique among the
+      // candidates of a source
+      status = cfits_get_col(m_memFile, par, OUTCAT_COL_REF_NAME, col_ref,
+                             status);
       if (status != STATUS_OK) {
         if (par->logTerse())
-          Log(Error_2, "%d : Unable to read counterpart IDs from memory.",
-              (Status)status);
+          Log(Error_2, "%d : Unable to read counterpart references from"
+                       " memory.", (Status)status);
         continue;
       }
 
-      // If list is empty then stop now
-      int nSelected = (int)col_id.size();
-      if (nSelected < 1) {
-        src->numRefine = 0;
-        continue;
-      }
+      // Get number of selected counterparts
+      int nSelected = (int)col_ref.size();
 
-      // Collect all counterparts that survived
+      // Collect all counterparts that survived. As the selection preserves
+      // the order of the table rows, a single pass over the candidates
+      // suffices
       int inx = 0;
-      for (int iCC = 0; iCC < src->numRefine; ++iCC) {
-        for (int i = 0; i < nSelected; ++i) {
-          if (src->cc[iCC].id == col_id[i]) {
+      for (int iCC = 0; iCC < src->numRefine && inx < nSelected; ++iCC) {
+        if (src->cc[iCC].index == long(col_ref[inx] + 0.5)) {
+          if (inx != iCC)
             src->cc[inx] = src->cc[iCC];
-            inx++;
-          }
+          inx++;
         }
       }
 
@@ -926,11 +1195,21 @@ Status Catalogue::cid_reselect(Parameters *par, SourceInfo *src, Status status)
         continue;
       }
 
+      // Move candidates that are only kept for a prior sweep behind the
+      // selected counterparts
+      int numTail = src->numSweep - src->numRefine;
+      for (int iCC = 0; iCC < numTail; ++iCC)
+        src->cc[nSelected+iCC] = src->cc[src->numRefine+iCC];
+
       // Set number of remaining counterparts
       src->numRefine = nSelected;
+      src->numSweep  = nSelected + numTail;
 
     } while (0); // End of main do-loop
 
+    // Stop profiling
+    ProfileStop(Prof_Reselect, src->numRefine);
+
     // Debug mode: Entry
     if (par->logDebug())
       Log(Log_0, " <== EXIT: Catalogue::cid_reselect (status=%d)",
@@ -984,8 +1263,9 @@ Status Catalogue::cid_fom(Parameters *par, SourceInfo *src, Status status) {
         std::string         column  = "FOM";
         std::vector<double> fom;
 
-        // Evaluate FoM column
-        status = cfits_eval_column(m_memFile, par, column, par->m_FoM, status);
+        // Evaluate FoM
+        status = cfits_eval_formula(m_memFile, par, column, par->m_FoM,
+                                    par->m_FoMId, fom, status);
         if (status != STATUS_OK) {
           if (par->logTerse())
             Log(Error_2, "%d : Unable to evaluate expression <%s='%s'> in"
@@ -994,16 +1274,6 @@ Status Catalogue::cid_fom(Parameters *par, SourceInfo *src, Status status) {
           continue;
         }
 
-        // Extract FoM vector
-        status = cfits_get_col(m_memFile, par, column, fom, status);
-        if (status != STATUS_OK) {
-          if (par->logTerse())
-            Log(Error_2, "%d : Unable to extract column <%s> from"
-                         "in-memory FITS catalogue.",
-                         (Status)status, column.c_str());
-          continue;
-        }
-
         // Get FoM
         for (int iCC = 0; iCC < src->numSelect; ++iCC)
           src->cc[iCC].fom = fom[iCC];
@@ -1069,11 +1339,9 @@ Status Catalogue::cid_fom(Parameters *par, SourceInfo *src, Status status) {
  * CCElement::psi (effective 95% error ellipse radius) \n
  * CCElement::prob_pos (position association probability) \n
  * CCElement::pdf_pos (position association probability density) \n
- * CCElement::pos_eq_ra (Right Ascension of counterpart candidate) \n
- * CCElement::pos_eq_dec (Declination of counterpart candidate) \n
- * CCElement::pos_err_maj (uncertainty ellipse major axis) \n
- * CCElement::pos_err_min (uncertainty ellipse minor axis) \n
- * CCElement::pos_err_ang (uncertainty ellipse positron angle) \n
+ *
+ * The counterpart position and uncertainty ellipse are not copied into the
+ * candidate but are taken from m_cpt.object[CCElement::index] when needed.
  *
  * This method expects src->numSelect counterparts.
  ******************************************************************************/
@@ -1172,22 +1440,6 @@ Status Catalogue::cid_prob_pos(Parameters *par, SourceInfo *src, Status status)
           src->cc[iCC].prob_pos = 0.0;
         }
 
-        // Assign position and error ellipse
-//        if (cpt->pos_err_maj < src->info->pos_err_maj) {
-          src->cc[iCC].pos_eq_ra   = cpt->pos_eq_ra;
-          src->cc[iCC].pos_eq_dec  = cpt->pos_eq_dec;
-          src->cc[iCC].pos_err_maj = cpt->pos_err_maj;
-          src->cc[iCC].pos_err_min = cpt->pos_err_min;
-          src->cc[iCC].pos_err_ang = cpt->pos_err_ang;
-//        }
-//        else {
-//          src->cc[iCC].pos_eq_ra   = src->info->pos_eq_ra;
-//          src->cc[iCC].pos_eq_dec  = src->info->pos_eq_dec;
-//          src->cc[iCC].pos_err_maj = src->info->pos_err_maj;
-//          src->cc[iCC].pos_err_min = src->info->pos_err_min;
-//          src->cc[iCC].pos_err_ang = src->info->pos_err_ang;
-//        }
-
       } // endfor: looped over counterpart candidates
 
     } while (0); // End of main do-loop
@@ -1380,8 +1632,9 @@ Status Catalogue::cid_prob_prior(Parameters *par, SourceInfo *src, Status status
       // ... otherwise evaluate prior following the formula
       else {
 
-        // Evaluate PROB_PRIOR column
-        status = cfits_eval_column(m_memFile, par, column, par->m_probPrior, status);
+        // Evaluate PROB_PRIOR
+        status = cfits_eval_formula(m_memFile, par, column, par->m_probPrior,
+                                    par->m_probPriorId, prob_prior, status);
         if (status != STATUS_OK) {
           if (par->logTerse())
             Log(Error_2, "%d : Unable to evaluate expression <%s='%s'> in"
@@ -1390,16 +1643,6 @@ Status Catalogue::cid_prob_prior(Parameters *par, SourceInfo *src, Status status
           continue;
         }
 
-        // Extract PROB_PRIOR vector
-        status = cfits_get_col(m_memFile, par, column, prob_prior, status);
-        if (status != STATUS_OK) {
-          if (par->logTerse())
-            Log(Error_2, "%d : Unable to extract column <%s> from"
-                         "in-memory FITS catalogue.",
-                         (Status)status, column.c_str());
-          continue;
-        }
-
       } // endelse: evaluated prior
 
       // Allocate vector column for in-memory FITS file update
@@ -1447,6 +1690,80 @@ Status Catalogue::cid_prob_prior(Parameters *par, SourceInfo *src, Status status
 }
 
 
+/**************************************************************************//**
+ * @brief Compute posterior probability of one counterpart candidate
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] cc Pointer to counterpart candidate.
+ *
+ * Computes CCElement::likrat, CCElement::likrat_div and
+ * CCElement::prob_post_single from the PDFs, the counterpart density and
+ * the prior probability of the candidate (see cid_prob_post_single).
+ ******************************************************************************/
+void Catalogue::cid_post_single(Parameters *par, CCElement *cc) {
+
+    // Initialise results
+    cc->likrat           = 0.0;
+    cc->likrat_div       = 0;
+    cc->prob_post_single = 0.0;
+    int noLR = 0;                       // signals invalid LR (one of PDF is 0)
+
+    // Copute nominator of likelihood ratio
+    double lr_nom = cc->pdf_pos;
+    #if FOM_IN_NOMINATOR
+    if (par->m_FoM.length() > 0) {
+      lr_nom *= (cc->fom > 0.0) ? cc->fom : 0.0;
+    }
+    #else
+    (void)par;                          // only used for FoM in nominator
+    #endif
+
+    // Compute log-likelihood ratio. Signal if computation did not succeed
+    if (lr_nom > 0.0 && cc->pdf_chance > 0.0)
+      cc->likrat = log(lr_nom) - log(cc->pdf_chance);
+    else
+      noLR = 1;
+
+    // Signal likelihood ratio divergence
+    if (cc->psi > 0.0) {
+      double psi2 = cc->psi * cc->psi;
+      double beta = dnorm / psi2 - pi * cc->rho;
+      if (beta < 1.0)
+        cc->likrat_div = 1;
+    }
+
+    // Compute posterior probability. Make this computation overflow
+    // safe!
+    // There are some special cases:
+    //  invalid log LR  => PROB_POST = 0
+    //  PROB_PRIOR >= 1 => PROB_POST = 1
+    //  PROB_PRIOR <= 0 => PROB_POST = 0
+    if (noLR)
+      cc->prob_post_single = 0.0;
+    else if (cc->prob_prior >= 1.0)
+      cc->prob_post_single = 1.0;
+    else if (cc->prob_prior <= 0.0)
+      cc->prob_post_single = 0.0;
+    else {
+      double log_eta = log(cc->prob_prior) -
+                       log(1.0 - cc->prob_prior);
+      double log_arg = cc->likrat + log_eta;
+      if (log_arg < 100.0) {
+        double arg = exp(log_arg);
+        // for small arg, 1/(1+1/arg) ~ arg
+        cc->prob_post_single = (arg > 1.0e-100) ? // avoids floating point exception
+                     1.0 / (1.0 + 1.0 / arg) : arg;
+      }
+      else
+        cc->prob_post_single = 1.0;
+    }
+
+    // Return
+    return;
+
+}
+
+
 /**************************************************************************//**
  * @brief Compute posterior probabilities
  *
@@ -1499,59 +1816,8 @@ Status Catalogue::cid_prob_post_single(Parameters *par, SourceInfo *src,
       // Loop over all counterpart candidates
       for (int iCC = 0; iCC < src->numSelect; ++iCC) {
 
-        // Initialise results
-        src->cc[iCC].likrat           = 0.0;
-        src->cc[iCC].likrat_div       = 0;
-        src->cc[iCC].prob_post_single = 0.0;
-        int noLR = 0;                         // signals invalid LR (one of PDF is 0)
-
-        // Copute nominator of likelihood ratio
-        double lr_nom = src->cc[iCC].pdf_pos;
-        #if FOM_IN_NOMINATOR
-        if (par->m_FoM.length() > 0) {
-          lr_nom *= (src->cc[iCC].fom > 0.0) ? src->cc[iCC].fom : 0.0;
-        }
-        #endif
-
-        // Compute log-likelihood ratio. Signal if computation did not succeed
-        if (lr_nom > 0.0 && src->cc[iCC].pdf_chance > 0.0)
-          src->cc[iCC].likrat = log(lr_nom) - log(src->cc[iCC].pdf_chance);
-        else
-          noLR = 1;
-
-        // Signal likelihood ratio divergence
-        if (src->cc[iCC].psi > 0.0) {
-          double psi2 = src->cc[iCC].psi * src->cc[iCC].psi;
-          double beta = dnorm / psi2 - pi * src->cc[iCC].rho;
-          if (beta < 1.0)
-            src->cc[iCC].likrat_div = 1;
-        }
-
-        // Compute posterior probability. Make this computation overflow
-        // safe!
-        // There are some special cases:
-        //  invalid log LR  => PROB_POST = 0
-        //  PROB_PRIOR >= 1 => PROB_POST = 1
-        //  PROB_PRIOR <= 0 => PROB_POST = 0
-        if (noLR)
-          src->cc[iCC].prob_post_single = 0.0;
-        else if (src->cc[iCC].prob_prior >= 1.0)
-          src->cc[iCC].prob_post_single = 1.0;
-        else if (src->cc[iCC].prob_prior <= 0.0)
-          src->cc[iCC].prob_post_single = 0.0;
-        else {
-          double log_eta = log(src->cc[iCC].prob_prior) -
-                           log(1.0 - src->cc[iCC].prob_prior);
-          double log_arg = src->cc[iCC].likrat + log_eta;
-          if (log_arg < 100.0) {
-            double arg = exp(log_arg);
-            // for small arg, 1/(1+1/arg) ~ arg
-            src->cc[iCC].prob_post_single = (arg > 1.0e-100) ? // avoids floating point exception
-                         1.0 / (1.0 + 1.0 / arg) : arg;
-          }
-          else
-            src->cc[iCC].prob_post_single = 1.0;
-        }
+        // Compute likelihood ratio and posterior probability
+        cid_post_single(par, &(src->cc[iCC]));
 
         // Add results to column vectors
         col_likrat.push_back(src->cc[iCC].likrat);
@@ -1631,8 +1897,10 @@ Status Catalogue::cid_prob(Parameters *par, SourceInfo *src, Status status) {
         continue;
       }
 
-      // Evaluate PROB column
-      status = cfits_eval_column(m_memFile, par, column, par->m_probMethod, status);
+      // Evaluate PROB
+      std::vector<double> prob;
+      status = cfits_eval_formula(m_memFile, par, column, par->m_probMethod,
+                                  par->m_probMethodId, prob, status);
       if (status != STATUS_OK) {
         if (par->logTerse())
           Log(Error_2, "%d : Unable to evaluate expression <%s='%s'> in"
@@ -1641,17 +1909,6 @@ Status Catalogue::cid_prob(Parameters *par, SourceInfo *src, Status status) {
         continue;
       }
 
-      // Extract PROB vector
-      std::vector<double> prob;
-      status = cfits_get_col(m_memFile, par, column, prob, status);
-      if (status != STATUS_OK) {
-        if (par->logTerse())
-          Log(Error_2, "%d : Unable to extract column <%s> from"
-                       "in-memory FITS catalogue.",
-                       (Status)status, column.c_str());
-        continue;
-      }
-
       // Allocate vector column for in-memory FITS file update
       std::vector<double> col_prob;
 
@@ -1697,6 +1954,131 @@ Status Catalogue::cid_prob(Parameters *par, SourceInfo *src, Status status) {
 }
 
 
+/**************************************************************************//**
+ * @brief Compute unique association probabilities of one source
+ *
+ * @param[in] src Pointer to source information.
+ * @param[out] prod1 Probability products over all i' (src->numRefine).
+ * @param[out] prod2 Probability products over all i' except of i.
+ *
+ * Computes PROB_POST from the catalogue posterior probabilities PROB_POST_CAT
+ * of all counterpart candidates of the source and returns the normalization
+ * factor Sk.
+ ******************************************************************************/
+double Catalogue::cid_prob_unique(SourceInfo *src, double *prod1,
+                                  double *prod2) {
+
+    // Initialise normalization
+    double norm = 0.0;
+
+    // Fall through if there are no counterpart candidates
+    if (src->numRefine < 1)
+      return norm;
+
+    // Compute products
+    for (int i = 0; i < src->numRefine; ++i) {
+      prod1[i] = 1.0; // all i'
+      prod2[i] = 1.0; // all i' except of i
+      for (int ip = 0; ip < src->numRefine; ++ip) {
+        if (i == ip)
+          prod1[i]  = (1.0 - src->cc[ip].prob_post_cat);
+        else
+          prod2[i] *= (1.0 - src->cc[ip].prob_post_cat);
+      }
+      prod1[i] *= prod2[i];
+    }
+
+    // Compute non-normalized posterior probabilities and normalization
+    // factor
+    norm = prod1[0];
+    for (int i = 0; i < src->numRefine; ++i) {
+      src->cc[i].prob_post = src->cc[i].prob_post_cat * prod2[i];
+      norm += src->cc[i].prob_post ;
+    }
+
+    // Compute unique association probabilities
+    if (norm > 0.0) {
+      for (int i = 0; i < src->numRefine; ++i)
+        src->cc[i].prob_post /= norm;
+    }
+    else {
+      for (int i = 0; i < src->numRefine; ++i)
+        src->cc[i].prob_post = 0.0;
+    }
+
+    // Return normalization
+    return norm;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Determine claimed counterpart candidates of one source
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] src Pointer to source information.
+ * @param[in] status Error status.
+ *
+ * Computes PROB, sorts the counterpart candidates by decreasing probability
+ * and sets src->numClaimed to the number of candidates above the probability
+ * threshold (limited to maxNumCpt).
+ ******************************************************************************/
+Status Catalogue::cid_claim(Parameters *par, SourceInfo *src, Status status) {
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::cid_claim");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Compute PROB
+      status = cid_prob(par, src, status);
+      if (status != STATUS_OK)
+        continue;
+
+      // Sort counterpart candidates by decreasing probability
+      status = cid_sort(par, src, src->numRefine, status);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to sort counterpart candidates.",
+              (Status)status);
+        continue;
+      }
+
+      // Determine the number of counterpart candidates above the probability
+      // threshold
+      int numUseCC = 0;
+      for (int iCC = 0; iCC < src->numRefine; ++iCC) {
+        if (src->cc[iCC].prob >= par->m_probThres)
+          numUseCC++;
+        else
+          break;
+      }
+
+      // Apply the maximum number of counterpart threshold
+      if (numUseCC > par->m_maxNumCpt)
+        numUseCC = par->m_maxNumCpt;
+
+      // Eliminate counterpart candidates below threshold.
+      src->numClaimed = numUseCC;
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::cid_claim (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
 /**************************************************************************//**
  * @brief Compute local counterpart density at the position of a given source
  *
@@ -1791,8 +2173,9 @@ Status Catalogue::cid_local_density(Parameters *par, SourceInfo *src,
       //         counterpart density
       else {
 
-        // Compute number of counterparts within acceptance ring
-        int num = 0;
+        // Compute number of counterparts within acceptance ring. Candidates
+        // that have been pruned still count (see cid_prune)
+        int num = src->numPruneRing;
         for (int iCC = 0; iCC < src->numSelect; ++iCC) {
           if (src->cc[iCC].angsep >= src->ring_rad_min &&
               src->cc[iCC].angsep <= src->ring_rad_max)
@@ -1820,7 +2203,8 @@ Status Catalogue::cid_local_density(Parameters *par, SourceInfo *src,
         for (int iCC = 0; iCC < src->numSelect; ++iCC) {
           Log(Log_2, "    Candidate %5.5d ...............: "
                      "rho(%8.4f,%8.4f)=%10.4f deg^-2 (sep=%5.3f deg)",
-                     iCC+1, src->cc[iCC].pos_eq_ra, src->cc[iCC].pos_eq_dec,
+                     iCC+1, m_cpt.object[src->cc[iCC].index].pos_eq_ra,
+                     m_cpt.object[src->cc[iCC].index].pos_eq_dec,
                      src->cc[iCC].rho, src->cc[iCC].angsep);
         }
       }
@@ -1882,7 +2266,8 @@ Status Catalogue::cid_global_density(Parameters *par, SourceInfo *src,
         for (int iCC = 0; iCC < src->numSelect; ++iCC) {
           Log(Log_2, "    Candidate %5.5d ...............: "
                      "rho(%8.4f,%8.4f)=%10.4f deg^-2  (sep=%5.3f deg)",
-                     iCC+1, src->cc[iCC].pos_eq_ra, src->cc[iCC].pos_eq_dec, 
+                     iCC+1, m_cpt.object[src->cc[iCC].index].pos_eq_ra,
+                     m_cpt.object[src->cc[iCC].index].pos_eq_dec,
                      src->cc[iCC].rho, src->cc[iCC].angsep);
         }
       }
@@ -1949,20 +2334,19 @@ Status Catalogue::cid_map_density(Parameters *par, SourceInfo *src,
         for (int iCC = 0; iCC < src->numSelect; ++iCC) {
 
           // Set sky direction
-          GSkyDir dir;
-          dir.radec_deg(src->cc[iCC].pos_eq_ra, src->cc[iCC].pos_eq_dec);
+          ObjectInfo *cpt = &(m_cpt.object[src->cc[iCC].index]);
+          GSkyDir     dir;
+          dir.radec_deg(cpt->pos_eq_ra, cpt->pos_eq_dec);
 
           // Get density
           int pixel        = m_density.ang2pix(dir);
           src->cc[iCC].rho = m_density(pixel);
 
           // Optionally dump information
-          if (par->logExplicit()) {
-            Log(Log_2, "    Candidate %5.5d ...............: "
+          LOG_EXPLICIT(par, Log_2, "    Candidate %5.5d ...............: "
                        "rho(%8.4f,%8.4f)=%10.4f deg^-2 (pixel=%d, sep=%5.3f deg)",
-                       iCC+1, src->cc[iCC].pos_eq_ra, src->cc[iCC].pos_eq_dec,
+                       iCC+1, cpt->pos_eq_ra, cpt->pos_eq_dec,
                        src->cc[iCC].rho, pixel, src->cc[iCC].angsep);
-          }
         }
       }
 
@@ -1989,8 +2373,8 @@ Status Catalogue::cid_map_density(Parameters *par, SourceInfo *src,
  * @param[in] src Pointer to source information.
  * @param[in] status Error status.
  *
- * Sort by increasing probability and in case of equal probability) by 
- * decreasing angular separation
+ * Sort by decreasing probability and (in case of equal probability) by
+ * increasing angular separation
  ******************************************************************************/
 Status Catalogue::cid_sort(Parameters *par, SourceInfo *src, int num,
                            Status status) {
@@ -2010,41 +2394,276 @@ Status Catalogue::cid_sort(Parameters *par, SourceInfo *src, int num,
       if (num < 1)
         continue;
 
-      // Sort counterpart candidats (dirty brute force method, to be replaced
-      // by more efficient method if needed ...)
-      for (int iCC = 0; iCC < num; ++iCC) {
-        double max_prob =   0.0;
-        double min_sep  = 180.0;
-        int    imax     = iCC;
-        for (int jCC = iCC; jCC < num; ++jCC) {
+      // Sort an index permutation of the candidates and gather the
+      // candidates once through a scratch copy. The stable sort keeps the
+      // original order of candidates with equal probability and separation.
+      std::vector<int> perm(num);
+      for (int iCC = 0; iCC < num; ++iCC)
+        perm[iCC] = iCC;
+      std::stable_sort(perm.begin(), perm.end(), CCSortOrder(src->cc));
+      std::vector<CCElement> scratch(src->cc, src->cc + num);
+      for (int iCC = 0; iCC < num; ++iCC)
+        src->cc[iCC] = scratch[perm[iCC]];
 
-          // Check if we found a better candidate
-          if (src->cc[jCC].prob > max_prob) {        // Increasing probability
-            imax     = jCC;
-            max_prob = src->cc[jCC].prob;
-            min_sep  = src->cc[jCC].angsep;
-          }
-          else if (src->cc[jCC].prob == max_prob) {  // Equal probability &
-            if (src->cc[jCC].angsep < min_sep) {     // decreasing separation
-              imax     = jCC;
-              max_prob = src->cc[jCC].prob;
-              min_sep  = src->cc[jCC].angsep;
-            }
-          }
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::cid_sort (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Allocate counterpart candidates from the candidate arena
+ *
+ * @param[in] num Number of counterpart candidates.
+ *
+ * Candidates of all sources are allocated from a chain of large blocks that
+ * is only released in free_memory(). As sources are associated one after the
+ * other, the candidates of a source always occupy the tail of the last block,
+ * which allows to give back unused candidates using cid_trim(). Returns NULL
+ * if the memory allocation failed.
+ ******************************************************************************/
+CCElement* Catalogue::cid_alloc(int num) {
+
+    // Allocate new block if the last block is too small
+    if (m_cc_block.empty() || m_cc_used + num > m_cc_size) {
+      long size = (num > c_cc_block) ? num : c_cc_block;
+      CCElement *block = new CCElement[size];
+      if (block == NULL)
+        return NULL;
+      m_cc_block.push_back(block);
+      m_cc_size = size;
+      m_cc_used = 0;
+    }
+
+    // Assign candidates from tail of last block
+    CCElement *cc = m_cc_block.back() + m_cc_used;
+    m_cc_used    += num;
+
+    // Return candidates
+    return cc;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Give back unused counterpart candidates to the candidate arena
+ *
+ * @param[in] src Pointer to source information.
+ * @param[in] num Number of counterpart candidates to keep.
+ *
+ * Releases all but the first num counterpart candidates of the source. This
+ * is only possible for the most recent allocation; otherwise the method does
+ * nothing.
+ ******************************************************************************/
+void Catalogue::cid_trim(SourceInfo *src, int num) {
+
+    // Check that source holds the tail of the last block
+    if (src->cc == NULL || m_cc_block.empty() ||
+        src->cc + src->numFilter != m_cc_block.back() + m_cc_used)
+      return;
+
+    // Give back unused candidates
+    if (num < src->numFilter) {
+      m_cc_used -= (src->numFilter - num);
+      if (num < 1)
+        src->cc = NULL;
+    }
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Build declination index of counterpart catalogue
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] status Error status.
+ *
+ * Sorts the counterparts with valid positions by increasing declination so
+ * that the filter step only needs to scan the declination zone of a source.
+ * The index is built once and kept until free_memory() is called.
+ ******************************************************************************/
+Status Catalogue::cid_index(Parameters *par, Status status) {
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::cid_index");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Fall through if index exists already
+      if ((long)m_cpt_zone.size() + m_cpt_no_pos == m_cpt.numLoad &&
+          m_cpt.numLoad > 0)
+        continue;
+
+      // Collect counterparts with valid positions
+      std::vector<std::pair<double,int> > zone;
+      zone.reserve(m_cpt.numLoad);
+      m_cpt_no_pos = 0;
+      for (int iCpt = 0; iCpt < m_cpt.numLoad; ++iCpt) {
+        if (m_cpt.object[iCpt].pos_valid)
+          zone.push_back(std::make_pair(m_cpt.object[iCpt].pos_eq_dec, iCpt));
+        else
+          m_cpt_no_pos++;
+      }
+
+      // Sort by declination and store index
+      std::sort(zone.begin(), zone.end());
+      m_cpt_zone     = std::vector<int>(zone.size());
+      m_cpt_zone_dec = std::vector<double>(zone.size());
+      m_cpt_zone_ra  = std::vector<double>(zone.size());
+      for (int i = 0; i < (int)zone.size(); ++i) {
+        m_cpt_zone_dec[i] = zone[i].first;
+        m_cpt_zone[i]     = zone[i].second;
+        m_cpt_zone_ra[i]  = m_cpt.object[zone[i].second].pos_eq_ra;
+      }
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::cid_index (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
 
+
+/**************************************************************************//**
+ * @brief Return Hilbert curve index of sky position
+ *
+ * @param[in] ra Right Ascension (deg).
+ * @param[in] dec Declination (deg).
+ *
+ * Maps the position on an equal-area grid in Right Ascension and sin(Dec)
+ * with 2^ORDER_HILBERT_BITS cells per axis and returns the index of the
+ * cell along the Hilbert curve that traverses the grid.
+ ******************************************************************************/
+static long long cid_hilbert(double ra, double dec) {
+
+    // Set grid cell
+    const long n = 1L << ORDER_HILBERT_BITS;
+    ra           = ra - double(long(ra / 360.0) * 360.0);
+    if (ra < 0.0) ra += 360.0;
+    long x = long(ra / 360.0 * double(n));
+    long y = long(0.5 * (sin(dec * deg2rad) + 1.0) * double(n));
+    if (x < 0) x = 0;
+    if (x > n - 1) x = n - 1;
+    if (y < 0) y = 0;
+    if (y > n - 1) y = n - 1;
+
+    // Walk down the quadrants, rotating the grid so that each quadrant
+    // is traversed in the Hilbert curve orientation
+    long long d = 0;
+    for (long s = n / 2; s > 0; s /= 2) {
+      long rx = ((x & s) > 0) ? 1 : 0;
+      long ry = ((y & s) > 0) ? 1 : 0;
+      d      += (long long)s * (long long)s * ((3 * rx) ^ ry);
+      if (ry == 0) {
+        if (rx == 1) {
+          x = n - 1 - x;
+          y = n - 1 - y;
         }
-        if (iCC != imax) {
-          CCElement swap = src->cc[iCC];
-          src->cc[iCC]   = src->cc[imax];
-          src->cc[imax]  = swap;
+        long t = x;
+        x      = y;
+        y      = t;
+      }
+    }
+
+    // Return index
+    return d;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Set source processing order
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[out] order Source indices in processing order.
+ * @param[in] status Error status.
+ *
+ * For srcOrder=HEALPIX the sources are sorted by the index of their HEALPix
+ * pixel in NESTED scheme, for srcOrder=HILBERT by their index along a
+ * Hilbert curve in Right Ascension and sin(Dec) (see cid_hilbert()). Both
+ * orders keep sources that are close on the sky close in the processing
+ * sequence, so that consecutive sources scan the same part of the
+ * counterpart declination index. Ties and sources without valid position
+ * (put at the end) keep the catalogue order. The order does not affect the
+ * results, which are always stored by source index.
+ ******************************************************************************/
+Status Catalogue::cid_order(Parameters *par, std::vector<int> &order,
+                            Status status) {
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::cid_order");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Initialise catalogue order
+      order = std::vector<int>(m_src.numLoad);
+      for (int k = 0; k < m_src.numLoad; ++k)
+        order[k] = k;
+
+      // Fall through if catalogue order is requested
+      if (par->m_srcOrder == "CATALOGUE" || m_src.numLoad < 2)
+        continue;
+
+      // Setup HEALPix map with about one source per pixel
+      int nside = 1;
+      if (par->m_srcOrder == "HEALPIX") {
+        while (12 * nside * nside < m_src.numLoad && nside < ORDER_MAX_NSIDE)
+          nside *= 2;
+      }
+      GHealpix map(nside, "NESTED", "EQU");
+
+      // Compute curve index of all sources
+      std::vector<std::pair<long long,int> > key(m_src.numLoad);
+      for (int k = 0; k < m_src.numLoad; ++k) {
+        ObjectInfo *src = &(m_src.object[k]);
+        long long   index;
+        if (!src->pos_valid)
+          index = std::numeric_limits<long long>::max();
+        else if (par->m_srcOrder == "HEALPIX") {
+          GSkyDir dir;
+          dir.radec_deg(src->pos_eq_ra, src->pos_eq_dec);
+          index = map.ang2pix(dir);
         }
+        else
+          index = cid_hilbert(src->pos_eq_ra, src->pos_eq_dec);
+        key[k] = std::make_pair(index, k);
       }
 
+      // Sort sources by curve index
+      std::sort(key.begin(), key.end());
+      for (int k = 0; k < m_src.numLoad; ++k)
+        order[k] = key[k].second;
+
     } while (0); // End of main do-loop
 
     // Debug mode: Entry
     if (par->logDebug())
-      Log(Log_0, " <== EXIT: Catalogue::cid_sort (status=%d)", status);
+      Log(Log_0, " <== EXIT: Catalogue::cid_order (status=%d)", status);
 
     // Return status
     return status;
@@ -2091,39 +2710,37 @@ Status Catalogue::cid_dump(Parameters *par, SourceInfo *src, Status status) {
         ObjectInfo *cpt = &(m_cpt.object[iCpt]);
 
         // Normal log level
-        if (par->logNormal()) {
-          if (cpt->pos_valid) {
-            if (src->cc[iCC].likrat_div) {
-              Log(Log_2, "  Cpt%5d[P=%3.0f%%] r95=%7.3f' sep=%7.3f' PA=%4.0f: %20s" SRC_FORMAT,
-                  iCC+1,
-                  src->cc[iCC].prob_post_single*100.0,
-                  src->cc[iCC].psi*60.0,
-                  src->cc[iCC].angsep*60.0,
-                  src->cc[iCC].posang,
-                  cpt->name.c_str(),
-                  cpt->pos_eq_ra, cpt->pos_eq_dec,
-                  cpt->pos_err_maj, cpt->pos_err_min, cpt->pos_err_ang);
-            }
-            else {
-              Log(Log_2, "  Cpt%5d P=%3.0f%% r95=%7.3f' S=%7.3f' PA=%4.0f: %20s" SRC_FORMAT,
-                  iCC+1,
-                  src->cc[iCC].prob_post_single*100.0,
-                  src->cc[iCC].psi*60.0,
-                  src->cc[iCC].angsep*60.0,
-                  src->cc[iCC].posang,
-                  cpt->name.c_str(),
-                  cpt->pos_eq_ra, cpt->pos_eq_dec,
-                  cpt->pos_err_maj, cpt->pos_err_min, cpt->pos_err_ang);
-            }
+        if (cpt->pos_valid) {
+          if (src->cc[iCC].likrat_div) {
+            LOG_NORMAL(par, Log_2, "  Cpt%5d[P=%3.0f%%] r95=%7.3f' sep=%7.3f' PA=%4.0f: %20s" SRC_FORMAT,
+                iCC+1,
+                src->cc[iCC].prob_post_single*100.0,
+                src->cc[iCC].psi*60.0,
+                src->cc[iCC].angsep*60.0,
+                src->cc[iCC].posang,
+                cpt->name,
+                cpt->pos_eq_ra, cpt->pos_eq_dec,
+                cpt->pos_err_maj, cpt->pos_err_min, cpt->pos_err_ang);
           }
           else {
-            Log(Log_2, "  Cpt%5d P=%3.0f%% .................: %20s"
-                " No position information found",
+            LOG_NORMAL(par, Log_2, "  Cpt%5d P=%3.0f%% r95=%7.3f' S=%7.3f' PA=%4.0f: %20s" SRC_FORMAT,
                 iCC+1,
-                src->cc[iCC].prob*100.0,
-                cpt->name.c_str());
+                src->cc[iCC].prob_post_single*100.0,
+                src->cc[iCC].psi*60.0,
+                src->cc[iCC].angsep*60.0,
+                src->cc[iCC].posang,
+                cpt->name,
+                cpt->pos_eq_ra, cpt->pos_eq_dec,
+                cpt->pos_err_maj, cpt->pos_err_min, cpt->pos_err_ang);
           }
         }
+        else {
+          LOG_NORMAL(par, Log_2, "  Cpt%5d P=%3.0f%% .................: %20s"
+              " No position information found",
+              iCC+1,
+              src->cc[iCC].prob*100.0,
+              cpt->name);
+        }
 
         // Verbose log level
         if (par->logVerbose()) {
@@ -0,0 +1,555 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file Catalogue_mc.cxx
+ * @brief Implements Monte Carlo false association methods of Catalogue class.
+ * @author J. Knodlseder
+ */
+
+/* Includes _________________________________________________________________ */
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "sourceIdentify.h"
+#include "Catalogue.h"
+#include "Log.h"
+#include "Profile.h"
+#include "Trace.h"
+
+
+/* Definitions ______________________________________________________________ */
+
+
+/* Namespace definition _____________________________________________________ */
+namespace sourceIdentify {
+
+
+/* Type defintions __________________________________________________________ */
+
+
+/* Globals __________________________________________________________________ */
+
+
+/* Private Prototypes _______________________________________________________ */
+static double mc_uniform(unsigned long long *state);
+static int    mc_write(int fd, const double *buf, int num);
+static int    mc_read(int fd, double *buf, int num);
+
+
+/*============================================================================*/
+/*                          Private helper functions                          */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Return uniform random number in [0,1[
+ *
+ * @param[in] state Pointer to random number generator state.
+ *
+ * Uses a xorshift64* generator so that the shifted source catalogues are
+ * reproducible for a given seed, independently of the number of workers.
+ ******************************************************************************/
+static double mc_uniform(unsigned long long *state) {
+
+    // Advance state
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    unsigned long long r = *state * 2685821657736338717ULL;
+
+    // Return uniform deviate
+    return double(r >> 11) * (1.0 / 9007199254740992.0);
+
+}
+
+
+/**************************************************************************//**
+ * @brief Write record to pipe
+ *
+ * @param[in] fd File descriptor.
+ * @param[in] buf Record.
+ * @param[in] num Number of record elements.
+ *
+ * Returns 0 on success and -1 on failure.
+ ******************************************************************************/
+static int mc_write(int fd, const double *buf, int num) {
+
+    // Write record, allowing for partial writes
+    const char *ptr  = (const char*)buf;
+    size_t      left = num * sizeof(double);
+    while (left > 0) {
+      ssize_t n = write(fd, ptr, left);
+      if (n <= 0)
+        return -1;
+      ptr  += n;
+      left -= n;
+    }
+
+    // Return success
+    return 0;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Read record from pipe
+ *
+ * @param[in] fd File descriptor.
+ * @param[out] buf Record.
+ * @param[in] num Number of record elements.
+ *
+ * Returns 1 if a record was read, 0 at the end of the pipe and -1 for an
+ * incomplete record.
+ ******************************************************************************/
+static int mc_read(int fd, double *buf, int num) {
+
+    // Read record, allowing for partial reads
+    char   *ptr  = (char*)buf;
+    size_t  size = num * sizeof(double);
+    size_t  done = 0;
+    while (done < size) {
+      ssize_t n = read(fd, ptr + done, size - done);
+      if (n <= 0)
+        return (done == 0 && n == 0) ? 0 : -1;
+      done += n;
+    }
+
+    // Return record
+    return 1;
+
+}
+
+
+/*============================================================================*/
+/*                       Low-level Monte Carlo methods                        */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Estimate false associations from shifted source catalogues
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] status Error status.
+ *
+ * Generates par->m_mcNum fake source catalogues by shifting each source away
+ * from its true position (see mc_shift) and associates them with the
+ * counterpart catalogue that is already loaded. As no true counterparts are
+ * expected, all claimed associations of a fake catalogue are false. For each
+ * probability threshold of par->m_sweepThres (or probThres) the number of
+ * claimed associations is recorded per realisation.
+ *
+ * The realisations are distributed over par->m_mcJobs worker processes (one
+ * per processor if 0). The workers are forked after the counterpart
+ * catalogue, its declination index and the density map are loaded, hence
+ * these are shared and not reloaded. The working catalogues and
+ * catalogAccess are not thread safe, which is why processes instead of
+ * threads are used. Workers send their results through pipes, and nothing
+ * is written to disk per realisation. The table of claimed associations is
+ * stored in m_mc.
+ ******************************************************************************/
+Status Catalogue::montecarlo(Parameters *par, Status status) {
+
+    // Declare local variables
+    std::vector<double> thresholds;
+    std::vector<double> prob;
+    std::vector<double> cum;
+    std::vector<double> real;
+    std::vector<double> claimed;
+    std::vector<double> sum_pid;
+    std::vector<char>   received;
+    std::vector<pid_t>  pids;
+    std::vector<int>    fds;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::montecarlo");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Fall through if no realisations are requested
+      m_mc_names.clear();
+      m_mc.clear();
+      if (par->m_mcNum < 1)
+        continue;
+
+      // Set thresholds
+      thresholds = par->m_sweepThres;
+      if (thresholds.size() < 1)
+        thresholds.push_back(par->m_probThres);
+      int numThres = (int)thresholds.size();
+      int numIter  = par->m_mcNum;
+
+      // Count claimed associations of the true source catalogue
+      sweep_claim(par, prob, cum);
+      for (int iThres = 0; iThres < numThres; ++iThres) {
+        int num = std::upper_bound(prob.begin(), prob.end(), thresholds[iThres],
+                                   std::greater<double>()) - prob.begin();
+        real.push_back(double(num));
+      }
+
+      // Set number of worker processes
+      int numJobs = par->m_mcJobs;
+      if (numJobs < 1)
+        numJobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+      if (numJobs < 1)
+        numJobs = 1;
+      if (numJobs > numIter)
+        numJobs = numIter;
+
+      // Dump header
+      if (par->logNormal()) {
+        Log(Log_2, "");
+        Log(Log_2, "Monte Carlo false associations:");
+        Log(Log_2, "===============================");
+        Log(Log_2, " Shifted source catalogues ........: %d", numIter);
+        Log(Log_2, " Worker processes .................: %d", numJobs);
+      }
+
+      // Start worker processes
+      for (int job = 0; job < numJobs; ++job) {
+        int fd[2];
+        if (pipe(fd) != 0) {
+          status = STATUS_MC_WORKER_FAILED;
+          if (par->logTerse())
+            Log(Error_2, "%d : Unable to create pipe for worker %d.",
+                (Status)status, job);
+          break;
+        }
+
+        // Write buffered log messages and trace events, so that the worker
+        // does not inherit them
+        LogFlush(STATUS_OK);
+        TraceFlush();
+
+        // Fork worker. The worker detaches from logging, tracing and
+        // profiling, which remain owned by the parent
+        pid_t pid = fork();
+        if (pid < 0) {
+          close(fd[0]);
+          close(fd[1]);
+          status = STATUS_MC_WORKER_FAILED;
+          if (par->logTerse())
+            Log(Error_2, "%d : Unable to start worker %d.",
+                (Status)status, job);
+          break;
+        }
+        if (pid == 0) {
+          close(fd[0]);
+          LogDetach();
+          TraceDetach();
+          ProfileInit(0, STATUS_OK);
+          Status wstatus = mc_worker(par, job, numJobs, thresholds, fd[1],
+                                     STATUS_OK);
+          close(fd[1]);
+          _exit((wstatus == STATUS_OK) ? 0 : 1);
+        }
+        close(fd[1]);
+        pids.push_back(pid);
+        fds.push_back(fd[0]);
+      }
+
+      // Collect results of all started workers
+      int numRec = 1 + 2 * numThres;
+      std::vector<double> rec(numRec);
+      claimed  = std::vector<double>(numIter * numThres, 0.0);
+      sum_pid  = std::vector<double>(numIter * numThres, 0.0);
+      received = std::vector<char>(numIter, 0);
+      int failed = 0;
+      for (int job = 0; job < (int)fds.size(); ++job) {
+        int res;
+        while ((res = mc_read(fds[job], &rec[0], numRec)) > 0) {
+          int iter = (int)rec[0];
+          if (iter < 0 || iter >= numIter) {
+            failed = 1;
+            continue;
+          }
+          for (int iThres = 0; iThres < numThres; ++iThres) {
+            claimed[iter*numThres + iThres] = rec[1 + iThres];
+            sum_pid[iter*numThres + iThres] = rec[1 + numThres + iThres];
+          }
+          received[iter] = 1;
+        }
+        if (res < 0)
+          failed = 1;
+        close(fds[job]);
+      }
+      for (int job = 0; job < (int)pids.size(); ++job) {
+        int wstatus = 0;
+        if (waitpid(pids[job], &wstatus, 0) != pids[job] ||
+            !WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0)
+          failed = 1;
+      }
+      if (status != STATUS_OK)
+        continue;
+      for (int iter = 0; iter < numIter; ++iter) {
+        if (!received[iter])
+          failed = 1;
+      }
+      if (failed) {
+        status = STATUS_MC_WORKER_FAILED;
+        if (par->logTerse())
+          Log(Error_2, "%d : Monte Carlo worker failed.", (Status)status);
+        continue;
+      }
+
+      // Set table columns
+      m_mc_names.push_back("REALISATION");
+      m_mc_names.push_back("PROB_THRES");
+      m_mc_names.push_back("NUM_CLAIMED");
+      m_mc_names.push_back("SUM_PID");
+      m_mc = std::vector<std::vector<double> >(m_mc_names.size());
+
+      // Add one row per realisation and threshold
+      for (int iter = 0; iter < numIter; ++iter) {
+        for (int iThres = 0; iThres < numThres; ++iThres) {
+          m_mc[0].push_back(double(iter+1));
+          m_mc[1].push_back(thresholds[iThres]);
+          m_mc[2].push_back(claimed[iter*numThres + iThres]);
+          m_mc[3].push_back(sum_pid[iter*numThres + iThres]);
+        }
+      }
+
+      // Dump distribution of false associations
+      if (par->logNormal()) {
+        Log(Log_2, "   Threshold    Claimed   Mean false        RMS"
+                   "        Min        Max  False fract.");
+        for (int iThres = 0; iThres < numThres; ++iThres) {
+          double sum  = 0.0;
+          double sum2 = 0.0;
+          double min  = claimed[iThres];
+          double max  = claimed[iThres];
+          for (int iter = 0; iter < numIter; ++iter) {
+            double num = claimed[iter*numThres + iThres];
+            sum  += num;
+            sum2 += num * num;
+            if (num < min) min = num;
+            if (num > max) max = num;
+          }
+          double mean  = sum / double(numIter);
+          double var   = sum2 / double(numIter) - mean * mean;
+          double rms   = (var > 0.0) ? sqrt(var) : 0.0;
+          double fract = (real[iThres] > 0.0) ? mean / real[iThres] : 0.0;
+          Log(Log_2, "  %10.4e %10.0f %12.3f %10.3f %10.0f %10.0f %13.6f",
+              thresholds[iThres], real[iThres], mean, rms, min, max, fract);
+        }
+      }
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::montecarlo (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Associate shifted source catalogues in worker process
+ *
+ * @param[in] par Pointer to gtsrcid parameters (worker copy).
+ * @param[in] job Worker index.
+ * @param[in] numJobs Number of workers.
+ * @param[in] thresholds Probability thresholds.
+ * @param[in] fd Pipe file descriptor for results.
+ * @param[in] status Error status.
+ *
+ * Runs in a forked worker process and associates the realisations job,
+ * job+numJobs, ... For each realisation a record with the realisation
+ * index, the number of claimed associations and the sum of their PROB for
+ * each threshold is written to @p fd. The worker owns private copies of
+ * the parameters and of the source information, hence logging,
+ * checkpointing and the sweep options are switched off in place. Logging,
+ * tracing and profiling are detached by the caller after fork().
+ ******************************************************************************/
+Status Catalogue::mc_worker(Parameters *par, int job, int numJobs,
+                            std::vector<double> &thresholds, int fd,
+                            Status status) {
+
+    // Declare local variables
+    std::vector<ObjectInfo>             orig;
+    std::vector<std::pair<double,int> > zone;
+    std::vector<double>                 prob;
+    std::vector<double>                 cum;
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Switch off logging, checkpointing, sharding, incremental association
+      // and sweeps
+      par->m_chatter    = 0;
+      par->m_debug      = 0;
+      par->m_chkFile.clear();
+      par->m_prevCatName.clear();
+      par->m_resume     = 0;
+      par->m_numShards  = 1;
+      par->m_shard      = -1;
+      par->m_sweepPrior.clear();
+      par->m_sweepThres.clear();
+      par->m_probCurves = 0;
+
+      // Save true source positions and sort them by declination
+      orig.assign(m_src.object, m_src.object + m_src.numLoad);
+      for (int iSrc = 0; iSrc < m_src.numLoad; ++iSrc) {
+        if (orig[iSrc].pos_valid)
+          zone.push_back(std::make_pair(orig[iSrc].pos_eq_dec, iSrc));
+      }
+      std::sort(zone.begin(), zone.end());
+
+      // Loop over realisations of this worker
+      int numThres = (int)thresholds.size();
+      std::vector<double> rec(1 + 2 * numThres);
+      for (int iter = job; iter < par->m_mcNum; iter += numJobs) {
+
+        // Shift sources
+        mc_shift(par, iter, orig, zone);
+
+        // Associate shifted sources
+        clear_sources();
+        status = cfits_clear(m_memFile, par, status);
+        status = associate_sources(par, status);
+        if (status != STATUS_OK)
+          break;
+
+        // Count claimed associations for all thresholds
+        sweep_claim(par, prob, cum);
+        rec[0] = double(iter);
+        for (int iThres = 0; iThres < numThres; ++iThres) {
+          int num = std::upper_bound(prob.begin(), prob.end(),
+                                     thresholds[iThres],
+                                     std::greater<double>()) - prob.begin();
+          rec[1 + iThres]            = double(num);
+          rec[1 + numThres + iThres] = cum[num];
+        }
+
+        // Send record
+        if (mc_write(fd, &rec[0], (int)rec.size()) != 0) {
+          status = STATUS_MC_WORKER_FAILED;
+          break;
+        }
+
+      } // endfor: looped over realisations
+
+    } while (0); // End of main do-loop
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Shift sources away from their true positions
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] iter Realisation.
+ * @param[in] orig True source information.
+ * @param[in] zone True source declinations and indices, sorted.
+ *
+ * Moves each source with a valid position by a random angle between
+ * par->m_mcShift and twice that value in a random direction, keeping its
+ * error ellipse. Positions that fall within par->m_mcShift of any true
+ * source position are redrawn up to c_mc_tries times. The random numbers
+ * only depend on par->m_mcSeed and @p iter.
+ ******************************************************************************/
+void Catalogue::mc_shift(Parameters *par, int iter,
+                         std::vector<ObjectInfo> &orig,
+                         std::vector<std::pair<double,int> > &zone) {
+
+    // Seed random number generator for this realisation
+    unsigned long long state = (unsigned long long)(par->m_mcSeed + 1) *
+                               0x9E3779B97F4A7C15ULL ^
+                               (unsigned long long)(iter + 1) *
+                               0xBF58476D1CE4E5B9ULL;
+    if (state == 0)
+      state = 1;
+
+    // Set shift
+    double shift     = par->m_mcShift;
+    double cos_shift = cos(shift * deg2rad);
+
+    // Loop over sources
+    for (int iSrc = 0; iSrc < m_src.numLoad; ++iSrc) {
+
+      // Restore true source and skip sources without position
+      m_src.object[iSrc] = orig[iSrc];
+      if (!orig[iSrc].pos_valid)
+        continue;
+
+      // Draw shifted positions until one is away from all true sources
+      double ra      = orig[iSrc].pos_eq_ra;
+      double dec     = orig[iSrc].pos_eq_dec;
+      double sin_dec = sin(dec * deg2rad);
+      double cos_dec = cos(dec * deg2rad);
+      double new_ra  = ra;
+      double new_dec = dec;
+      for (int iTry = 0; iTry < c_mc_tries; ++iTry) {
+
+        // Draw offset and position angle
+        double d     = shift * (1.0 + mc_uniform(&state)) * deg2rad;
+        double theta = twopi * mc_uniform(&state);
+
+        // Compute shifted position
+        double arg = sin_dec * cos(d) + cos_dec * sin(d) * cos(theta);
+        if (arg >  1.0) arg =  1.0;
+        if (arg < -1.0) arg = -1.0;
+        new_dec = asin(arg) * rad2deg;
+        new_ra  = ra + atan2(sin(theta) * sin(d) * cos_dec,
+                             cos(d) - sin_dec * arg) * rad2deg;
+        new_ra  = fmod(new_ra, 360.0);
+        if (new_ra < 0.0) new_ra += 360.0;
+
+        // Check distance to true sources within the declination band
+        double new_sin = sin(new_dec * deg2rad);
+        double new_cos = cos(new_dec * deg2rad);
+        int    close   = 0;
+        std::vector<std::pair<double,int> >::iterator it =
+          std::lower_bound(zone.begin(), zone.end(),
+                           std::make_pair(new_dec - shift, -1));
+        for (; it != zone.end() && it->first <= new_dec + shift; ++it) {
+          ObjectInfo *obj = &(orig[it->second]);
+          double cos_sep = new_sin * sin(obj->pos_eq_dec * deg2rad) +
+                           new_cos * cos(obj->pos_eq_dec * deg2rad) *
+                           cos((new_ra - obj->pos_eq_ra) * deg2rad);
+          if (cos_sep > cos_shift) {
+            close = 1;
+            break;
+          }
+        }
+        if (!close)
+          break;
+
+      } // endfor: looped over draws
+
+      // Set shifted position
+      m_src.object[iSrc].pos_eq_ra  = new_ra;
+      m_src.object[iSrc].pos_eq_dec = new_dec;
+
+    } // endfor: looped over sources
+
+    // Return
+    return;
+
+}
+
+
+/* Namespace ends ___________________________________________________________ */
+}
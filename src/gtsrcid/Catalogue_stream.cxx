@@ -0,0 +1,496 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file Catalogue_stream.cxx
+ * @brief Implements streaming association methods of Catalogue class.
+ * @author J. Knodlseder
+ */
+
+/* Includes _________________________________________________________________ */
+#include <algorithm>
+#include "sourceIdentify.h"
+#include "Catalogue.h"
+#include "Log.h"
+
+
+/* Definitions ______________________________________________________________ */
+
+
+/* Namespace definition _____________________________________________________ */
+namespace sourceIdentify {
+
+
+/* Type defintions __________________________________________________________ */
+
+
+/* Globals __________________________________________________________________ */
+
+
+/* Private Prototypes _______________________________________________________ */
+
+
+/*============================================================================*/
+/*                         Streaming association methods                      */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Add sources to the association stream
+ *
+ * @param[in] par Pointer to gtsrcid parameters (see Parameters::set).
+ * @param[in] src New sources (positions and error ellipses).
+ * @param[out] prov Provisional counterpart candidates of the new sources.
+ * @param[out] update Indices of the sources with updated results.
+ * @param[out] res Association results of the updated sources.
+ * @param[in] status Error status.
+ *
+ * Requires a prior call to load(). The new sources are appended to the
+ * sources of all previous calls and the per-source steps (filter, select,
+ * refine, reselect) are run for them only. All refine step candidates of
+ * the new sources are returned in @p prov, with PROB_POST_SINGLE set.
+ *
+ * PROB_POST_CAT is then recomputed only for the counterparts that are
+ * candidates of a new source, i.e. for the columns of the sparse matrix
+ * that changed, and PROB_POST, PROB and the claimed candidates only for the
+ * sources that have a candidate in one of these columns. These sources are
+ * listed in @p update and their claimed and finally selected candidates are
+ * returned in @p res. The results of all other sources are unchanged.
+ *
+ * The catch-22 prior is not supported as it couples all sources. Catalogue
+ * statistics (reliability, completeness, ...) are not maintained.
+ ******************************************************************************/
+Status Catalogue::stream(Parameters *par, const AssocCatalogue &src,
+                         AssocResult &prov, std::vector<int> &update,
+                         AssocResult &res, Status status) {
+
+    // Declare local variables
+    InCatalogue chunk;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::stream");
+
+    // Initialise chunk
+    chunk.object = NULL;
+    chunk.table  = NULL;
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Initialise results
+      prov          = AssocResult();
+      res.numAssoc  = 0;
+      prov.numAssoc = 0;
+      update.clear();
+
+      // Initialise stream at first call
+      if (m_stream_size == 0) {
+        status = stream_init(par, status);
+        if (status != STATUS_OK)
+          continue;
+      }
+
+      // Load new sources
+      status = get_input_table(par, &chunk, &src, par->m_srcPosError, status);
+      if (status != STATUS_OK)
+        continue;
+      if (chunk.numLoad < 1)
+        continue;
+
+      // Make room for new sources
+      status = stream_grow(par, m_src.numLoad + chunk.numLoad, status);
+      if (status != STATUS_OK)
+        continue;
+
+      // Append new sources. The names are kept in a deque so that name
+      // pointers stay valid while the stream grows.
+      int first = (int)m_src.numLoad;
+      for (int i = 0; i < chunk.numLoad; ++i) {
+        int k = first + i;
+        m_stream_names.push_back(chunk.object[i].name);
+        m_src.object[k]           = chunk.object[i];
+        m_src.object[k].name      = m_stream_names.back().c_str();
+        m_info[k].iSrc            = k;
+        m_info[k].info            = &(m_src.object[k]);
+        m_info[k].numFilter       = 0;
+        m_info[k].numPrune        = 0;
+        m_info[k].numPruneRing    = 0;
+        m_info[k].numSelect       = 0;
+        m_info[k].numRefine       = 0;
+        m_info[k].numSweep        = 0;
+        m_info[k].numClaimed      = 0;
+        m_info[k].numFinalSel     = 0;
+        m_info[k].cc              = NULL;
+        m_info[k].filter_rad      = 0.0;
+        m_info[k].ring_rad_min    = 0.0;
+        m_info[k].ring_rad_max    = 0.0;
+        m_info[k].omega           = 0.0;
+        for (int iSel = 0; iSel <= m_num_Sel; ++iSel)
+          m_cpt_stat[k*(m_num_Sel+1) + iSel] = 0;
+      }
+      m_src.numLoad  += chunk.numLoad;
+      m_src.numTotal  = m_src.numLoad;
+
+      // Get plausible counterpart candidates and compute PROB_POST_SINGLE
+      // for the new sources
+      for (int k = first; k < m_src.numLoad; ++k)
+        status = cid_source(par, &(m_info[k]), status);
+      if (status != STATUS_OK)
+        continue;
+
+      // Collect provisional results
+      for (int k = first; k < m_src.numLoad; ++k)
+        get_candidates(&(m_info[k]), m_info[k].numRefine, prov);
+
+      // Update catalogue association probabilities
+      status = stream_post(par, first, update, status);
+      if (status != STATUS_OK) {
+        if (par->logTerse())
+          Log(Error_2, "%d : Unable to update catalogue association"
+              " probabilities.", (Status)status);
+        continue;
+      }
+
+      // Determine claimed counterpart candidates of updated sources
+      for (int i = 0; i < (int)update.size(); ++i) {
+        status = cid_claim(par, &(m_info[update[i]]), status);
+        if (status != STATUS_OK) {
+          if (par->logTerse())
+            Log(Error_2, "%d : Unable to determine association probability.",
+                (Status)status);
+          break;
+        }
+      }
+      if (status != STATUS_OK)
+        continue;
+
+      // Extract results of updated sources
+      status = cfits_clear(m_outFile, par, status);
+      status = get_results(par, res, status, &update);
+      if (status != STATUS_OK)
+        continue;
+
+    } while (0); // End of main do-loop
+
+    // Free chunk
+    if (chunk.object != NULL) delete [] chunk.object;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::stream (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Initialise association stream
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] status Error status.
+ *
+ * Releases the sources of previous queries and allocates the stream
+ * working memory.
+ ******************************************************************************/
+Status Catalogue::stream_init(Parameters *par, Status status) {
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::stream_init");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Catch-22 needs the full source catalogue
+      if (par->m_catch22) {
+        status = STATUS_PAR_BAD_PARAMETER;
+        if (par->logTerse())
+          Log(Error_2, "%d : Catch-22 prior is not supported in streaming"
+              " mode.", (Status)status);
+        continue;
+      }
+
+      // Release information of previous query
+      clear_sources();
+
+      // Initialise source catalogue
+      if (m_src.object != NULL) delete [] m_src.object;
+      m_src.object      = NULL;
+      m_src.table       = NULL;
+      m_src.inName      = "stream";
+      m_src.numLoad     = 0;
+      m_src.numTotal    = 0;
+      m_src.e_pos_scale = 1.0;
+      m_src.erposabs    = c_erposabs * 2.4860;
+      std::vector<char>().swap(m_src.names);
+
+      // Determine number of quantity selection criteria
+      m_num_Sel = par->m_select.size();
+
+      // Allocate list of selected counterparts
+      m_cpt_sel = new int[m_cpt.numLoad];
+      if (m_cpt_sel == NULL) {
+        status = STATUS_MEM_ALLOC;
+        if (par->logTerse())
+          Log(Error_2, "%d : Memory allocation failure.", (Status)status);
+        continue;
+      }
+
+      // Allocate sparse matrix columns
+      m_stream_col = std::vector<std::vector<int> >(m_cpt.numLoad);
+
+      // Allocate first block of stream sources
+      status = stream_grow(par, c_stream_block, status);
+      if (status != STATUS_OK)
+        continue;
+
+      // Clear FITS memory catalogues
+      status = cfits_clear(m_memFile, par, status);
+      status = cfits_clear(m_outFile, par, status);
+      if (status != STATUS_OK)
+        continue;
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::stream_init (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Grow stream source memory
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] num Required number of stream sources.
+ * @param[in] status Error status.
+ *
+ * Reallocates the source objects, the source information and the selection
+ * statistics so that they can hold at least @p num sources. The allocated
+ * size is at least doubled to keep the number of reallocations small. The
+ * counterpart candidates stay in the candidate arena and are not moved.
+ ******************************************************************************/
+Status Catalogue::stream_grow(Parameters *par, long num, Status status) {
+
+    // Declare local variables
+    ObjectInfo *object = NULL;
+    SourceInfo *info   = NULL;
+    int        *stat   = NULL;
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Fall through if there is enough memory
+      if (num <= m_stream_size)
+        continue;
+
+      // Determine new size
+      long size = 2 * m_stream_size;
+      if (size < c_stream_block) size = c_stream_block;
+      if (size < num)            size = num;
+
+      // Allocate memory
+      object = new ObjectInfo[size];
+      info   = new SourceInfo[size];
+      stat   = new int[size*(m_num_Sel+1)];
+      if (object == NULL || info == NULL || stat == NULL) {
+        status = STATUS_MEM_ALLOC;
+        if (par->logTerse())
+          Log(Error_2, "%d : Memory allocation failure.", (Status)status);
+        continue;
+      }
+
+      // Copy existing sources
+      for (int k = 0; k < m_src.numLoad; ++k) {
+        object[k]    = m_src.object[k];
+        info[k]      = m_info[k];
+        info[k].info = &(object[k]);
+        for (int iSel = 0; iSel <= m_num_Sel; ++iSel)
+          stat[k*(m_num_Sel+1) + iSel] = m_cpt_stat[k*(m_num_Sel+1) + iSel];
+      }
+
+      // Replace memory
+      if (m_src.object != NULL) delete [] m_src.object;
+      if (m_info       != NULL) delete [] m_info;
+      if (m_cpt_stat   != NULL) delete [] m_cpt_stat;
+      m_src.object  = object;
+      m_info        = info;
+      m_cpt_stat    = stat;
+      object        = NULL;
+      info          = NULL;
+      stat          = NULL;
+      m_stream_size = size;
+
+      // Set vectors dimensions
+      m_cpt_names.resize(size);
+
+    } while (0); // End of main do-loop
+
+    // Free memory in case of an error
+    if (object != NULL) delete [] object;
+    if (info   != NULL) delete [] info;
+    if (stat   != NULL) delete [] stat;
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Update catalogue association probabilities for new sources
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] first Index of first new source.
+ * @param[out] update Indices of the sources with updated probabilities.
+ * @param[in] status Error status.
+ *
+ * The sparse matrix of compute_prob_post_cat() is kept across calls in
+ * Catalogue::m_stream_col, which holds for each counterpart i (column) the
+ * sources k (rows) that have i as candidate. The new sources are added to
+ * their columns and PROB_POST_CAT is recomputed for all elements of the
+ * changed columns, using the same products and normalization as
+ * compute_prob_post_cat(). PROB_POST is then recomputed for all sources
+ * that have an element in one of the changed columns.
+ ******************************************************************************/
+Status Catalogue::stream_post(Parameters *par, int first,
+                              std::vector<int> &update, Status status) {
+
+    // Declare local variables
+    std::vector<int>        cols;
+    std::vector<CCElement*> elements;
+    std::vector<double>     prod1;
+    std::vector<double>     prod2;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::stream_post");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Add new sources to sparse matrix columns
+      for (int k = first; k < m_src.numLoad; ++k) {
+        for (int i = 0; i < m_info[k].numRefine; ++i) {
+          int col = m_info[k].cc[i].index;
+          m_stream_col[col].push_back(k);
+          cols.push_back(col);
+        }
+      }
+      std::sort(cols.begin(), cols.end());
+      cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+
+      // Recompute catalogue posterior probabilities of changed columns
+      for (int c = 0; c < (int)cols.size(); ++c) {
+
+        // Collect column elements
+        std::vector<int> &rows = m_stream_col[cols[c]];
+        elements.clear();
+        for (int j = 0; j < (int)rows.size(); ++j) {
+          SourceInfo *src = &(m_info[rows[j]]);
+          int         i   = 0;
+          for ( ; i < src->numRefine; ++i) {
+            if (src->cc[i].index == cols[c])
+              break;
+          }
+          if (i >= src->numRefine) {
+            status = STATUS_CAT_BAD_SPARSE;
+            if (par->logTerse())
+              Log(Error_2, "%d : Counterpart %d not found for source %d.",
+                  (Status)status, cols[c]+1, rows[j]+1);
+            break;
+          }
+          elements.push_back(&(src->cc[i]));
+          update.push_back(rows[j]);
+        }
+        if (status != STATUS_OK)
+          break;
+
+        // Initialise normalization sum with Pi(H-|D)
+        double sum = 1.0;
+        for (int j = 0; j < (int)elements.size(); ++j)
+          sum *= (1.0 - elements[j]->prob_post_single);
+
+        // Compute catalogue posterior probabilities and update normalization
+        // sum
+        for (int j = 0; j < (int)elements.size(); ++j) {
+          double prod = 1.0; // all k' except of k
+          for (int jp = 0; jp < (int)elements.size(); ++jp) {
+            if (jp != j)
+              prod *= (1.0 - elements[jp]->prob_post_single);
+          }
+          elements[j]->prob_post_cat = elements[j]->prob_post_single * prod;
+          sum                       += elements[j]->prob_post_cat;
+        }
+
+        // Normalize catalogue posterior probabilities
+        for (int j = 0; j < (int)elements.size(); ++j) {
+          if (sum > 0.0)
+            elements[j]->prob_post_cat /= sum;
+          else
+            elements[j]->prob_post_cat = 0.0;
+        }
+
+      } // endfor: looped over changed columns
+      if (status != STATUS_OK)
+        continue;
+
+      // Determine updated sources
+      std::sort(update.begin(), update.end());
+      update.erase(std::unique(update.begin(), update.end()), update.end());
+
+      // Recompute unique association probabilities of updated sources
+      for (int j = 0; j < (int)update.size(); ++j) {
+        SourceInfo *src = &(m_info[update[j]]);
+        prod1.resize(src->numRefine);
+        prod2.resize(src->numRefine);
+        cid_prob_unique(src, &(prod1[0]), &(prod2[0]));
+      }
+
+      // Dump update
+      if (par->logNormal())
+        Log(Log_2, " Stream update ....................: %d new sources,"
+            " %d columns, %d sources updated",
+            (int)m_src.numLoad-first, (int)cols.size(), (int)update.size());
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::stream_post (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/* Namespace ends ___________________________________________________________ */
+}
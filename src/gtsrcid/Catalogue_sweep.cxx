@@ -0,0 +1,396 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file Catalogue_sweep.cxx
+ * @brief Implements prior and threshold sweep methods of Catalogue class.
+ * @author J. Knodlseder
+ */
+
+/* Includes _________________________________________________________________ */
+#include <algorithm>
+#include <functional>
+#include "sourceIdentify.h"
+#include "Catalogue.h"
+#include "Log.h"
+
+
+/* Definitions ______________________________________________________________ */
+
+
+/* Namespace definition _____________________________________________________ */
+namespace sourceIdentify {
+
+
+/* Type defintions __________________________________________________________ */
+
+
+/* Globals __________________________________________________________________ */
+
+
+/* Private Prototypes _______________________________________________________ */
+
+
+/*============================================================================*/
+/*                          Low-level sweep methods                           */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Sort claimable probabilities and compute their prefix sums
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[out] prob Claimable probabilities, sorted by decreasing value.
+ * @param[out] cum Prefix sums of prob (cum[i] is the sum of the first i).
+ *
+ * Collects the PROB values of the first maxNumCpt counterpart candidates of
+ * each source. As the candidates are sorted by decreasing PROB, these are the
+ * only candidates that cid_claim may claim. For any threshold, the claimed
+ * candidates are then the leading elements of prob with PROB >= threshold.
+ * Returns the sum of PROB over all candidates before thresholding.
+ ******************************************************************************/
+double Catalogue::sweep_claim(Parameters *par, std::vector<double> &prob,
+                              std::vector<double> &cum) {
+
+    // Collect claimable probabilities
+    double sum_pid = 0.0;
+    prob.clear();
+    for (int k = 0; k < m_src.numLoad; ++k) {
+      for (int iCC = 0; iCC < m_info[k].numRefine; ++iCC) {
+        sum_pid += m_info[k].cc[iCC].prob;
+        if (iCC < par->m_maxNumCpt)
+          prob.push_back(m_info[k].cc[iCC].prob);
+      }
+    }
+
+    // Sort by decreasing probability
+    std::sort(prob.begin(), prob.end(), std::greater<double>());
+
+    // Compute prefix sums
+    cum.assign(prob.size()+1, 0.0);
+    for (int i = 0; i < (int)prob.size(); ++i)
+      cum[i+1] = cum[i] + prob[i];
+
+    // Return sum before thresholding
+    return sum_pid;
+
+}
+
+
+
+/**************************************************************************//**
+ * @brief Sweep prior probabilities and probability thresholds
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] status Error status.
+ *
+ * Computes the association statistics of compute_prob for all combinations
+ * of the prior probabilities par->m_sweepPrior and the probability
+ * thresholds par->m_sweepThres, re-using the log-likelihood ratios of the
+ * refine step. For each prior, PROB_POST_SINGLE, the catalogue and unique
+ * posterior probabilities and PROB are recomputed once; the thresholds are
+ * then applied to the sorted probabilities. If no priors are given, the
+ * probabilities of the association are used. If no thresholds are given,
+ * probThres is used.
+ *
+ * The refine step threshold is re-applied for each prior to all candidates
+ * of the selection step (see cid_refine; pruning is disabled for a prior
+ * sweep), so that candidates below the threshold at the association prior
+ * are included at higher priors. The criteria of the reselection step are
+ * only applied with the prior of the association. The candidates and association statistics are restored
+ * after the sweep, and the sweep table is stored in m_sweep.
+ ******************************************************************************/
+Status Catalogue::sweep(Parameters *par, Status status) {
+
+    // Declare local variables
+    double                               fract_not_unique;
+    std::vector<double>                  priors;
+    std::vector<double>                  prob;
+    std::vector<double>                  cum;
+    std::vector<double>                  thresholds;
+    std::vector<int>                     save_refine;
+    std::vector<int>                     save_sweep;
+    std::vector<std::vector<CCElement> > save_cc;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::sweep");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Fall through if no sweep is requested
+      m_sweep_names.clear();
+      m_sweep.clear();
+      if (par->m_sweepPrior.size() < 1 && par->m_sweepThres.size() < 1)
+        continue;
+
+      // Set sweep grid. A negative prior signals the association prior
+      priors     = par->m_sweepPrior;
+      thresholds = par->m_sweepThres;
+      if (priors.size() < 1)
+        priors.push_back(-1.0);
+      if (thresholds.size() < 1)
+        thresholds.push_back(par->m_probThres);
+
+      // Dump header
+      if (par->logNormal()) {
+        Log(Log_2, "");
+        Log(Log_2, "Sweep prior probabilities and thresholds:");
+        Log(Log_2, "=========================================");
+        Log(Log_2, "       Prior  Threshold      Claimed        False"
+                   "  Reliability Completeness");
+      }
+
+      // Save counterpart candidates and statistics
+      fract_not_unique = m_fract_not_unique;
+      save_refine = std::vector<int>(m_src.numLoad);
+      save_sweep  = std::vector<int>(m_src.numLoad);
+      save_cc     = std::vector<std::vector<CCElement> >(m_src.numLoad);
+      for (int k = 0; k < m_src.numLoad; ++k) {
+        save_refine[k] = m_info[k].numRefine;
+        save_sweep[k]  = m_info[k].numSweep;
+        if (m_info[k].numSweep > 0)
+          save_cc[k].assign(m_info[k].cc, m_info[k].cc + m_info[k].numSweep);
+      }
+
+      // Set sweep table columns
+      m_sweep_names.push_back("PROB_PRIOR");
+      m_sweep_names.push_back("PROB_THRES");
+      m_sweep_names.push_back("NUM_CLAIMED");
+      m_sweep_names.push_back("NUM_FALSE");
+      m_sweep_names.push_back("SUM_PID");
+      m_sweep_names.push_back("RELIABILITY");
+      m_sweep_names.push_back("COMPLETENESS");
+      m_sweep = std::vector<std::vector<double> >(m_sweep_names.size());
+
+      // Set refine step threshold
+      double prob_thres = (par->m_probThres < c_prob_min) ? par->m_probThres : c_prob_min;
+
+      // Loop over priors
+      for (int iPrior = 0; iPrior < (int)priors.size(); ++iPrior) {
+
+        // Recompute probabilities for a new prior
+        double prior = priors[iPrior];
+        if (prior >= 0.0) {
+
+          // Recompute PROB_POST_SINGLE for all sweep candidates and
+          // re-apply the refine step threshold
+          for (int k = 0; k < m_src.numLoad; ++k) {
+            SourceInfo *src = &(m_info[k]);
+            src->numRefine  = save_sweep[k];
+            for (int iCC = 0; iCC < src->numRefine; ++iCC) {
+              src->cc[iCC]            = save_cc[k][iCC];
+              src->cc[iCC].prob_prior = prior;
+              cid_post_single(par, &(src->cc[iCC]));
+              src->cc[iCC].prob       = src->cc[iCC].prob_post_single;
+            }
+            status = cid_sort(par, src, src->numRefine, status);
+            if (status != STATUS_OK)
+              break;
+            int num = 0;
+            for (int iCC = 0; iCC < src->numRefine; ++iCC) {
+              if (src->cc[iCC].prob_post_single < prob_thres)
+                break;
+              num++;
+            }
+            src->numRefine = num;
+          }
+          if (status != STATUS_OK) {
+            if (par->logTerse())
+              Log(Error_2, "%d : Unable to sort counterpart candidates.",
+                  (Status)status);
+            break;
+          }
+
+          // Compute catalogue and unique posterior probabilities
+          status = compute_prob_post_cat(par, status, 1);
+          status = compute_prob_post(par, status, 1);
+          if (status != STATUS_OK) {
+            if (par->logTerse())
+              Log(Error_2, "%d : Unable to compute catalogue association"
+                  " probabilities.", (Status)status);
+            break;
+          }
+
+          // Compute PROB and sort candidates by decreasing PROB
+          for (int k = 0; k < m_src.numLoad; ++k) {
+            status = cid_prob(par, &(m_info[k]), status);
+            status = cid_sort(par, &(m_info[k]), m_info[k].numRefine, status);
+            if (status != STATUS_OK)
+              break;
+          }
+          if (status != STATUS_OK) {
+            if (par->logTerse())
+              Log(Error_2, "%d : Unable to determine association probability.",
+                  (Status)status);
+            break;
+          }
+
+        } // endif: recomputed probabilities
+
+        // Sort claimable probabilities
+        double sum_pid = sweep_claim(par, prob, cum);
+
+        // Loop over thresholds
+        for (int iThres = 0; iThres < (int)thresholds.size(); ++iThres) {
+
+          // Count claimed candidates and sum up their probabilities
+          double thres = thresholds[iThres];
+          int    num   = std::upper_bound(prob.begin(), prob.end(), thres,
+                                          std::greater<double>()) -
+                         prob.begin();
+          double num_claimed = double(num);
+          double sum_pid_thr = cum[num];
+
+          // Compute reliability and completeness (see compute_prob)
+          double reliability  = (num_claimed > 0.0) ? sum_pid_thr/num_claimed : 0.0;
+          double completeness = (sum_pid     > 0.0) ? sum_pid_thr/sum_pid     : 0.0;
+
+          // Add table row
+          m_sweep[0].push_back(prior);
+          m_sweep[1].push_back(thres);
+          m_sweep[2].push_back(num_claimed);
+          m_sweep[3].push_back(num_claimed - sum_pid_thr);
+          m_sweep[4].push_back(sum_pid);
+          m_sweep[5].push_back(reliability);
+          m_sweep[6].push_back(completeness);
+
+          // Dump table row
+          if (par->logNormal()) {
+            if (prior >= 0.0)
+              Log(Log_2, "  %10.4e %10.4e %12.0f %12.3f %12.6f %12.6f",
+                  prior, thres, num_claimed, num_claimed - sum_pid_thr,
+                  reliability, completeness);
+            else
+              Log(Log_2, "  %10s %10.4e %12.0f %12.3f %12.6f %12.6f",
+                  "PROB_PRIOR", thres, num_claimed, num_claimed - sum_pid_thr,
+                  reliability, completeness);
+          }
+
+        } // endfor: looped over thresholds
+
+      } // endfor: looped over priors
+
+      // Restore counterpart candidates and statistics
+      m_fract_not_unique = fract_not_unique;
+      for (int k = 0; k < m_src.numLoad; ++k) {
+        m_info[k].numRefine = save_refine[k];
+        for (int iCC = 0; iCC < save_sweep[k]; ++iCC)
+          m_info[k].cc[iCC] = save_cc[k][iCC];
+      }
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::sweep (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Compute reliability and completeness curves
+ *
+ * @param[in] par Pointer to gtsrcid parameters.
+ * @param[in] status Error status.
+ *
+ * Computes the number of claimed associations, the expected number of false
+ * associations, the reliability and the completeness as function of the
+ * probability threshold. One sort of the claimable probabilities and their
+ * prefix sums give the statistics of compute_prob for every threshold at
+ * which the claimed set changes, i.e. for every distinct PROB value. The
+ * curve table is stored in m_curve.
+ ******************************************************************************/
+Status Catalogue::curves(Parameters *par, Status status) {
+
+    // Declare local variables
+    std::vector<double> prob;
+    std::vector<double> cum;
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " ==> ENTRY: Catalogue::curves");
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Fall through if no curves are requested
+      m_curve_names.clear();
+      m_curve.clear();
+      if (!par->m_probCurves)
+        continue;
+
+      // Sort claimable probabilities
+      double sum_pid = sweep_claim(par, prob, cum);
+
+      // Set curve table columns
+      m_curve_names.push_back("PROB_THRES");
+      m_curve_names.push_back("NUM_CLAIMED");
+      m_curve_names.push_back("NUM_FALSE");
+      m_curve_names.push_back("RELIABILITY");
+      m_curve_names.push_back("COMPLETENESS");
+      m_curve = std::vector<std::vector<double> >(m_curve_names.size());
+
+      // Add one row for each distinct probability
+      int num = (int)prob.size();
+      for (int i = 0; i < num; ++i) {
+
+        // Skip ties
+        if (i < num-1 && prob[i+1] >= prob[i])
+          continue;
+
+        // Compute statistics for threshold prob[i]
+        double num_claimed  = double(i+1);
+        double sum_pid_thr  = cum[i+1];
+        double reliability  = sum_pid_thr/num_claimed;
+        double completeness = (sum_pid > 0.0) ? sum_pid_thr/sum_pid : 0.0;
+
+        // Add table row
+        m_curve[0].push_back(prob[i]);
+        m_curve[1].push_back(num_claimed);
+        m_curve[2].push_back(num_claimed - sum_pid_thr);
+        m_curve[3].push_back(reliability);
+        m_curve[4].push_back(completeness);
+
+      } // endfor: looped over probabilities
+
+      // Dump curve summary
+      if (par->logNormal()) {
+        Log(Log_2, "");
+        Log(Log_2, "Reliability and completeness curves:");
+        Log(Log_2, "====================================");
+        Log(Log_2, " Claimable candidates .............: %d", num);
+        Log(Log_2, " Curve points .....................: %d",
+            (int)m_curve[0].size());
+      }
+
+    } while (0); // End of main do-loop
+
+    // Debug mode: Entry
+    if (par->logDebug())
+      Log(Log_0, " <== EXIT: Catalogue::curves (status=%d)", status);
+
+    // Return status
+    return status;
+
+}
+
+
+/* Namespace ends ___________________________________________________________ */
+}
@@ -0,0 +1,1148 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file Formula.cxx
+ * @brief Compiled formula evaluation plan implementation.
+ * @author J. Knodlseder
+ *
+ * The user formulas (probMethod, probPrior, fom and outCatQty) are compiled
+ * once into a single plan of operator nodes. Identical subexpressions are
+ * represented by a single node (also across formulas), constant
+ * subexpressions are folded at compile time, and the special functions
+ * gammln(), erf(), erfc(), nsrc(), nlat() and ncpt() are plan operators.
+ * The plan is evaluated column-wise over the counterpart candidates.
+ *
+ * The plan understands the arithmetic subset of the CFITSIO calculator
+ * syntax. Formulas outside this subset (strings, keywords, vector columns,
+ * bit operations, ...) are not compiled and are evaluated by the CFITSIO
+ * calculator as before.
+ */
+
+/* Includes _________________________________________________________________ */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <limits>
+#include "Formula.h"
+
+
+/* Namespace definition _____________________________________________________ */
+namespace sourceIdentify {
+
+
+/* Type defintions __________________________________________________________ */
+typedef enum {                  // Plan operators
+  Op_Const = 0,                 // Constant
+  Op_Column,                    // Catalogue column
+  Op_Nsrc,                      // nsrc(), nlat()
+  Op_Ncpt,                      // ncpt()
+  Op_Neg,                       // -a
+  Op_Not,                       // !a
+  Op_Add,                       // a + b
+  Op_Sub,                       // a - b
+  Op_Mul,                       // a * b
+  Op_Div,                       // a / b
+  Op_Mod,                       // a % b
+  Op_Pow,                       // a ** b
+  Op_Eq,                        // a == b
+  Op_Ne,                        // a != b
+  Op_Lt,                        // a < b
+  Op_Le,                        // a <= b
+  Op_Gt,                        // a > b
+  Op_Ge,                        // a >= b
+  Op_And,                       // a && b
+  Op_Or,                        // a || b
+  Op_Cond,                      // a ? b : c
+  Op_Abs,                       // abs(a)
+  Op_Sqrt,                      // sqrt(a)
+  Op_Exp,                       // exp(a)
+  Op_Log,                       // log(a)
+  Op_Log10,                     // log10(a)
+  Op_Sin,                       // sin(a)
+  Op_Cos,                       // cos(a)
+  Op_Tan,                       // tan(a)
+  Op_Asin,                      // arcsin(a)
+  Op_Acos,                      // arccos(a)
+  Op_Atan,                      // arctan(a)
+  Op_Atan2,                     // arctan2(a,b)
+  Op_Sinh,                      // sinh(a)
+  Op_Cosh,                      // cosh(a)
+  Op_Tanh,                      // tanh(a)
+  Op_Floor,                     // floor(a)
+  Op_Ceil,                      // ceil(a)
+  Op_Round,                     // round(a)
+  Op_Min,                       // min(a,b)
+  Op_Max,                       // max(a,b)
+  Op_Gammln,                    // gammln(a)
+  Op_Erf,                       // erf(a)
+  Op_Erfc                       // erfc(a)
+} FormulaOp;
+
+typedef struct {                // Plan functions
+  const char *name;             // Function name (upper case)
+  int         op;               // Operator
+  int         nargs;            // Number of arguments
+} FormulaFct;
+
+
+/* Constants ________________________________________________________________ */
+const double fml_pi  = 3.1415926535897931159979635;
+const double fml_e   = 2.7182818284590452353602875;
+const double fml_nan = std::numeric_limits<double>::quiet_NaN();
+const FormulaFct fml_fcts[] = {{"ABS",     Op_Abs,    1},
+                               {"SQRT",    Op_Sqrt,   1},
+                               {"EXP",     Op_Exp,    1},
+                               {"LOG",     Op_Log,    1},
+                               {"LOG10",   Op_Log10,  1},
+                               {"SIN",     Op_Sin,    1},
+                               {"COS",     Op_Cos,    1},
+                               {"TAN",     Op_Tan,    1},
+                               {"ARCSIN",  Op_Asin,   1},
+                               {"ASIN",    Op_Asin,   1},
+                               {"ARCCOS",  Op_Acos,   1},
+                               {"ACOS",    Op_Acos,   1},
+                               {"ARCTAN",  Op_Atan,   1},
+                               {"ATAN",    Op_Atan,   1},
+                               {"ARCTAN2", Op_Atan2,  2},
+                               {"ATAN2",   Op_Atan2,  2},
+                               {"SINH",    Op_Sinh,   1},
+                               {"COSH",    Op_Cosh,   1},
+                               {"TANH",    Op_Tanh,   1},
+                               {"FLOOR",   Op_Floor,  1},
+                               {"CEIL",    Op_Ceil,   1},
+                               {"ROUND",   Op_Round,  1},
+                               {"MIN",     Op_Min,    2},
+                               {"MAX",     Op_Max,    2},
+                               {"GAMMLN",  Op_Gammln, 1},
+                               {"ERF",     Op_Erf,    1},
+                               {"ERFC",    Op_Erfc,   1},
+                               {"NSRC",    Op_Nsrc,   0},
+                               {"NLAT",    Op_Nsrc,   0},
+                               {"NCPT",    Op_Ncpt,   0},
+                               {NULL,      0,         0}};
+
+
+/* Private Prototypes _______________________________________________________ */
+double      nr_gammp(double a, double x);
+double      nr_gammq(double a, double x);
+FormulaType fml_type(int op, FormulaType t1, FormulaType t2, FormulaType t3);
+int         fml_isnan(double x);
+double      fml_apply(int op, int integer, double a, double b, double c);
+void        fml_skip(const std::string &s, size_t &pos);
+int         fml_match(const std::string &s, size_t &pos, const char *token);
+
+
+/*============================================================================*/
+/*                              Private functions                             */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Return result type of plan operator
+ *
+ * @param[in] op Operator.
+ * @param[in] t1 Type of first argument.
+ * @param[in] t2 Type of second argument.
+ * @param[in] t3 Type of third argument.
+ *
+ * Follows the CFITSIO calculator: arithmetic on integers stays integer,
+ * comparisons and logical operators are logical, and all other functions
+ * are floating point.
+ ******************************************************************************/
+FormulaType fml_type(int op, FormulaType t1, FormulaType t2, FormulaType t3) {
+
+    // Map logical values on integer for arithmetic
+    FormulaType n1 = (t1 == Fml_Bool) ? Fml_Long : t1;
+    FormulaType n2 = (t2 == Fml_Bool) ? Fml_Long : t2;
+    FormulaType n3 = (t3 == Fml_Bool) ? Fml_Long : t3;
+
+    // Determine result type
+    switch (op) {
+    case Op_Neg:
+    case Op_Abs:
+      return n1;
+    case Op_Add:
+    case Op_Sub:
+    case Op_Mul:
+    case Op_Div:
+    case Op_Mod:
+    case Op_Min:
+    case Op_Max:
+      return (n1 == Fml_Long && n2 == Fml_Long) ? Fml_Long : Fml_Double;
+    case Op_Not:
+    case Op_Eq:
+    case Op_Ne:
+    case Op_Lt:
+    case Op_Le:
+    case Op_Gt:
+    case Op_Ge:
+    case Op_And:
+    case Op_Or:
+      return Fml_Bool;
+    case Op_Cond:
+      if (t2 == t3)
+        return t2;
+      return (n2 == Fml_Long && n3 == Fml_Long) ? Fml_Long : Fml_Double;
+    default:
+      return Fml_Double;
+    }
+
+}
+
+
+/**************************************************************************//**
+ * @brief Signals undefined (NaN) value
+ *
+ * @param[in] x Value.
+ ******************************************************************************/
+int fml_isnan(double x) {
+
+    // Return NaN flag
+    return (x != x);
+
+}
+
+
+/**************************************************************************//**
+ * @brief Apply plan operator to scalar arguments
+ *
+ * @param[in] op Operator.
+ * @param[in] integer Integer arithmetic.
+ * @param[in] a First argument.
+ * @param[in] b Second argument.
+ * @param[in] c Third argument.
+ *
+ * Undefined (NaN) arguments, e.g. NULL column values, propagate as in the
+ * CFITSIO calculator: the result is undefined unless a logical operator is
+ * already decided by its defined argument.
+ ******************************************************************************/
+double fml_apply(int op, int integer, double a, double b, double c) {
+
+    // Propagate undefined arguments
+    switch (op) {
+    case Op_And:
+      if ((a == 0.0) || (b == 0.0))
+        return 0.0;
+      if (fml_isnan(a) || fml_isnan(b))
+        return fml_nan;
+      break;
+    case Op_Or:
+      if ((a != 0.0 && !fml_isnan(a)) || (b != 0.0 && !fml_isnan(b)))
+        return 1.0;
+      if (fml_isnan(a) || fml_isnan(b))
+        return fml_nan;
+      break;
+    case Op_Cond:
+      if (fml_isnan(a))
+        return fml_nan;
+      break;
+    default:
+      if (fml_isnan(a) || fml_isnan(b) || fml_isnan(c))
+        return fml_nan;
+      break;
+    }
+
+    // Apply operator
+    switch (op) {
+    case Op_Neg:    return -a;
+    case Op_Not:    return (a == 0.0) ? 1.0 : 0.0;
+    case Op_Add:    return a + b;
+    case Op_Sub:    return a - b;
+    case Op_Mul:    return a * b;
+    case Op_Div:
+      if (integer)
+        return (b == 0.0) ? fml_nan : double((long long)a / (long long)b);
+      return a / b;
+    case Op_Mod:
+      if (integer)
+        return (b == 0.0) ? fml_nan : double((long long)a % (long long)b);
+      return fmod(a, b);
+    case Op_Pow:    return pow(a, b);
+    case Op_Eq:     return (a == b) ? 1.0 : 0.0;
+    case Op_Ne:     return (a != b) ? 1.0 : 0.0;
+    case Op_Lt:     return (a <  b) ? 1.0 : 0.0;
+    case Op_Le:     return (a <= b) ? 1.0 : 0.0;
+    case Op_Gt:     return (a >  b) ? 1.0 : 0.0;
+    case Op_Ge:     return (a >= b) ? 1.0 : 0.0;
+    case Op_And:    return (a != 0.0 && b != 0.0) ? 1.0 : 0.0;
+    case Op_Or:     return (a != 0.0 || b != 0.0) ? 1.0 : 0.0;
+    case Op_Cond:   return (a != 0.0) ? b : c;
+    case Op_Abs:    return fabs(a);
+    case Op_Sqrt:   return sqrt(a);
+    case Op_Exp:    return exp(a);
+    case Op_Log:    return log(a);
+    case Op_Log10:  return log10(a);
+    case Op_Sin:    return sin(a);
+    case Op_Cos:    return cos(a);
+    case Op_Tan:    return tan(a);
+    case Op_Asin:   return asin(a);
+    case Op_Acos:   return acos(a);
+    case Op_Atan:   return atan(a);
+    case Op_Atan2:  return atan2(a, b);
+    case Op_Sinh:   return sinh(a);
+    case Op_Cosh:   return cosh(a);
+    case Op_Tanh:   return tanh(a);
+    case Op_Floor:  return floor(a);
+    case Op_Ceil:   return ceil(a);
+    case Op_Round:  return floor(a + 0.5);
+    case Op_Min:    return (a < b) ? a : b;
+    case Op_Max:    return (a > b) ? a : b;
+    case Op_Gammln: {
+      // Implemented from Numerical Recipes, V2.08 (see funct_gammln)
+      double y   = a;
+      double tmp = a + 5.5;
+      tmp -= (a+0.5)*log(tmp);
+      double ser = 1.000000000190015;
+      ser += 76.18009172947146      / (++y);
+      ser -= 86.50532032941677      / (++y);
+      ser += 24.01409824083091      / (++y);
+      ser -=  1.231739572450155     / (++y);
+      ser +=  0.1208650973866179e-2 / (++y);
+      ser -=  0.5395239384953e-5    / (++y);
+      return -tmp+log(2.5066282746310005*ser/a);
+    }
+    case Op_Erf:
+      return (a < 0.0) ? -nr_gammp(0.5, a*a) : nr_gammp(0.5, a*a);
+    case Op_Erfc:
+      return (a < 0.0) ? 1.0 + nr_gammp(0.5, a*a) : nr_gammq(0.5, a*a);
+    default:        return 0.0;
+    }
+
+}
+
+
+/**************************************************************************//**
+ * @brief Skip whitespace in formula
+ *
+ * @param[in] s Formula.
+ * @param[in,out] pos Parsing position.
+ ******************************************************************************/
+void fml_skip(const std::string &s, size_t &pos) {
+
+    // Skip whitespace
+    while (pos < s.length() && isspace((unsigned char)s[pos]))
+      pos++;
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Match token in formula
+ *
+ * @param[in] s Formula.
+ * @param[in,out] pos Parsing position (behind token if matched).
+ * @param[in] token Token (dotted operators are matched case insensitive).
+ *
+ * Returns 1 if the token was matched, 0 otherwise.
+ ******************************************************************************/
+int fml_match(const std::string &s, size_t &pos, const char *token) {
+
+    // Skip whitespace
+    fml_skip(s, pos);
+
+    // Compare token
+    size_t i = 0;
+    for (; token[i] != '\0'; ++i) {
+      if (pos+i >= s.length() ||
+          toupper((unsigned char)s[pos+i]) != toupper((unsigned char)token[i]))
+        return 0;
+    }
+
+    // Step behind token
+    pos += i;
+
+    // Signal match
+    return 1;
+
+}
+
+
+/*============================================================================*/
+/*                        Constructor and destructor                          */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Constructor
+ ******************************************************************************/
+FormulaPlan::FormulaPlan(void) {
+
+    // Initialise plan
+    clear();
+
+}
+
+
+/**************************************************************************//**
+ * @brief Destructor
+ ******************************************************************************/
+FormulaPlan::~FormulaPlan(void) {
+
+}
+
+
+/*============================================================================*/
+/*                               Public methods                               */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Clear plan
+ ******************************************************************************/
+void FormulaPlan::clear(void) {
+
+    // Clear plan
+    m_nodes.clear();
+    m_roots.clear();
+    m_lookup.clear();
+    m_alias.clear();
+    m_val.clear();
+    m_type.clear();
+    m_use_alias = 0;
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Compile formula into plan
+ *
+ * @param[in] formula Formula.
+ * @param[in] name Name of output catalogue quantity (optional).
+ *
+ * Returns the formula index in the plan, or -1 if the formula can not be
+ * compiled.
+ *
+ * If a quantity name is given, earlier compiled quantities that are
+ * referenced by their name are resolved to their plan nodes instead of
+ * their catalogue columns (the quantities are evaluated in sequence, hence
+ * the column holds just this value), and the formula itself can be
+ * referenced by its name by subsequent quantities.
+ ******************************************************************************/
+int FormulaPlan::compile(const std::string &formula, const std::string &name) {
+
+    // Parse formula
+    m_use_alias = (name.length() > 0);
+    size_t pos  = 0;
+    int    root = parse_ternary(formula, pos);
+    m_use_alias = 0;
+
+    // Check that formula has been parsed completely
+    fml_skip(formula, pos);
+    if (root < 0 || pos != formula.length())
+      return -1;
+
+    // Register formula
+    m_roots.push_back(root);
+    if (name.length() > 0) {
+      std::string u_name = name;
+      for (size_t i = 0; i < u_name.length(); ++i)
+        u_name[i] = toupper((unsigned char)u_name[i]);
+      m_alias[u_name] = root;
+    }
+
+    // Return formula index
+    return (int)m_roots.size() - 1;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Get names of catalogue columns used by formulas
+ *
+ * @param[in] ids Formula indices (-1 entries are ignored).
+ * @param[out] names Upper case column names.
+ ******************************************************************************/
+void FormulaPlan::columns(const std::vector<int> &ids,
+                          std::vector<std::string> &names) const {
+
+    // Mark all nodes used by the formulas
+    std::vector<char> used(m_nodes.size(), 0);
+    for (int i = 0; i < (int)ids.size(); ++i) {
+      if (ids[i] >= 0 && ids[i] < (int)m_roots.size())
+        mark(m_roots[ids[i]], used);
+    }
+
+    // Collect column names
+    names.clear();
+    for (int i = 0; i < (int)m_nodes.size(); ++i) {
+      if (used[i] && m_nodes[i].op == Op_Column)
+        names.push_back(m_nodes[i].name);
+    }
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Evaluate formulas
+ *
+ * @param[in] ids Formula indices (-1 entries are ignored).
+ * @param[in] numRows Number of catalogue rows.
+ * @param[in] names Column names (see columns()).
+ * @param[in] types Column types (Fml_Invalid if the column is not usable).
+ * @param[in] values Column values.
+ * @param[in] nsrc Number of sources (value of nsrc()).
+ * @param[in] ncpt Number of counterparts (value of ncpt()).
+ * @param[out] res Formula values (empty if the formula could not be evaluated).
+ * @param[out] res_types Formula result types.
+ *
+ * Each node that is needed by any of the formulas is evaluated exactly once,
+ * one operator at a time over all rows.
+ ******************************************************************************/
+void FormulaPlan::eval(const std::vector<int> &ids, long numRows,
+                       const std::vector<std::string> &names,
+                       const std::vector<FormulaType> &types,
+                       const std::vector<std::vector<double> > &values,
+                       double nsrc, double ncpt,
+                       std::vector<std::vector<double> > &res,
+                       std::vector<FormulaType> &res_types) {
+
+    // Allocate results
+    int num = (int)ids.size();
+    res       = std::vector<std::vector<double> >(num);
+    res_types = std::vector<FormulaType>(num, Fml_Invalid);
+
+    // Mark all nodes used by the formulas
+    int               numNodes = (int)m_nodes.size();
+    std::vector<char> used(numNodes, 0);
+    for (int i = 0; i < num; ++i) {
+      if (ids[i] >= 0 && ids[i] < (int)m_roots.size())
+        mark(m_roots[ids[i]], used);
+    }
+
+    // Map column names on column values
+    std::map<std::string, int> column;
+    for (int i = 0; i < (int)names.size(); ++i)
+      column[names[i]] = i;
+
+    // Allocate node values (memory is kept between evaluations)
+    if ((int)m_val.size() < numNodes)
+      m_val.resize(numNodes);
+    m_type = std::vector<FormulaType>(numNodes, Fml_Invalid);
+    std::vector<const double*> ptr(numNodes, (const double*)NULL);
+
+    // Evaluate nodes (arguments always precede the node using them)
+    for (int inx = 0; inx < numNodes; ++inx) {
+
+      // Skip nodes that are not needed
+      if (!used[inx])
+        continue;
+
+      // Get node
+      const FormulaNode &node = m_nodes[inx];
+
+      // Column nodes point directly on the column values
+      if (node.op == Op_Column) {
+        std::map<std::string, int>::const_iterator it = column.find(node.name);
+        if (it != column.end() && types[it->second] != Fml_Invalid &&
+            (long)values[it->second].size() >= numRows) {
+          m_type[inx] = types[it->second];
+          ptr[inx]    = (numRows > 0) ? &(values[it->second][0]) : NULL;
+        }
+        continue;
+      }
+
+      // Determine node type. Skip node if an argument is invalid
+      FormulaType t[3] = {Fml_Double, Fml_Double, Fml_Double};
+      int         valid = 1;
+      for (int k = 0; k < 3; ++k) {
+        if (node.arg[k] >= 0) {
+          t[k] = m_type[node.arg[k]];
+          if (t[k] == Fml_Invalid)
+            valid = 0;
+        }
+      }
+      if (!valid)
+        continue;
+      if (node.op == Op_Const)
+        m_type[inx] = node.type;
+      else
+        m_type[inx] = fml_type(node.op, t[0], t[1], t[2]);
+
+      // Allocate node values
+      std::vector<double> &val = m_val[inx];
+      val.resize(numRows);
+      double *v = (numRows > 0) ? &(val[0]) : NULL;
+      ptr[inx]  = v;
+
+      // Evaluate node
+      switch (node.op) {
+      case Op_Const:
+        for (long row = 0; row < numRows; ++row)
+          v[row] = node.value;
+        break;
+      case Op_Nsrc:
+        for (long row = 0; row < numRows; ++row)
+          v[row] = nsrc;
+        break;
+      case Op_Ncpt:
+        for (long row = 0; row < numRows; ++row)
+          v[row] = ncpt;
+        break;
+      default:
+        {
+          int           integer = (m_type[inx] == Fml_Long);
+          const double *a = (node.arg[0] >= 0) ? ptr[node.arg[0]] : NULL;
+          const double *b = (node.arg[1] >= 0) ? ptr[node.arg[1]] : NULL;
+          const double *c = (node.arg[2] >= 0) ? ptr[node.arg[2]] : NULL;
+          if (c != NULL) {
+            for (long row = 0; row < numRows; ++row)
+              v[row] = fml_apply(node.op, integer, a[row], b[row], c[row]);
+          }
+          else if (b != NULL) {
+            for (long row = 0; row < numRows; ++row)
+              v[row] = fml_apply(node.op, integer, a[row], b[row], 0.0);
+          }
+          else {
+            for (long row = 0; row < numRows; ++row)
+              v[row] = fml_apply(node.op, integer, a[row], 0.0, 0.0);
+          }
+        }
+        break;
+      }
+
+    } // endfor: looped over nodes
+
+    // Gather formula results
+    for (int i = 0; i < num; ++i) {
+      if (ids[i] < 0 || ids[i] >= (int)m_roots.size())
+        continue;
+      int root = m_roots[ids[i]];
+      if (m_type[root] == Fml_Invalid)
+        continue;
+      res[i]       = (numRows > 0) ? std::vector<double>(ptr[root], ptr[root]+numRows)
+                                   : std::vector<double>();
+      res_types[i] = m_type[root];
+    }
+
+    // Return
+    return;
+
+}
+
+
+/*============================================================================*/
+/*                               Private methods                              */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Add node to plan
+ *
+ * @param[in] op Operator.
+ * @param[in] a1 First argument node.
+ * @param[in] a2 Second argument node.
+ * @param[in] a3 Third argument node.
+ * @param[in] value Constant value.
+ * @param[in] type Constant type.
+ * @param[in] name Column name.
+ *
+ * Returns the index of an identical node if it exists already in the plan.
+ * Operators with constant arguments are folded into a constant node.
+ ******************************************************************************/
+int FormulaPlan::node(int op, int a1, int a2, int a3, double value,
+                      FormulaType type, const std::string &name) {
+
+    // Fold constant arguments
+    if (op != Op_Const && op != Op_Column && op != Op_Nsrc && op != Op_Ncpt) {
+      int         args[3] = {a1, a2, a3};
+      double      v[3]    = {0.0, 0.0, 0.0};
+      FormulaType t[3]    = {Fml_Double, Fml_Double, Fml_Double};
+      int         fold    = 1;
+      for (int k = 0; k < 3; ++k) {
+        if (args[k] >= 0) {
+          if (m_nodes[args[k]].op != Op_Const) {
+            fold = 0;
+            break;
+          }
+          v[k] = m_nodes[args[k]].value;
+          t[k] = m_nodes[args[k]].type;
+        }
+      }
+      if (fold) {
+        type  = fml_type(op, t[0], t[1], t[2]);
+        value = fml_apply(op, (type == Fml_Long), v[0], v[1], v[2]);
+        op    = Op_Const;
+        a1    = -1;
+        a2    = -1;
+        a3    = -1;
+      }
+    }
+
+    // Build node signature
+    char buffer[128];
+    sprintf(buffer, "%d:%d:%d:%d:%d:%.17g:", op, a1, a2, a3, (int)type, value);
+    std::string signature = std::string(buffer) + name;
+
+    // Return existing node
+    std::map<std::string, int>::const_iterator it = m_lookup.find(signature);
+    if (it != m_lookup.end())
+      return it->second;
+
+    // Append new node
+    FormulaNode node;
+    node.op     = op;
+    node.arg[0] = a1;
+    node.arg[1] = a2;
+    node.arg[2] = a3;
+    node.value  = value;
+    node.type   = type;
+    node.name   = name;
+    m_nodes.push_back(node);
+    m_lookup[signature] = (int)m_nodes.size() - 1;
+
+    // Return node index
+    return (int)m_nodes.size() - 1;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Mark node and all its arguments as used
+ *
+ * @param[in] inx Node index.
+ * @param[in,out] used Node usage flags.
+ ******************************************************************************/
+void FormulaPlan::mark(int inx, std::vector<char> &used) const {
+
+    // Mark node and its arguments
+    if (inx >= 0 && !used[inx]) {
+      used[inx] = 1;
+      for (int k = 0; k < 3; ++k)
+        mark(m_nodes[inx].arg[k], used);
+    }
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Parse conditional expression (a ? b : c)
+ *
+ * @param[in] s Formula.
+ * @param[in,out] pos Parsing position.
+ *
+ * The parse methods implement the operator precedence of the CFITSIO
+ * calculator. They return the plan node of the expression, or -1 if the
+ * expression can not be compiled.
+ ******************************************************************************/
+int FormulaPlan::parse_ternary(const std::string &s, size_t &pos) {
+
+    // Parse condition
+    int a = parse_or(s, pos);
+    if (a < 0 || !fml_match(s, pos, "?"))
+      return a;
+
+    // Parse alternatives
+    int b = parse_ternary(s, pos);
+    if (b < 0 || !fml_match(s, pos, ":"))
+      return -1;
+    int c = parse_ternary(s, pos);
+    if (c < 0)
+      return -1;
+
+    // Return node
+    return node(Op_Cond, a, b, c);
+
+}
+
+
+/**************************************************************************//**
+ * @brief Parse logical or (a || b)
+ *
+ * @param[in] s Formula.
+ * @param[in,out] pos Parsing position.
+ ******************************************************************************/
+int FormulaPlan::parse_or(const std::string &s, size_t &pos) {
+
+    // Parse operands
+    int a = parse_and(s, pos);
+    while (a >= 0) {
+      if (!fml_match(s, pos, "||") && !fml_match(s, pos, ".OR."))
+        break;
+      int b = parse_and(s, pos);
+      a     = (b < 0) ? -1 : node(Op_Or, a, b);
+    }
+
+    // Return node
+    return a;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Parse logical and (a && b)
+ *
+ * @param[in] s Formula.
+ * @param[in,out] pos Parsing position.
+ ******************************************************************************/
+int FormulaPlan::parse_and(const std::string &s, size_t &pos) {
+
+    // Parse operands
+    int a = parse_equal(s, pos);
+    while (a >= 0) {
+      if (!fml_match(s, pos, "&&") && !fml_match(s, pos, ".AND."))
+        break;
+      int b = parse_equal(s, pos);
+      a     = (b < 0) ? -1 : node(Op_And, a, b);
+    }
+
+    // Return node
+    return a;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Parse equality (a == b, a != b)
+ *
+ * @param[in] s Formula.
+ * @param[in,out] pos Parsing position.
+ ******************************************************************************/
+int FormulaPlan::parse_equal(const std::string &s, size_t &pos) {
+
+    // Parse operands
+    int a = parse_compare(s, pos);
+    while (a >= 0) {
+      int op;
+      if (fml_match(s, pos, "==") || fml_match(s, pos, ".EQ."))
+        op = Op_Eq;
+      else if (fml_match(s, pos, "!=") || fml_match(s, pos, ".NE."))
+        op = Op_Ne;
+      else
+        break;
+      int b = parse_compare(s, pos);
+      a     = (b < 0) ? -1 : node(op, a, b);
+    }
+
+    // Return node
+    return a;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Parse comparison (a < b, a <= b, a > b, a >= b)
+ *
+ * @param[in] s Formula.
+ * @param[in,out] pos Parsing position.
+ ******************************************************************************/
+int FormulaPlan::parse_compare(const std::string &s, size_t &pos) {
+
+    // Parse operands
+    int a = parse_sum(s, pos);
+    while (a >= 0) {
+      int op;
+      if (fml_match(s, pos, "<=") || fml_match(s, pos, ".LE."))
+        op = Op_Le;
+      else if (fml_match(s, pos, ">=") || fml_match(s, pos, ".GE."))
+        op = Op_Ge;
+      else if (fml_match(s, pos, "<") || fml_match(s, pos, ".LT."))
+        op = Op_Lt;
+      else if (fml_match(s, pos, ">") || fml_match(s, pos, ".GT."))
+        op = Op_Gt;
+      else
+        break;
+      int b = parse_sum(s, pos);
+      a     = (b < 0) ? -1 : node(op, a, b);
+    }
+
+    // Return node
+    return a;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Parse sum (a + b, a - b, a % b)
+ *
+ * @param[in] s Formula.
+ * @param[in,out] pos Parsing position.
+ ******************************************************************************/
+int FormulaPlan::parse_sum(const std::string &s, size_t &pos) {
+
+    // Parse operands
+    int a = parse_product(s, pos);
+    while (a >= 0) {
+      int op;
+      if (fml_match(s, pos, "+"))
+        op = Op_Add;
+      else if (fml_match(s, pos, "-"))
+        op = Op_Sub;
+      else if (fml_match(s, pos, "%"))
+        op = Op_Mod;
+      else
+        break;
+      int b = parse_product(s, pos);
+      a     = (b < 0) ? -1 : node(op, a, b);
+    }
+
+    // Return node
+    return a;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Parse product (a * b, a / b)
+ *
+ * @param[in] s Formula.
+ * @param[in,out] pos Parsing position.
+ *
+ * As in the CFITSIO calculator the modulo operator has the precedence of
+ * the sum and is handled by parse_sum().
+ ******************************************************************************/
+int FormulaPlan::parse_product(const std::string &s, size_t &pos) {
+
+    // Parse operands
+    int a = parse_power(s, pos);
+    while (a >= 0) {
+      int    op;
+      size_t save = pos;
+      if (fml_match(s, pos, "**")) {       // Power is handled below
+        pos = save;
+        break;
+      }
+      if (fml_match(s, pos, "*"))
+        op = Op_Mul;
+      else if (fml_match(s, pos, "/"))
+        op = Op_Div;
+      else
+        break;
+      int b = parse_power(s, pos);
+      a     = (b < 0) ? -1 : node(op, a, b);
+    }
+
+    // Return node
+    return a;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Parse unary operators (-a, +a, !a)
+ *
+ * @param[in] s Formula.
+ * @param[in,out] pos Parsing position.
+ *
+ * As in the CFITSIO calculator unary operators bind tighter than the power
+ * operator, hence -a**2 is evaluated as (-a)**2.
+ ******************************************************************************/
+int FormulaPlan::parse_unary(const std::string &s, size_t &pos) {
+
+    // Unary minus
+    if (fml_match(s, pos, "-")) {
+      int a = parse_unary(s, pos);
+      return (a < 0) ? -1 : node(Op_Neg, a);
+    }
+
+    // Unary plus
+    if (fml_match(s, pos, "+"))
+      return parse_unary(s, pos);
+
+    // Logical not
+    size_t save = pos;
+    if (fml_match(s, pos, "!=")) {
+      pos = save;
+      return -1;
+    }
+    if (fml_match(s, pos, "!") || fml_match(s, pos, ".NOT.")) {
+      int a = parse_unary(s, pos);
+      return (a < 0) ? -1 : node(Op_Not, a);
+    }
+
+    // Primary expression
+    return parse_primary(s, pos);
+
+}
+
+
+/**************************************************************************//**
+ * @brief Parse power (a ** b, a ^ b)
+ *
+ * @param[in] s Formula.
+ * @param[in,out] pos Parsing position.
+ *
+ * The power operator is right associative and binds weaker than the
+ * unary operators.
+ ******************************************************************************/
+int FormulaPlan::parse_power(const std::string &s, size_t &pos) {
+
+    // Parse base
+    int a = parse_unary(s, pos);
+    if (a < 0)
+      return -1;
+
+    // Parse exponent
+    if (fml_match(s, pos, "**") || fml_match(s, pos, "^")) {
+      int b = parse_power(s, pos);
+      return (b < 0) ? -1 : node(Op_Pow, a, b);
+    }
+
+    // Return node
+    return a;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Parse primary expression
+ *
+ * @param[in] s Formula.
+ * @param[in,out] pos Parsing position.
+ *
+ * Primary expressions are parenthesised expressions, numbers, the constants
+ * #PI, #E and #DEG, functions and column names (also $name$).
+ ******************************************************************************/
+int FormulaPlan::parse_primary(const std::string &s, size_t &pos) {
+
+    // Skip whitespace
+    fml_skip(s, pos);
+    if (pos >= s.length())
+      return -1;
+
+    // Parenthesised expression
+    if (s[pos] == '(') {
+      pos++;
+      int a = parse_ternary(s, pos);
+      if (a < 0 || !fml_match(s, pos, ")"))
+        return -1;
+      return a;
+    }
+
+    // Number
+    if (isdigit((unsigned char)s[pos]) ||
+        (s[pos] == '.' && pos+1 < s.length() &&
+         isdigit((unsigned char)s[pos+1]))) {
+      size_t start   = pos;
+      int    integer = 1;
+      while (pos < s.length() && isdigit((unsigned char)s[pos]))
+        pos++;
+      if (pos < s.length() && s[pos] == '.') {
+        integer = 0;
+        pos++;
+        while (pos < s.length() && isdigit((unsigned char)s[pos]))
+          pos++;
+      }
+      if (pos < s.length() && strchr("eEdD", s[pos]) != NULL) {
+        size_t exp = pos + 1;
+        if (exp < s.length() && (s[exp] == '+' || s[exp] == '-'))
+          exp++;
+        if (exp < s.length() && isdigit((unsigned char)s[exp])) {
+          integer = 0;
+          pos     = exp;
+          while (pos < s.length() && isdigit((unsigned char)s[pos]))
+            pos++;
+        }
+      }
+      std::string number = s.substr(start, pos-start);
+      for (size_t i = 0; i < number.length(); ++i) {
+        if (number[i] == 'd' || number[i] == 'D')
+          number[i] = 'e';
+      }
+      double value = strtod(number.c_str(), NULL);
+      return node(Op_Const, -1, -1, -1, value, integer ? Fml_Long : Fml_Double);
+    }
+
+    // Constants
+    if (s[pos] == '#') {
+      if (fml_match(s, pos, "#PI"))
+        return node(Op_Const, -1, -1, -1, fml_pi);
+      if (fml_match(s, pos, "#E"))
+        return node(Op_Const, -1, -1, -1, fml_e);
+      if (fml_match(s, pos, "#DEG"))
+        return node(Op_Const, -1, -1, -1, fml_pi/180.0);
+      return -1;
+    }
+
+    // Get name (quoted column names are enclosed in $)
+    std::string name;
+    int         quoted = 0;
+    if (s[pos] == '$') {
+      size_t stop = s.find('$', pos+1);
+      if (stop == std::string::npos)
+        return -1;
+      name   = s.substr(pos+1, stop-pos-1);
+      pos    = stop + 1;
+      quoted = 1;
+    }
+    else if (isalpha((unsigned char)s[pos]) || s[pos] == '_') {
+      size_t start = pos;
+      while (pos < s.length() &&
+             (isalnum((unsigned char)s[pos]) || s[pos] == '_'))
+        pos++;
+      name = s.substr(start, pos-start);
+    }
+    else
+      return -1;
+    for (size_t i = 0; i < name.length(); ++i)
+      name[i] = toupper((unsigned char)name[i]);
+
+    // Function
+    size_t save = pos;
+    if (!quoted && fml_match(s, pos, "(")) {
+
+      // Search function
+      int fct = -1;
+      for (int i = 0; fml_fcts[i].name != NULL; ++i) {
+        if (name == fml_fcts[i].name) {
+          fct = i;
+          break;
+        }
+      }
+      if (fct < 0)
+        return -1;
+
+      // Parse arguments
+      int args[3] = {-1, -1, -1};
+      int nargs   = 0;
+      if (!fml_match(s, pos, ")")) {
+        do {
+          if (nargs >= 3)
+            return -1;
+          args[nargs] = parse_ternary(s, pos);
+          if (args[nargs] < 0)
+            return -1;
+          nargs++;
+        } while (fml_match(s, pos, ","));
+        if (!fml_match(s, pos, ")"))
+          return -1;
+      }
+      if (nargs != fml_fcts[fct].nargs)
+        return -1;
+
+      // Return node
+      return node(fml_fcts[fct].op, args[0], args[1], args[2]);
+
+    }
+    pos = save;
+
+    // Earlier output catalogue quantity
+    if (m_use_alias) {
+      std::map<std::string, int>::const_iterator it = m_alias.find(name);
+      if (it != m_alias.end())
+        return it->second;
+    }
+
+    // Column
+    return node(Op_Column, -1, -1, -1, 0.0, Fml_Double, name);
+
+}
+
+
+/* Namespace ends ___________________________________________________________ */
+}
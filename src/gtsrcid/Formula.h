@@ -0,0 +1,102 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file Formula.h
+ * @brief Compiled formula evaluation plan interface definition.
+ * @author J. Knodlseder
+ */
+
+#ifndef FORMULA_H
+#define FORMULA_H
+
+/* Includes _________________________________________________________________ */
+#include <string>
+#include <vector>
+#include <map>
+#include "sourceIdentify.h"
+
+
+/* Namespace definition _____________________________________________________ */
+namespace sourceIdentify {
+
+
+/* Type defintions __________________________________________________________ */
+typedef enum {                  // Formula value types
+  Fml_Double = 0,               //!< Floating point value
+  Fml_Long,                     //!< Integer value
+  Fml_Bool,                     //!< Logical value
+  Fml_Invalid                   //!< Value that can not be handled by the plan
+} FormulaType;
+
+typedef struct {                // Formula plan node
+  int         op;               //!< Operator (see Formula.cxx)
+  int         arg[3];           //!< Argument nodes (-1 if not used)
+  double      value;            //!< Constant value
+  FormulaType type;             //!< Constant or column type
+  std::string name;             //!< Column name
+} FormulaNode;
+
+
+/* Classes __________________________________________________________________ */
+class FormulaPlan {
+public:
+
+  // Constructor & destructor
+  FormulaPlan(void);
+ ~FormulaPlan(void);
+
+  // Public methods
+  void        clear(void);
+  int         compile(const std::string &formula,
+                      const std::string &name = "");
+  int         numFormulas(void) const;            // Inline
+  int         numNodes(void) const;               // Inline
+  void        columns(const std::vector<int> &ids,
+                      std::vector<std::string> &names) const;
+  void        eval(const std::vector<int> &ids, long numRows,
+                   const std::vector<std::string> &names,
+                   const std::vector<FormulaType> &types,
+                   const std::vector<std::vector<double> > &values,
+                   double nsrc, double ncpt,
+                   std::vector<std::vector<double> > &res,
+                   std::vector<FormulaType> &res_types);
+
+  // Private methods
+private:
+  int         parse_ternary(const std::string &s, size_t &pos);
+  int         parse_or(const std::string &s, size_t &pos);
+  int         parse_and(const std::string &s, size_t &pos);
+  int         parse_equal(const std::string &s, size_t &pos);
+  int         parse_compare(const std::string &s, size_t &pos);
+  int         parse_sum(const std::string &s, size_t &pos);
+  int         parse_product(const std::string &s, size_t &pos);
+  int         parse_unary(const std::string &s, size_t &pos);
+  int         parse_power(const std::string &s, size_t &pos);
+  int         parse_primary(const std::string &s, size_t &pos);
+  int         node(int op, int a1 = -1, int a2 = -1, int a3 = -1,
+                   double value = 0.0, FormulaType type = Fml_Double,
+                   const std::string &name = "");
+  void        mark(int inx, std::vector<char> &used) const;
+
+  // Private data area
+  std::vector<FormulaNode>          m_nodes;     //!< Plan nodes (arguments first)
+  std::vector<int>                  m_roots;     //!< Root node of each formula
+  std::map<std::string, int>        m_lookup;    //!< Node signature -> node
+  std::map<std::string, int>        m_alias;     //!< Quantity name -> root node
+  int                               m_use_alias; //!< Resolve quantity names
+  std::vector<std::vector<double> > m_val;       //!< Node values
+  std::vector<FormulaType>          m_type;      //!< Node types
+};
+inline int FormulaPlan::numFormulas(void) const { return (int)m_roots.size(); }
+inline int FormulaPlan::numNodes(void) const { return (int)m_nodes.size(); }
+
+
+/* Namespace ends ___________________________________________________________ */
+}
+#endif // FORMULA_H
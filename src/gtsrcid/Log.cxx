@@ -30,6 +30,9 @@ Replace header information with CVS typeset information.
 #include <time.h>       // for time functions
 #include "sourceIdentify.h"
 #include "Log.h"
+#if LOG_ASYNC_WRITER
+#include <pthread.h>    // for writer thread
+#endif
 
 
 /* Namespace definition _____________________________________________________ */
@@ -41,11 +44,213 @@ char  gLogTaskName[100];
 FILE *gLogFilePtr = NULL;
 
 
+/* Constants ________________________________________________________________ */
+const char *c_log_type[] = {"Unknown",
+                            "Error_0", "Error_1", "Error_2", "Error_3",
+                            "Warn_0 ", "Warn_1 ", "Warn_2 ", "Warn_3 ",
+                            "Alert_0", "Alert_1", "Alert_2", "Alert_3",
+                            "Log_0  ", "Log_1  ", "Log_2  ", "Log_3  "};
+
+
 /* Type defintions __________________________________________________________ */
+typedef struct {                // Log buffer
+  char   *text;                 //!< Buffer text
+  size_t  fill;                 //!< Number of bytes in buffer
+} LogBuffer;
+
+
+/* Private globals __________________________________________________________ */
+static char      g_log_text[2][LOG_BUFFER_SIZE]; // Double buffer
+static LogBuffer g_log_buf[2] = {{g_log_text[0], 0}, {g_log_text[1], 0}};
+static int       g_log_active  = 0;              // Buffer being filled
+static int       g_log_detach  = 0;              // Forked child, no logging
+static time_t    g_log_time    = (time_t)-1;     // Time of cached stamp
+static char      g_log_stamp[200];               // Cached time stamp
+static size_t    g_log_stamp_len = 0;            // Length of time stamp
+#if LOG_ASYNC_WRITER
+static pthread_mutex_t g_log_mutex   = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  g_log_request = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  g_log_done    = PTHREAD_COND_INITIALIZER;
+static pthread_t       g_log_thread;
+static int             g_log_async   = 0;        // Writer thread running
+static int             g_log_stop    = 0;        // Writer thread stop flag
+static int             g_log_pending = -1;       // Buffer to be written
+#endif
 
 
 /* Prototypes _______________________________________________________________ */
+static void log_write(LogBuffer *buf);
+static void log_swap(void);
+static void log_flush(void);
+static void log_stamp(time_t now);
+#if LOG_ASYNC_WRITER
+static void *log_writer(void *arg);
+#endif
+
+
+/*============================================================================*/
+/*                              Private functions                             */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Write log buffer to log file
+ *
+ * @param[in] buf Pointer to log buffer.
+ ******************************************************************************/
+static void log_write(LogBuffer *buf) {
+
+    // Write buffer and reset fill level
+    if (buf->fill > 0 && gLogFilePtr != NULL) {
+      fwrite(buf->text, 1, buf->fill, gLogFilePtr);
+      fflush(gLogFilePtr);
+    }
+    buf->fill = 0;
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Hand over active log buffer for writing
+ *
+ * If the writer thread is running, the active buffer is passed to the thread
+ * and logging continues in the other buffer. Otherwise the active buffer is
+ * written directly. The log mutex needs to be locked by the caller.
+ ******************************************************************************/
+static void log_swap(void) {
+
+    #if LOG_ASYNC_WRITER
+    if (g_log_async) {
+      while (g_log_pending >= 0)
+        pthread_cond_wait(&g_log_done, &g_log_mutex);
+      g_log_pending = g_log_active;
+      g_log_active  = 1 - g_log_active;
+      pthread_cond_signal(&g_log_request);
+      return;
+    }
+    #endif
+
+    // Synchronous writing
+    log_write(&g_log_buf[g_log_active]);
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Write active log buffer to log file
+ *
+ * Hands over the active buffer like log_swap(), but returns only after the
+ * buffer has been written, also if the writer thread is running. The log
+ * mutex needs to be locked by the caller.
+ ******************************************************************************/
+static void log_flush(void) {
+
+    // Hand over active buffer
+    log_swap();
+
+    // Wait until writer thread has written the buffer
+    #if LOG_ASYNC_WRITER
+    if (g_log_async) {
+      while (g_log_pending >= 0)
+        pthread_cond_wait(&g_log_done, &g_log_mutex);
+    }
+    #endif
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Update cached time stamp
+ *
+ * @param[in] now Actual time.
+ *
+ * The time stamp and task name that precede each log message only change
+ * once per second, hence they are formatted only when the time changes.
+ ******************************************************************************/
+static void log_stamp(time_t now) {
+
+    // Declare local variables
+    struct tm timeStruct;
 
+    // Break down time
+    #ifdef HAVE_GMTIME_R
+    gmtime_r(&now, &timeStruct);
+    #else
+    memcpy(&timeStruct, gmtime(&now), sizeof(struct tm));
+    #endif
+
+    // Format time stamp
+    int len = sprintf(g_log_stamp, " %04d-%02d-%02dT%02d:%02d:%02d %s: ",
+                      timeStruct.tm_year + 1900,
+                      timeStruct.tm_mon + 1,
+                      timeStruct.tm_mday,
+                      timeStruct.tm_hour,
+                      timeStruct.tm_min,
+                      timeStruct.tm_sec,
+                      gLogTaskName);
+    g_log_stamp_len = (len > 0) ? (size_t)len : 0;
+    g_log_time      = now;
+
+    // Return
+    return;
+
+}
+
+
+#if LOG_ASYNC_WRITER
+/**************************************************************************//**
+ * @brief Log writer thread
+ *
+ * Writes log buffers that are handed over by log_swap() until a stop is
+ * requested.
+ ******************************************************************************/
+static void *log_writer(void *) {
+
+    // Lock mutex
+    pthread_mutex_lock(&g_log_mutex);
+
+    // Loop until stop is requested and no buffer is pending
+    while (1) {
+
+      // Wait for buffer
+      while (g_log_pending < 0 && !g_log_stop)
+        pthread_cond_wait(&g_log_request, &g_log_mutex);
+      if (g_log_pending < 0)
+        break;
+
+      // Write buffer without holding the mutex
+      int pending = g_log_pending;
+      pthread_mutex_unlock(&g_log_mutex);
+      log_write(&g_log_buf[pending]);
+      pthread_mutex_lock(&g_log_mutex);
+
+      // Signal that buffer is free
+      g_log_pending = -1;
+      pthread_cond_broadcast(&g_log_done);
+
+    } // endwhile: loop until stop
+
+    // Unlock mutex
+    pthread_mutex_unlock(&g_log_mutex);
+
+    // Return
+    return NULL;
+
+}
+#endif
+
+
+/*============================================================================*/
+/*                              Public functions                              */
+/*============================================================================*/
 
 /**************************************************************************//**
  * @brief Initialise task logging
@@ -90,6 +295,9 @@ Status LogInit(const char *logName, const char *taskName, Status status) {
       // Store log task name
       sprintf(gLogTaskName, "%s", taskName);
 
+      // Invalidate time stamp cache
+      g_log_time = (time_t)-1;
+
     } while (0); // End of main do-loop
 
     // Return status
@@ -102,6 +310,9 @@ Status LogInit(const char *logName, const char *taskName, Status status) {
  * @brief Finish task logging
  *
  * @param[in] status Error status.
+ *
+ * Stops the writer thread (if running), writes all buffered messages and
+ * closes the log file.
  ******************************************************************************/
 Status LogClose(Status status) {
 
@@ -110,9 +321,15 @@ Status LogClose(Status status) {
     // Main do-loop to fall through in case of an error
     do {
 
+      // Stop writer thread
+      LogAsync(0, STATUS_OK);
+
       // Close log file
-      if (gLogFilePtr != NULL)
+      if (gLogFilePtr != NULL) {
+        log_write(&g_log_buf[g_log_active]);
         fclose(gLogFilePtr);
+        gLogFilePtr = NULL;
+      }
       else {
         status = STATUS_LOG_CLOSE_FAILED;
         continue;
@@ -126,11 +343,135 @@ Status LogClose(Status status) {
 }
 
 
+/**************************************************************************//**
+ * @brief Write all buffered log messages to the log file
+ *
+ * @param[in] status Error status.
+ ******************************************************************************/
+Status LogFlush(Status status) {
+
+    // Declare (and initialise) variables
+
+    // Main do-loop to fall through in case of an error
+    do {
+
+      // Fall through if no log file is open or in a detached child process
+      if (gLogFilePtr == NULL || g_log_detach)
+        continue;
+
+      // Hand over active buffer and wait until it has been written
+      #if LOG_ASYNC_WRITER
+      pthread_mutex_lock(&g_log_mutex);
+      log_swap();
+      while (g_log_pending >= 0)
+        pthread_cond_wait(&g_log_done, &g_log_mutex);
+      pthread_mutex_unlock(&g_log_mutex);
+      #else
+      log_swap();
+      #endif
+
+    } while (0); // End of main do-loop
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Start or stop the background log writer thread
+ *
+ * @param[in] enable Start (1) or stop (0) the writer thread.
+ * @param[in] status Error status.
+ *
+ * With the writer thread running, full log buffers are written to disk while
+ * the task continues logging into a second buffer. On platforms without
+ * thread support the request is ignored and logging remains synchronous.
+ ******************************************************************************/
+Status LogAsync(int enable, Status status) {
+
+    // Declare (and initialise) variables
+
+    // Main do-loop to fall through in case of an error
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      #if LOG_ASYNC_WRITER
+      // Start writer thread
+      if (enable && !g_log_async) {
+        pthread_mutex_lock(&g_log_mutex);
+        g_log_stop    = 0;
+        g_log_pending = -1;
+        if (pthread_create(&g_log_thread, NULL, log_writer, NULL) == 0)
+          g_log_async = 1;
+        pthread_mutex_unlock(&g_log_mutex);
+      }
+
+      // Stop writer thread once all pending buffers have been written
+      else if (!enable && g_log_async) {
+        pthread_mutex_lock(&g_log_mutex);
+        g_log_stop = 1;
+        pthread_cond_signal(&g_log_request);
+        pthread_mutex_unlock(&g_log_mutex);
+        pthread_join(g_log_thread, NULL);
+        g_log_async = 0;
+      }
+      #endif
+
+    } while (0); // End of main do-loop
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Detach forked child process from logging
+ *
+ * Switches logging off in a child process. The log buffers belong to the
+ * parent, which needs to call LogFlush() before fork(), and the writer
+ * thread does not exist in the child, hence the asynchronous state and the
+ * log mutex (which may have been held by the writer thread at fork()) are
+ * reset. The log file is neither written nor closed.
+ ******************************************************************************/
+void LogDetach(void) {
+
+    // Discard buffers and stop logging
+    g_log_buf[0].fill = 0;
+    g_log_buf[1].fill = 0;
+    g_log_detach      = 1;
+
+    // Reset asynchronous writer state
+    #if LOG_ASYNC_WRITER
+    pthread_mutex_init(&g_log_mutex, NULL);
+    pthread_cond_init(&g_log_request, NULL);
+    pthread_cond_init(&g_log_done, NULL);
+    g_log_async   = 0;
+    g_log_stop    = 0;
+    g_log_pending = -1;
+    #endif
+
+    // Return
+    return;
+
+}
+
+
 /**************************************************************************//**
  * @brief Log message
  *
  * @param[in] msgType Message type.
  * @param[in] msgFormat Pointer to message format.
+ *
+ * The message is formatted directly into the log buffer, preceded by the
+ * message type and the cached time stamp. The buffer is handed over for
+ * writing when it is nearly full. Error messages are written before the
+ * function returns, also with the writer thread, so that errors reach the
+ * log file even if the task crashes afterwards.
  ******************************************************************************/
 Status Log(MessageType msgType, const char *msgFormat, ...) {
 
@@ -138,12 +479,15 @@ Status Log(MessageType msgType, const char *msgFormat, ...) {
     Status    status = STATUS_OK;
     va_list   vl;
     time_t    now;
-    struct tm timeStruct;
-    char      type[100];
+    int       type;
 
     // Main do-loop to fall through in case of an error
     do {
 
+      // Fall through in a detached child process
+      if (g_log_detach)
+        continue;
+
       // If no log file has been opened then open one now
       if (gLogFilePtr == NULL) {
         status = LogInit(DEFAULT_LOG_FILENAME, DEFAULT_TASK_NAME, status);
@@ -152,95 +496,53 @@ Status Log(MessageType msgType, const char *msgFormat, ...) {
       }
 
       // Set message type
-      switch (msgType) {
-      case Error_0:
-        sprintf(type, "Error_0");
-        break;
-      case Error_1:
-        sprintf(type, "Error_1");
-        break;
-      case Error_2:
-        sprintf(type, "Error_2");
-        break;
-      case Error_3:
-        sprintf(type, "Error_3");
-        break;
-      case Warning_0:
-        sprintf(type, "Warn_0 ");
-        break;
-      case Warning_1:
-        sprintf(type, "Warn_1 ");
-        break;
-      case Warning_2:
-        sprintf(type, "Warn_2 ");
-        break;
-      case Warning_3:
-        sprintf(type, "Warn_3 ");
-        break;
-      case Alert_0:
-        sprintf(type, "Alert_0");
-        break;
-      case Alert_1:
-        sprintf(type, "Alert_1");
-        break;
-      case Alert_2:
-        sprintf(type, "Alert_2");
-        break;
-      case Alert_3:
-        sprintf(type, "Alert_3");
-        break;
-      case Log_0:
-        sprintf(type, "Log_0  ");
-        break;
-      case Log_1:
-        sprintf(type, "Log_1  ");
-        break;
-      case Log_2:
-        sprintf(type, "Log_2  ");
-        break;
-      case Log_3:
-        sprintf(type, "Log_3  ");
-        break;
-      default:
-        sprintf(type, "Unknown");
-        break;
-      }
+      type = (msgType >= Error_0 && msgType <= Log_3) ? (int)msgType : 0;
 
-      // Get time
-      now = time(NULL);
-      #ifdef HAVE_GMTIME_R
-      gmtime_r(&now, &timeStruct);
-      #else
-      memcpy(&timeStruct, gmtime(&now), sizeof(struct tm));
+      // Lock log buffer
+      #if LOG_ASYNC_WRITER
+      pthread_mutex_lock(&g_log_mutex);
       #endif
 
-      // Write message type, time and task name to log file
-      if (fprintf(gLogFilePtr, "%s %04d-%02d-%02dT%02d:%02d:%02d %s: ",
-                  type,
-                  timeStruct.tm_year + 1900,
-                  timeStruct.tm_mon + 1,
-                  timeStruct.tm_mday,
-                  timeStruct.tm_hour,
-                  timeStruct.tm_min,
-                  timeStruct.tm_sec,
-                  gLogTaskName) < 0) {
-        status = STATUS_LOG_WRITE_FAILED;
-        continue;
-      }
-
-      // Write message to log file
+      // Update time stamp if time has changed
+      now = time(NULL);
+      if (now != g_log_time)
+        log_stamp(now);
+
+      // Make sure that buffer can hold one more line
+      if (g_log_buf[g_log_active].fill + LOG_LINE_SIZE > LOG_BUFFER_SIZE)
+        log_swap();
+      LogBuffer *buf = &g_log_buf[g_log_active];
+
+      // Write message type and time stamp
+      memcpy(buf->text + buf->fill, c_log_type[type], 7);
+      buf->fill += 7;
+      memcpy(buf->text + buf->fill, g_log_stamp, g_log_stamp_len);
+      buf->fill += g_log_stamp_len;
+
+      // Write message (truncate if too long)
+      size_t space = LOG_LINE_SIZE - 7 - g_log_stamp_len - 1;
       va_start(vl, msgFormat);
-      if (vfprintf(gLogFilePtr, msgFormat, vl) < 0) {
-        status = STATUS_LOG_WRITE_FAILED;
-        continue;
-      }
+      int len = vsnprintf(buf->text + buf->fill, space, msgFormat, vl);
       va_end(vl);
-
-      // Write <CR> to log file
-      if (fprintf(gLogFilePtr, "\n") != 1) {
+      if (len < 0) {
         status = STATUS_LOG_WRITE_FAILED;
-        continue;
+        len    = 0;
       }
+      else if ((size_t)len >= space)
+        len = space - 1;
+      buf->fill += len;
+
+      // Write <CR>
+      buf->text[buf->fill++] = '\n';
+
+      // Errors are written immediately
+      if (type >= Error_0 && type <= Error_3)
+        log_flush();
+
+      // Unlock log buffer
+      #if LOG_ASYNC_WRITER
+      pthread_mutex_unlock(&g_log_mutex);
+      #endif
 
     } while (0); // End of main do-loop
 
@@ -37,6 +37,30 @@ namespace sourceIdentify {
 /* Defintions _______________________________________________________________ */
 #define DEFAULT_LOG_FILENAME  TOOL_LOGFILE
 #define DEFAULT_TASK_NAME     TOOL_NAME
+#define LOG_BUFFER_SIZE       1048576       // Size of log buffer (bytes)
+#define LOG_LINE_SIZE         16384         // Maximum length of one log line
+#define LOG_MAX_CHATTER       4             // Highest chatter level compiled in
+#define LOG_WITH_DEBUG        1             // Compile in debugging messages
+#ifndef WIN32
+#define LOG_ASYNC_WRITER      1             // Background writer thread support
+#else
+#define LOG_ASYNC_WRITER      0
+#endif
+
+/* Level gating macros ______________________________________________________ */
+// The arguments of the log message are only evaluated if the chatter level
+// of the task parameters is sufficiently high. Levels above LOG_MAX_CHATTER
+// are removed at compile time.
+#define LOG_TERSE(par, ...)                                                    \
+  do { if (LOG_MAX_CHATTER > 0 && (par)->logTerse()) Log(__VA_ARGS__); } while (0)
+#define LOG_NORMAL(par, ...)                                                   \
+  do { if (LOG_MAX_CHATTER > 1 && (par)->logNormal()) Log(__VA_ARGS__); } while (0)
+#define LOG_EXPLICIT(par, ...)                                                 \
+  do { if (LOG_MAX_CHATTER > 2 && (par)->logExplicit()) Log(__VA_ARGS__); } while (0)
+#define LOG_VERBOSE(par, ...)                                                  \
+  do { if (LOG_MAX_CHATTER > 3 && (par)->logVerbose()) Log(__VA_ARGS__); } while (0)
+#define LOG_DEBUG(par, ...)                                                    \
+  do { if (LOG_WITH_DEBUG && (par)->logDebug()) Log(__VA_ARGS__); } while (0)
 
 
 /* Type defintions __________________________________________________________ */
@@ -66,6 +90,9 @@ typedef enum {
 /* Prototypes _______________________________________________________________ */
 Status LogInit(const char *logName, const char *taskName, Status status);
 Status LogClose(Status status);
+Status LogFlush(Status status);
+Status LogAsync(int enable, Status status);
+void   LogDetach(void);
 Status Log(MessageType msgType, const char *msgFormat, ...);
 
 
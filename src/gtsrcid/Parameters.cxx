@@ -62,6 +62,8 @@ Replace header information with CVS typeset information.
 
 /* Includes _________________________________________________________________ */
 #include <stdio.h>                       // for "sprintf" function
+#include <stdlib.h>                      // for "strtod" function
+#include <ctype.h>                       // for "isalnum" function
 #include "sourceIdentify.h"
 #include "Parameters.h"
 #include "Log.h"                         // for parameter dumping/errors
@@ -80,6 +82,7 @@ int g_u9_verbosity;
 
 /* Prototypes _______________________________________________________________ */
 std::string trim(std::string str);
+int         formula_uses(std::string formula, std::string name);
 
 
 /*============================================================================*/
@@ -113,6 +116,44 @@ std::string trim(std::string str) {
 }
 
 
+/**************************************************************************//**
+ * @brief Check if formula references a column name
+ *
+ * @param[in] formula Formula.
+ * @param[in] name Column name.
+ *
+ * Returns 1 if the name appears in the formula as a complete identifier
+ * (case insensitive), 0 otherwise.
+ ******************************************************************************/
+int formula_uses(std::string formula, std::string name) {
+
+    // Declare variables
+    int                    found = 0;
+    std::string::size_type pos   = 0;
+
+    // Convert formula and name to upper case
+    formula = upper(formula);
+    name    = upper(name);
+
+    // Search name
+    while (!found && name.length() > 0 &&
+           (pos = formula.find(name, pos)) != std::string::npos) {
+      std::string::size_type end = pos + name.length();
+      int before = (pos > 0 && (isalnum(formula[pos-1]) ||
+                                formula[pos-1] == '_'));
+      int after  = (end < formula.length() && (isalnum(formula[end]) ||
+                                               formula[end] == '_'));
+      if (!before && !after)
+        found = 1;
+      pos++;
+    }
+
+    // Return result
+    return found;
+
+}
+
+
 /*============================================================================*/
 /*                          Low-level parameter methods                       */
 /*============================================================================*/
@@ -149,7 +190,37 @@ void Parameters::init_memory(void) {
       m_chatter     = 0;
       m_clobber     = 0;
       m_debug       = 0;
+      m_logAsync    = 0;
+      m_profile     = 0;
+      m_profileFile.clear();
+      m_traceFile.clear();
+      m_chkFile.clear();
+      m_chkInterval = 0;
+      m_resume      = 0;
+      m_numShards   = 1;
+      m_shard       = -1;
+      m_prevCatName.clear();
+      m_prevChkFile.clear();
+      m_prevTol     = 0.0;
+      m_sweepPrior.clear();
+      m_sweepThres.clear();
+      m_probCurves  = 0;
+      m_mcNum       = 0;
+      m_mcShift     = 0.0;
+      m_mcSeed      = 0;
+      m_mcJobs      = 0;
+      m_cacheDir.clear();
+      m_srcOrder    = "CATALOGUE";
       m_mode.clear();
+      m_plan.clear();
+      m_outCatQtyId.clear();
+      m_outCatQtyUsed.clear();
+      m_selectPost.clear();
+      m_numSelectPost = 0;
+      m_srcQtyUsed    = 0;
+      m_probMethodId = -1;
+      m_probPriorId  = -1;
+      m_FoMId        = -1;
 
     } while (0); // End of main do-loop
 
@@ -199,10 +270,6 @@ Status Parameters::load(st_app::AppParGroup &pars, Status status) {
     // Declare local variables
     char                   parname[MAX_CHAR];
     std::string::size_type len;
-    std::string::size_type pos;
-    std::string::size_type len_name;
-    std::string::size_type start_formula;
-    std::string::size_type len_formula;
 
     // Single loop for common exit point
     do {
@@ -230,6 +297,15 @@ Status Parameters::load(st_app::AppParGroup &pars, Status status) {
       std::string s_probPrior    = pars["probPrior"];
       std::string s_FoM          = pars["fom"];
       std::string s_mode         = pars["mode"];
+      std::string s_profileFile  = pars["profileFile"];
+      std::string s_traceFile    = pars["traceFile"];
+      std::string s_chkFile      = pars["chkFile"];
+      std::string s_cacheDir     = pars["cacheDir"];
+      std::string s_srcOrder     = pars["srcOrder"];
+      std::string s_prevCatName  = pars["prevCatName"];
+      std::string s_prevChkFile  = pars["prevChkFile"];
+      std::string s_sweepPrior   = pars["sweepPrior"];
+      std::string s_sweepThres   = pars["sweepThres"];
       m_srcCatName               = trim(s_srcCatName);
       m_srcCatPrefix             = OUTCAT_PRE_STRING + s_srcCatPrefix + "_";
       m_srcCatQty                = s_srcCatQty;
@@ -248,6 +324,25 @@ Status Parameters::load(st_app::AppParGroup &pars, Status status) {
       m_chatter                  = pars["chatter"];
       m_clobber                  = pars["clobber"];
       m_debug                    = pars["debug"];
+      m_logAsync                 = pars["logAsync"];
+      m_profile                  = pars["profile"];
+      m_profileFile              = trim(s_profileFile);
+      m_traceFile                = trim(s_traceFile);
+      m_chkFile                  = trim(s_chkFile);
+      m_chkInterval              = pars["chkInterval"];
+      m_resume                   = pars["resume"];
+      m_probCurves               = pars["probCurves"];
+      m_mcNum                    = pars["mcNum"];
+      m_mcShift                  = pars["mcShift"];
+      m_mcSeed                   = pars["mcSeed"];
+      m_mcJobs                   = pars["mcJobs"];
+      m_cacheDir                 = trim(s_cacheDir);
+      m_srcOrder                 = upper(trim(s_srcOrder));
+      m_numShards                = pars["numShards"];
+      m_shard                    = pars["shard"];
+      m_prevCatName              = trim(s_prevCatName);
+      m_prevChkFile              = trim(s_prevChkFile);
+      m_prevTol                  = pars["prevTol"];
       m_mode                     = s_mode;
 
       // Set U9 verbosity
@@ -256,6 +351,16 @@ Status Parameters::load(st_app::AppParGroup &pars, Status status) {
       else
         g_u9_verbosity = 0;
 
+      // Check source processing order
+      if (m_srcOrder != "CATALOGUE" && m_srcOrder != "HEALPIX" &&
+          m_srcOrder != "HILBERT") {
+        status = STATUS_PAR_BAD_PARAMETER;
+        Log(Error_2, "%d : Invalid source processing order <srcOrder='%s'>"
+            " (expect CATALOGUE, HEALPIX or HILBERT).",
+            (Status)status, m_srcOrder.c_str());
+        continue;
+      }
+
       // Retrieve new output quantities and decompose them into quantity name
       // and evaluation string
       for (int i = MIN_OUTCAT_QTY; i <= MAX_OUTCAT_QTY; ++i) {
@@ -264,45 +369,10 @@ Status Parameters::load(st_app::AppParGroup &pars, Status status) {
         sprintf(parname, "outCatQty%2.2d", i);
         std::string outCatQty = pars[parname];
 
-        // Fall through if parameter is empty
-        outCatQty = trim(outCatQty);
-        len       = outCatQty.length();
-        if (len < 1)
-          continue;
-
-        // Decompose string in part before and after "=" symbol
-        pos           = outCatQty.find("=",0);
-        len_name      = pos;
-        start_formula = pos + 1;
-        len_formula   = len - start_formula;
-
-        // Catch invalid parameters
-        if (pos == std::string::npos) {
-          status = STATUS_PAR_BAD_PARAMETER;
-          Log(Error_2, "%d : No equality symbol found in new output catalogue"
-              " quantity string <%s='%s'>.", 
-              (Status)status, parname, outCatQty.c_str());
-          break;
-        }
-        if (len_name < 1) {
-          status = STATUS_PAR_BAD_PARAMETER;
-          Log(Error_2, "%d : No quantity name found for new output catalogue"
-              " quantity <%s='%s'>.", 
-              (Status)status, parname, outCatQty.c_str());
-          break;
-        }
-        if (len_formula < 1) {
-          status = STATUS_PAR_BAD_PARAMETER;
-          Log(Error_2, "%d : No quantity evaluation string found for new"
-              " output catalogue quantity <%s='%s'>.", 
-              (Status)status, parname, outCatQty.c_str());
+        // Add quantity
+        status = add_outcat_qty(parname, outCatQty, status);
+        if (status != STATUS_OK)
           break;
-        }
-
-        // Set name and formula (remove whitespace)
-        m_outCatQtyName.push_back(trim(outCatQty.substr(0, len_name)));
-        m_outCatQtyFormula.push_back(trim((outCatQty.substr(start_formula,
-                                                            len_formula))));
 
       } // endfor: looped over quantities
       if (status != STATUS_OK)
@@ -321,12 +391,235 @@ Status Parameters::load(st_app::AppParGroup &pars, Status status) {
       if (status != STATUS_OK)
         continue;
 
+      // Retrieve sweep values
+      status = add_sweep_values("sweepPrior", s_sweepPrior, m_sweepPrior,
+                                status);
+      status = add_sweep_values("sweepThres", s_sweepThres, m_sweepThres,
+                                status);
+      if (status != STATUS_OK)
+        continue;
+
       // Check for catch-22
       std::string u_probPrior = upper(s_probPrior);
       if ((u_probPrior.find("CATCH-22",0) != std::string::npos) ||
           (u_probPrior.find("CATCH22",0)  != std::string::npos))
         m_catch22 = 1;
 
+      // Compile formulas
+      compile_formulas();
+
+    } while (0); // End of main do-loop
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Set parameters from association options
+ *
+ * @param[in] opt Association options.
+ * @param[in] status Error status.
+ *
+ * Sets the task parameters for an in-memory association (see associate()).
+ * No catalogue or output file names are set, all catalogue quantities are
+ * included in the in-memory catalogue, and profiling, tracing and debugging
+ * are disabled.
+ ******************************************************************************/
+Status Parameters::set(const AssocOptions &opt, Status status) {
+
+    // Declare local variables
+    char parname[MAX_CHAR];
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Reset parameters
+      init_memory();
+
+      // Set task parameters
+      m_srcCatPrefix = OUTCAT_PRE_STRING + opt.srcPrefix + "_";
+      m_srcCatQty    = "*";
+      m_srcPosError  = opt.srcPosError;
+      m_cptCatPrefix = OUTCAT_PRE_STRING + opt.cptPrefix + "_";
+      m_cptCatQty    = "*";
+      m_cptPosError  = opt.cptPosError;
+      m_cptCatName   = opt.cptCatName;
+      m_cptDensFile  = opt.cptDensFile;
+      m_probMethod   = trim(opt.probMethod);
+      m_probPrior    = trim(opt.probPrior);
+      m_FoM          = trim(opt.fom);
+      m_probThres    = opt.probThres;
+      m_maxNumCpt    = opt.maxNumCpt;
+      m_chatter      = opt.chatter;
+      m_clobber      = 0;
+      m_debug        = 0;
+
+      // Set new output quantities
+      for (int i = 0; i < (int)opt.outCatQty.size(); ++i) {
+        sprintf(parname, "outCatQty[%d]", i);
+        status = add_outcat_qty(parname, opt.outCatQty[i], status);
+        if (status != STATUS_OK)
+          break;
+      }
+      if (status != STATUS_OK)
+        continue;
+
+      // Set selection strings
+      for (int i = 0; i < (int)opt.select.size(); ++i) {
+        std::string select = trim(opt.select[i]);
+        if (select.length() > 0)
+          m_select.push_back(select);
+      }
+
+      // Check for catch-22
+      std::string u_probPrior = upper(m_probPrior);
+      if ((u_probPrior.find("CATCH-22",0) != std::string::npos) ||
+          (u_probPrior.find("CATCH22",0)  != std::string::npos))
+        m_catch22 = 1;
+
+      // Compile formulas
+      compile_formulas();
+
+    } while (0); // End of main do-loop
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Add new output catalogue quantity
+ *
+ * @param[in] parname Parameter name (for error messages).
+ * @param[in] outCatQty Quantity definition string ("NAME=formula").
+ * @param[in] status Error status.
+ *
+ * Empty definition strings are ignored.
+ ******************************************************************************/
+Status Parameters::add_outcat_qty(const char *parname, std::string outCatQty,
+                                  Status status) {
+
+    // Declare local variables
+    std::string::size_type len;
+    std::string::size_type pos;
+    std::string::size_type len_name;
+    std::string::size_type start_formula;
+    std::string::size_type len_formula;
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Fall through if parameter is empty
+      outCatQty = trim(outCatQty);
+      len       = outCatQty.length();
+      if (len < 1)
+        continue;
+
+      // Decompose string in part before and after "=" symbol
+      pos           = outCatQty.find("=",0);
+      len_name      = pos;
+      start_formula = pos + 1;
+      len_formula   = len - start_formula;
+
+      // Catch invalid parameters
+      if (pos == std::string::npos) {
+        status = STATUS_PAR_BAD_PARAMETER;
+        Log(Error_2, "%d : No equality symbol found in new output catalogue"
+            " quantity string <%s='%s'>.", 
+            (Status)status, parname, outCatQty.c_str());
+        continue;
+      }
+      if (len_name < 1) {
+        status = STATUS_PAR_BAD_PARAMETER;
+        Log(Error_2, "%d : No quantity name found for new output catalogue"
+            " quantity <%s='%s'>.", 
+            (Status)status, parname, outCatQty.c_str());
+        continue;
+      }
+      if (len_formula < 1) {
+        status = STATUS_PAR_BAD_PARAMETER;
+        Log(Error_2, "%d : No quantity evaluation string found for new"
+            " output catalogue quantity <%s='%s'>.", 
+            (Status)status, parname, outCatQty.c_str());
+        continue;
+      }
+
+      // Set name and formula (remove whitespace)
+      m_outCatQtyName.push_back(trim(outCatQty.substr(0, len_name)));
+      m_outCatQtyFormula.push_back(trim((outCatQty.substr(start_formula,
+                                                          len_formula))));
+
+    } while (0); // End of main do-loop
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Add sweep values
+ *
+ * @param[in] parname Parameter name (for error messages).
+ * @param[in] list Comma or whitespace separated list of values.
+ * @param[out] values Values.
+ * @param[in] status Error status.
+ *
+ * All values have to be probabilities in the range [0,1]. An empty list
+ * leaves the values empty.
+ ******************************************************************************/
+Status Parameters::add_sweep_values(const char *parname, std::string list,
+                                    std::vector<double> &values,
+                                    Status status) {
+
+    // Declare local variables
+    std::string::size_type start;
+    std::string::size_type stop;
+
+    // Single loop for common exit point
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Extract values
+      values.clear();
+      start = list.find_first_not_of(" \t,");
+      while (start != std::string::npos) {
+
+        // Get value string
+        stop              = list.find_first_of(" \t,", start);
+        std::string value = list.substr(start, (stop == std::string::npos) ?
+                                               std::string::npos : stop-start);
+
+        // Convert value
+        char  *end;
+        double v = strtod(value.c_str(), &end);
+        if (*end != '\0' || v < 0.0 || v > 1.0) {
+          status = STATUS_PAR_BAD_PARAMETER;
+          Log(Error_2, "%d : Invalid probability <%s> in parameter <%s='%s'>.",
+              (Status)status, value.c_str(), parname, list.c_str());
+          break;
+        }
+        values.push_back(v);
+
+        // Go to next value
+        start = list.find_first_not_of(" \t,", stop);
+
+      } // endwhile: looped over values
+
     } while (0); // End of main do-loop
 
     // Return status
@@ -335,6 +628,172 @@ Status Parameters::load(st_app::AppParGroup &pars, Status status) {
 }
 
 
+/**************************************************************************//**
+ * @brief Compile formulas into evaluation plan
+ *
+ * Compiles the new output catalogue quantities and the probMethod, probPrior
+ * and fom formulas into a single evaluation plan, so that formulas are only
+ * parsed once and common subexpressions are evaluated only once. Formulas
+ * that can not be compiled get an index of -1 and are evaluated by the
+ * CFITSIO calculator. As the quantities are evaluated in sequence, all
+ * quantities following a quantity that could not be compiled are also
+ * evaluated by the CFITSIO calculator.
+ *
+ * Also determines which quantities are used during the association, i.e.
+ * which are referenced by a selection, the prior, the FoM or the
+ * probability formula, either directly or through other quantities. Only
+ * these quantities are evaluated in the in-memory catalogue, all others are
+ * only evaluated for the rows written into the output catalogue. Finally
+ * flags whether any of these formulas references a source catalogue
+ * quantity (see Catalogue::chk_prev).
+ ******************************************************************************/
+void Parameters::compile_formulas(void) {
+
+    // Reset plan
+    m_plan.clear();
+    m_outCatQtyId.clear();
+
+    // Compile new output catalogue quantities
+    int compiled = 1;
+    for (int i = 0; i < (int)m_outCatQtyFormula.size(); ++i) {
+      int id = -1;
+      if (compiled)
+        id = m_plan.compile(m_outCatQtyFormula[i], m_outCatQtyName[i]);
+      if (id < 0)
+        compiled = 0;
+      m_outCatQtyId.push_back(id);
+    }
+
+    // Compile probability formulas (the prior is not evaluated for catch-22)
+    m_probMethodId = m_plan.compile(m_probMethod);
+    m_probPriorId  = (m_catch22) ? -1 : m_plan.compile(m_probPrior);
+    m_FoMId        = (m_FoM.length() > 0) ? m_plan.compile(m_FoM) : -1;
+
+    // Gather formulas that are evaluated during the association
+    std::vector<std::string> formulas = m_select;
+    formulas.push_back(m_probMethod);
+    if (!m_catch22)
+      formulas.push_back(m_probPrior);
+    if (m_FoM.length() > 0)
+      formulas.push_back(m_FoM);
+
+    // Flag quantities that are referenced by these formulas or by flagged
+    // quantities (iterate until no more quantities are added)
+    int numQty = (int)m_outCatQtyName.size();
+    m_outCatQtyUsed = std::vector<int>(numQty, 0);
+    int added;
+    do {
+      added = 0;
+      for (int i = 0; i < numQty; ++i) {
+        if (m_outCatQtyUsed[i])
+          continue;
+        for (int k = 0; k < (int)formulas.size(); ++k) {
+          if (formula_uses(formulas[k], m_outCatQtyName[i])) {
+            m_outCatQtyUsed[i] = 1;
+            formulas.push_back(m_outCatQtyFormula[i]);
+            added = 1;
+            break;
+          }
+        }
+      }
+    } while (added);
+
+    // Flag formulas that reference source catalogue quantities
+    m_srcQtyUsed = 0;
+    if (m_srcCatPrefix.length() > 0) {
+      std::string prefix = upper(m_srcCatPrefix);
+      for (int k = 0; k < (int)formulas.size(); ++k) {
+        if (upper(formulas[k]).find(prefix) != std::string::npos) {
+          m_srcQtyUsed = 1;
+          break;
+        }
+      }
+    }
+
+    // Plan selections
+    plan_select();
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Split selection criteria between selection and reselection step
+ *
+ * A selection criterion that references a quantity that is only computed in
+ * the refine step (ANGSEP, the probabilities, FOM, ...), either directly
+ * or through a new output catalogue quantity, is applied in the reselection
+ * step (see Catalogue::cid_reselect). All other criteria only reference
+ * catalogue quantities; they are applied once in the selection step (see
+ * Catalogue::cid_select), before the probabilities are computed.
+ ******************************************************************************/
+void Parameters::plan_select(void) {
+
+    // Set quantities that are computed in the refine step
+    static const char *refine[] = {OUTCAT_COL_PROB_NAME,
+                                   OUTCAT_COL_PROB_POS_NAME,
+                                   OUTCAT_COL_PDF_POS_NAME,
+                                   OUTCAT_COL_PROB_CHANCE_NAME,
+                                   OUTCAT_COL_PDF_CHANCE_NAME,
+                                   OUTCAT_COL_PROB_PRIOR_NAME,
+                                   OUTCAT_COL_PROB_POST_NAME,
+                                   OUTCAT_COL_PROB_POST_S_NAME,
+                                   OUTCAT_COL_PROB_POST_C_NAME,
+                                   OUTCAT_COL_LR_NAME,
+                                   OUTCAT_COL_ANGSEP_NAME,
+                                   OUTCAT_COL_PSI_NAME,
+                                   OUTCAT_COL_POSANG_NAME,
+                                   OUTCAT_COL_RHO_NAME,
+                                   OUTCAT_COL_MU_NAME,
+                                   OUTCAT_COL_FOM_NAME,
+                                   NULL};
+    std::vector<std::string> names;
+    for (int i = 0; refine[i] != NULL; ++i)
+      names.push_back(refine[i]);
+
+    // Add new output catalogue quantities that depend on these quantities
+    // (iterate until no more quantities are added)
+    int numQty = (int)m_outCatQtyName.size();
+    std::vector<int> depends(numQty, 0);
+    int added;
+    do {
+      added = 0;
+      for (int i = 0; i < numQty; ++i) {
+        if (depends[i])
+          continue;
+        for (int k = 0; k < (int)names.size(); ++k) {
+          if (formula_uses(m_outCatQtyFormula[i], names[k])) {
+            depends[i] = 1;
+            names.push_back(m_outCatQtyName[i]);
+            added = 1;
+            break;
+          }
+        }
+      }
+    } while (added);
+
+    // Assign selection criteria to steps
+    int numSel = (int)m_select.size();
+    m_selectPost    = std::vector<int>(numSel, 0);
+    m_numSelectPost = 0;
+    for (int iSel = 0; iSel < numSel; ++iSel) {
+      for (int k = 0; k < (int)names.size(); ++k) {
+        if (formula_uses(m_select[iSel], names[k])) {
+          m_selectPost[iSel] = 1;
+          m_numSelectPost++;
+          break;
+        }
+      }
+    }
+
+    // Return
+    return;
+
+}
+
+
 /**************************************************************************//**
  * @brief Dump task parameters into log file
  *
@@ -388,14 +847,86 @@ Status Parameters::dump(Status status) {
       }
       if ((n = m_select.size()) > 0) {
         for (i = 0; i < n; i++) {
-          Log(Log_1, " Output catalogue selection %2d ....: %s",
-              i+1, m_select[i].c_str());
+          Log(Log_1, " Output catalogue selection %2d ....: %s (%s)",
+              i+1, m_select[i].c_str(),
+              (i < m_selectPost.size() && m_selectPost[i]) ? "reselect"
+                                                            : "select");
         }
       }
+      int numCalc = 0;
+      for (i = 0; i < m_outCatQtyId.size(); ++i) {
+        if (m_outCatQtyId[i] < 0)
+          numCalc++;
+      }
+      if (m_probMethodId < 0) numCalc++;
+      if (m_probPriorId < 0 && !m_catch22) numCalc++;
+      if (m_FoMId < 0 && m_FoM.length() > 0) numCalc++;
+      Log(Log_1, " Compiled formula plan ............: %d formulas, %d nodes",
+          m_plan.numFormulas(), m_plan.numNodes());
+      int numUsed = 0;
+      for (i = 0; i < m_outCatQtyUsed.size(); ++i) {
+        if (m_outCatQtyUsed[i])
+          numUsed++;
+      }
+      if (m_outCatQtyUsed.size() > 0)
+        Log(Log_1, " Quantities used in association ...: %d of %d", numUsed,
+            (int)m_outCatQtyUsed.size());
+      if (numCalc > 0)
+        Log(Warning_1, " Formulas using CFITSIO calculator : %d", numCalc);
       Log(Log_1, " Chatter level of output ..........: %d", m_chatter);
       Log(Log_1, " U9 verbosity .....................: %d", g_u9_verbosity);
       Log(Log_1, " Clobber ..........................: %d", m_clobber);
       Log(Log_1, " Debugging mode activated .........: %d", m_debug);
+      Log(Log_1, " Background log writer ............: %d", m_logAsync);
+      Log(Log_1, " Pipeline profiling ...............: %d", m_profile);
+      if (m_profile && m_profileFile.length() > 0)
+        Log(Log_1, " Profile JSON file ................: %s",
+            m_profileFile.c_str());
+      if (m_traceFile.length() > 0)
+        Log(Log_1, " Trace event file .................: %s",
+            m_traceFile.c_str());
+      if (m_chkFile.length() > 0) {
+        Log(Log_1, " Checkpoint file ..................: %s",
+            m_chkFile.c_str());
+        Log(Log_1, " Sources between checkpoints ......: %ld", m_chkInterval);
+        Log(Log_1, " Resume from checkpoint ...........: %d", m_resume);
+      }
+      if (m_numShards > 1) {
+        Log(Log_1, " Number of sky shards .............: %d", m_numShards);
+        if (m_shard >= 0)
+          Log(Log_1, " Shard ............................: %d", m_shard);
+        else
+          Log(Log_1, " Shard ............................: merge");
+      }
+      if (m_prevCatName.length() > 0) {
+        Log(Log_1, " Previous source catalogue ........: %s",
+            m_prevCatName.c_str());
+        Log(Log_1, " Previous checkpoint file .........: %s",
+            m_prevChkFile.c_str());
+        Log(Log_1, " Unchanged position tolerance .....: %.4f deg",
+            m_prevTol);
+      }
+      if (m_sweepPrior.size() > 0 || m_sweepThres.size() > 0) {
+        Log(Log_1, " Sweep prior probabilities ........: %d values",
+            (int)m_sweepPrior.size());
+        Log(Log_1, " Sweep probability thresholds .....: %d values",
+            (int)m_sweepThres.size());
+      }
+      if (m_probCurves)
+        Log(Log_1, " Write threshold curves ...........: %d", m_probCurves);
+      if (m_mcNum > 0) {
+        Log(Log_1, " Shifted source catalogues ........: %d", m_mcNum);
+        Log(Log_1, " Minimum source shift .............: %.4f deg",
+            m_mcShift);
+        Log(Log_1, " Random number seed ...............: %ld", m_mcSeed);
+        Log(Log_1, " Worker processes .................: %d", m_mcJobs);
+      }
+      if (m_cacheDir.length() > 0)
+        Log(Log_1, " Result cache directory ...........: %s",
+            m_cacheDir.c_str());
+      if (m_srcOrder != "CATALOGUE")
+        Log(Log_1, " Source processing order ..........: %s",
+            m_srcOrder.c_str());
       Log(Log_1, " Mode of automatic parameters .....: %s", m_mode.c_str());
 
     } while (0); // End of main do-loop
@@ -53,6 +53,8 @@ Replace header information with CVS typeset information.
 
 /* Includes _________________________________________________________________ */
 #include "sourceIdentify.h"
+#include "Associate.h"
+#include "Formula.h"
 
 
 /* Namespace definition _____________________________________________________ */
@@ -83,17 +85,29 @@ public:
 
   // Public methods
   Status load(st_app::AppParGroup &pars, Status status);
+  Status set(const AssocOptions &opt, Status status);
   Status dump(Status status);
   int    logTerse(void);                       // Inline
   int    logNormal(void);                      // Inline
   int    logExplicit(void);                    // Inline
   int    logVerbose(void);                     // Inline
   int    logDebug(void);                       // Inline
+  int    logAsync(void);                       // Inline
+  int    profile(void);                        // Inline
+  std::string profileFile(void);               // Inline
+  std::string traceFile(void);                 // Inline
+  int    shardWorker(void);                    // Inline
 
   // Private methods
 private:
   void   init_memory(void);
   void   free_memory(void);
+  Status add_outcat_qty(const char *parname, std::string outCatQty,
+                        Status status);
+  Status add_sweep_values(const char *parname, std::string list,
+                          std::vector<double> &values, Status status);
+  void   compile_formulas(void);
+  void   plan_select(void);
 
 private:
   std::string              m_srcCatName;       //!< Source catalogue name
@@ -115,10 +129,40 @@ private:
   std::vector<std::string> m_outCatQtyName;    //!< New output catalogue quantities
   std::vector<std::string> m_outCatQtyFormula; //!< New output catalogue formulae
   std::vector<std::string> m_select;           //!< Selections
+  std::vector<int>         m_selectPost;       //!< Selection after refine step
+  int                      m_numSelectPost;    //!< # of selections after refine
+  int                      m_srcQtyUsed;       //!< Association uses source qty.
   int                      m_chatter;          //!< Chatter level
   int                      m_clobber;          //!< Clobber flag
   int                      m_debug;            //!< Debugging mode activated
+  int                      m_logAsync;         //!< Background log writer
+  int                      m_profile;          //!< Pipeline profiling
+  std::string              m_profileFile;      //!< Profile JSON file
+  std::string              m_traceFile;        //!< Trace event JSON file
+  std::string              m_chkFile;          //!< Checkpoint file
+  long                     m_chkInterval;      //!< Sources between checkpoints
+  int                      m_resume;           //!< Resume from checkpoint
+  int                      m_numShards;        //!< Number of sky shards
+  int                      m_shard;            //!< Shard (-1: merge)
+  std::string              m_prevCatName;      //!< Previous source catalogue
+  std::string              m_prevChkFile;      //!< Previous checkpoint file
+  double                   m_prevTol;          //!< Unchanged position tolerance
+  std::vector<double>      m_sweepPrior;       //!< Sweep prior probabilities
+  std::vector<double>      m_sweepThres;       //!< Sweep probability thresholds
+  int                      m_probCurves;       //!< Write threshold curves
+  int                      m_mcNum;            //!< Number of MC realisations
+  double                   m_mcShift;          //!< Minimum MC source shift (deg)
+  long                     m_mcSeed;           //!< MC random number seed
+  int                      m_mcJobs;           //!< MC worker processes
+  std::string              m_cacheDir;         //!< Result cache directory
+  std::string              m_srcOrder;         //!< Source processing order
   std::string              m_mode;             //!< Automatic parameter mode
+  FormulaPlan              m_plan;             //!< Compiled formula plan
+  std::vector<int>         m_outCatQtyId;      //!< Plan index of quantities
+  std::vector<int>         m_outCatQtyUsed;    //!< Quantities used in association
+  int                      m_probMethodId;     //!< Plan index of probMethod
+  int                      m_probPriorId;      //!< Plan index of probPrior
+  int                      m_FoMId;            //!< Plan index of FoM
 };
 inline Parameters::Parameters(void) { init_memory(); }
 inline Parameters::~Parameters(void) { free_memory(); }
@@ -127,6 +171,11 @@ inline int Parameters::logNormal(void) { return (m_chatter > 1); }
 inline int Parameters::logExplicit(void) { return (m_chatter > 2); }
 inline int Parameters::logVerbose(void) { return (m_chatter > 3); }
 inline int Parameters::logDebug(void) { return (m_debug); }
+inline int Parameters::logAsync(void) { return (m_logAsync); }
+inline int Parameters::profile(void) { return (m_profile); }
+inline std::string Parameters::profileFile(void) { return (m_profileFile); }
+inline std::string Parameters::traceFile(void) { return (m_traceFile); }
+inline int Parameters::shardWorker(void) { return (m_numShards > 1 && m_shard >= 0); }
 
 /* Prototypes _______________________________________________________________ */
 
@@ -0,0 +1,290 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file Profile.cxx
+ * @brief Pipeline profiling interface implementation.
+ * @author J. Knodlseder
+ */
+
+/* Includes _________________________________________________________________ */
+#include <stdio.h>      // for "FILE" type
+#include <time.h>       // for "clock" function
+#ifndef WIN32
+#include <sys/time.h>   // for "gettimeofday" function
+#endif
+#include "sourceIdentify.h"
+#include "Profile.h"
+#include "Log.h"
+
+
+/* Namespace definition _____________________________________________________ */
+namespace sourceIdentify {
+
+
+/* Constants ________________________________________________________________ */
+const char *c_prof_name[] = {"descriptor load", "catalogue load", "filter",
+                             "prune", "select", "refine", "reselect", "post_cat",
+                             "post", "catch22 iteration", "compute_prob",
+                             "output write", "cfits_eval"};
+const char *c_prof_key[]  = {"descriptor", "load", "filter",
+                             "prune", "select", "refine", "reselect", "post_cat",
+                             "post", "catch22", "compute_prob",
+                             "output", "cfits_eval"};
+
+
+/* Type defintions __________________________________________________________ */
+typedef struct {                // Stage profile
+  long    calls;                //!< Number of calls
+  long    count;                //!< Number of candidates processed
+  double  wall;                 //!< Wall clock time (sec)
+  double  cpu;                  //!< CPU time (sec)
+  double  wall_start;           //!< Wall clock time at start
+  clock_t cpu_start;            //!< CPU clock at start
+  int     running;              //!< Stage is running
+} StageProfile;
+
+
+/* Private globals __________________________________________________________ */
+static int          g_prof_enable = 0;
+static double       g_prof_wall_start = 0.0;
+static clock_t      g_prof_cpu_start  = 0;
+static StageProfile g_prof[Prof_NumStages];
+
+
+/* Prototypes _______________________________________________________________ */
+static double prof_wall(void);
+
+
+/*============================================================================*/
+/*                              Private functions                             */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Return wall clock time in seconds
+ ******************************************************************************/
+static double prof_wall(void) {
+
+    // Get time
+    #ifndef WIN32
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    double wall = double(tv.tv_sec) + 1.0e-6 * double(tv.tv_usec);
+    #else
+    double wall = double(time(NULL));
+    #endif
+
+    // Return wall clock time
+    return wall;
+
+}
+
+
+/*============================================================================*/
+/*                              Public functions                              */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Initialise profiling
+ *
+ * @param[in] enable Enable profiling (1) or not (0).
+ * @param[in] status Error status.
+ ******************************************************************************/
+Status ProfileInit(int enable, Status status) {
+
+    // Main do-loop to fall through in case of an error
+    do {
+
+      // Reset all stages
+      for (int i = 0; i < Prof_NumStages; ++i) {
+        g_prof[i].calls      = 0;
+        g_prof[i].count      = 0;
+        g_prof[i].wall       = 0.0;
+        g_prof[i].cpu        = 0.0;
+        g_prof[i].wall_start = 0.0;
+        g_prof[i].cpu_start  = 0;
+        g_prof[i].running    = 0;
+      }
+
+      // Store enable flag and start times
+      g_prof_enable     = enable;
+      g_prof_wall_start = prof_wall();
+      g_prof_cpu_start  = clock();
+
+    } while (0); // End of main do-loop
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Signals if profiling is enabled
+ ******************************************************************************/
+int ProfileEnabled(void) {
+
+    // Return enable flag
+    return g_prof_enable;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Start timing of a pipeline stage
+ *
+ * @param[in] stage Pipeline stage.
+ ******************************************************************************/
+void ProfileStart(ProfileStage stage) {
+
+    // Start timing
+    if (g_prof_enable && !g_prof[stage].running) {
+      g_prof[stage].running    = 1;
+      g_prof[stage].wall_start = prof_wall();
+      g_prof[stage].cpu_start  = clock();
+    }
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Stop timing of a pipeline stage
+ *
+ * @param[in] stage Pipeline stage.
+ * @param[in] count Number of candidates processed by the stage.
+ *
+ * Stopping a stage that has not been started is ignored.
+ ******************************************************************************/
+void ProfileStop(ProfileStage stage, long count) {
+
+    // Stop timing and accumulate
+    if (g_prof_enable && g_prof[stage].running) {
+      g_prof[stage].wall   += prof_wall() - g_prof[stage].wall_start;
+      g_prof[stage].cpu    += double(clock() - g_prof[stage].cpu_start) /
+                              double(CLOCKS_PER_SEC);
+      g_prof[stage].calls++;
+      g_prof[stage].count  += count;
+      g_prof[stage].running = 0;
+    }
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Dump profiling summary into log file
+ *
+ * @param[in] status Error status.
+ ******************************************************************************/
+Status ProfileDump(Status status) {
+
+    // Main do-loop to fall through in case of an error
+    do {
+
+      // Fall through if profiling is disabled
+      if (!g_prof_enable)
+        continue;
+
+      // Get total times
+      double wall = prof_wall() - g_prof_wall_start;
+      double cpu  = double(clock() - g_prof_cpu_start) / double(CLOCKS_PER_SEC);
+
+      // Dump header
+      Log(Log_1, "");
+      Log(Log_1, "Pipeline profile:");
+      Log(Log_1, "=================");
+      Log(Log_1, " Stage                 Calls   Wall (s)    CPU (s)  Wall%%"
+                 "  Candidates   Cand/s");
+
+      // Dump stages
+      for (int i = 0; i < Prof_NumStages; ++i) {
+        if (g_prof[i].calls < 1)
+          continue;
+        double fraction = (wall > 0.0) ? 100.0 * g_prof[i].wall / wall : 0.0;
+        double rate     = (g_prof[i].wall > 0.0)
+                          ? double(g_prof[i].count) / g_prof[i].wall : 0.0;
+        Log(Log_1, " %-18s %8ld %10.3f %10.3f %6.1f %11ld %8.3g",
+            c_prof_name[i], g_prof[i].calls, g_prof[i].wall, g_prof[i].cpu,
+            fraction, g_prof[i].count, rate);
+      }
+
+      // Dump total
+      Log(Log_1, " %-18s %8s %10.3f %10.3f", "total", "", wall, cpu);
+
+    } while (0); // End of main do-loop
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Save profile as JSON file
+ *
+ * @param[in] filename JSON file name.
+ * @param[in] status Error status.
+ *
+ * Nothing is written if profiling is disabled or if the filename is empty.
+ ******************************************************************************/
+Status ProfileSave(const char *filename, Status status) {
+
+    // Declare local variables
+    FILE *fptr = NULL;
+
+    // Main do-loop to fall through in case of an error
+    do {
+
+      // Fall through if profiling is disabled or no file has been specified
+      if (!g_prof_enable || filename == NULL || filename[0] == '\0')
+        continue;
+
+      // Open file
+      fptr = fopen(filename, "w");
+      if (fptr == NULL) {
+        Log(Warning_2, "Unable to open profile file '%s'.", filename);
+        continue;
+      }
+
+      // Get total times
+      double wall = prof_wall() - g_prof_wall_start;
+      double cpu  = double(clock() - g_prof_cpu_start) / double(CLOCKS_PER_SEC);
+
+      // Write profile
+      fprintf(fptr, "{\n");
+      fprintf(fptr, "  \"tool\": \"%s\",\n", TOOL_NAME);
+      fprintf(fptr, "  \"version\": \"%s\",\n", TOOL_VERSION);
+      fprintf(fptr, "  \"wall\": %.6f,\n", wall);
+      fprintf(fptr, "  \"cpu\": %.6f,\n", cpu);
+      fprintf(fptr, "  \"stages\": {\n");
+      for (int i = 0; i < Prof_NumStages; ++i) {
+        fprintf(fptr, "    \"%s\": {\"calls\": %ld, \"wall\": %.6f, "
+                "\"cpu\": %.6f, \"count\": %ld}%s\n",
+                c_prof_key[i], g_prof[i].calls, g_prof[i].wall, g_prof[i].cpu,
+                g_prof[i].count, (i < Prof_NumStages-1) ? "," : "");
+      }
+      fprintf(fptr, "  }\n");
+      fprintf(fptr, "}\n");
+
+      // Close file
+      fclose(fptr);
+
+    } while (0); // End of main do-loop
+
+    // Return status
+    return status;
+
+}
+
+/* Namespace ends ___________________________________________________________ */
+}
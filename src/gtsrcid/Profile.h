@@ -0,0 +1,56 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file Profile.h
+ * @brief Pipeline profiling interface definition.
+ * @author J. Knodlseder
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+/* Includes _________________________________________________________________ */
+#include "sourceIdentify.h"
+
+
+/* Namespace definition _____________________________________________________ */
+namespace sourceIdentify {
+
+
+/* Type defintions __________________________________________________________ */
+typedef enum {                  // Profiled pipeline stages
+  Prof_Descriptor = 0,          //!< get_input_descriptor
+  Prof_Load,                    //!< get_input_catalogue
+  Prof_Filter,                  //!< cid_filter
+  Prof_Prune,                   //!< cid_prune
+  Prof_Select,                  //!< cid_select
+  Prof_Refine,                  //!< cid_refine
+  Prof_Reselect,                //!< cid_reselect
+  Prof_PostCat,                 //!< compute_prob_post_cat
+  Prof_Post,                    //!< compute_prob_post
+  Prof_Catch22,                 //!< catch22 iteration
+  Prof_Prob,                    //!< compute_prob
+  Prof_Output,                  //!< Output catalogue writing
+  Prof_Eval,                    //!< Formula evaluation
+  Prof_NumStages                //!< Number of stages (keep last)
+} ProfileStage;
+
+
+/* Prototypes _______________________________________________________________ */
+Status ProfileInit(int enable, Status status);
+int    ProfileEnabled(void);
+void   ProfileStart(ProfileStage stage);
+void   ProfileStop(ProfileStage stage, long count);
+Status ProfileDump(Status status);
+Status ProfileSave(const char *filename, Status status);
+
+
+/* Namespace ends ___________________________________________________________ */
+}
+#endif // PROFILE_H
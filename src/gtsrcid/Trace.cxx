@@ -0,0 +1,381 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file Trace.cxx
+ * @brief Trace event (Chrome/Perfetto timeline) interface implementation.
+ * @author J. Knodlseder
+ *
+ * Writes begin/end events in the Trace Event JSON format that can be loaded
+ * into chrome://tracing or ui.perfetto.dev. Each thread that emits events
+ * gets its own track.
+ */
+
+/* Includes _________________________________________________________________ */
+#include <stdio.h>      // for "FILE" type
+#include <stdarg.h>     // for "va_list" type
+#include <time.h>       // for "time" function
+#ifndef WIN32
+#include <sys/time.h>   // for "gettimeofday" function
+#include <pthread.h>    // for thread identification
+#endif
+#include "sourceIdentify.h"
+#include "Trace.h"
+#include "Log.h"
+
+
+/* Namespace definition _____________________________________________________ */
+namespace sourceIdentify {
+
+
+/* Definitions ______________________________________________________________ */
+#define TRACE_ARG_SIZE 1024                 // Maximum length of event arguments
+
+
+/* Private globals __________________________________________________________ */
+static FILE           *g_trace_file  = NULL;  // Trace file
+static double          g_trace_start = 0.0;   // Trace start time (usec)
+static long            g_trace_num   = 0;     // Number of written events
+static int             g_trace_tids  = 0;     // Number of known threads
+#ifndef WIN32
+static pthread_mutex_t g_trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t   g_trace_key;
+#endif
+
+
+/* Prototypes _______________________________________________________________ */
+static double trace_time(void);
+static int    trace_tid(void);
+static void   trace_event(const char *ph, const char *cat, const char *name,
+                          const char *args);
+
+
+/*============================================================================*/
+/*                              Private functions                             */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Return time in microseconds since trace start
+ ******************************************************************************/
+static double trace_time(void) {
+
+    // Get time
+    #ifndef WIN32
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    double usec = 1.0e6 * double(tv.tv_sec) + double(tv.tv_usec);
+    #else
+    double usec = 1.0e6 * double(time(NULL));
+    #endif
+
+    // Return time since start
+    return (usec - g_trace_start);
+
+}
+
+
+/**************************************************************************//**
+ * @brief Return track number of calling thread
+ *
+ * Threads are numbered in the order in which they emit their first event,
+ * starting from 1 for the main thread. The trace mutex needs to be locked
+ * by the caller.
+ ******************************************************************************/
+static int trace_tid(void) {
+
+    #ifndef WIN32
+    // Get track number of thread
+    long tid = (long)pthread_getspecific(g_trace_key);
+
+    // Assign new track number to unknown thread and name its track
+    if (tid == 0) {
+      tid = ++g_trace_tids;
+      pthread_setspecific(g_trace_key, (void*)tid);
+      fprintf(g_trace_file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", "
+              "\"pid\": 1, \"tid\": %ld, \"args\": {\"name\": \"%s %ld\"}}",
+              (g_trace_num++ > 0) ? ",\n" : "", tid,
+              (tid == 1) ? "main" : "worker", tid);
+    }
+
+    // Return track number
+    return (int)tid;
+    #else
+    return 1;
+    #endif
+
+}
+
+
+/**************************************************************************//**
+ * @brief Write trace event
+ *
+ * @param[in] ph Event phase ("B" or "E").
+ * @param[in] cat Event category.
+ * @param[in] name Event name.
+ * @param[in] args Event arguments (JSON object members, may be NULL).
+ ******************************************************************************/
+static void trace_event(const char *ph, const char *cat, const char *name,
+                        const char *args) {
+
+    // Lock trace file
+    #ifndef WIN32
+    pthread_mutex_lock(&g_trace_mutex);
+    #endif
+
+    // Write event
+    if (g_trace_file != NULL) {
+      int    tid = trace_tid();
+      double ts  = trace_time();
+      fprintf(g_trace_file, "%s{\"name\": \"%s\", \"cat\": \"%s\", "
+              "\"ph\": \"%s\", \"ts\": %.1f, \"pid\": 1, \"tid\": %d",
+              (g_trace_num++ > 0) ? ",\n" : "", name, cat, ph, ts, tid);
+      if (args != NULL && args[0] != '\0')
+        fprintf(g_trace_file, ", \"args\": {%s}", args);
+      fprintf(g_trace_file, "}");
+    }
+
+    // Unlock trace file
+    #ifndef WIN32
+    pthread_mutex_unlock(&g_trace_mutex);
+    #endif
+
+    // Return
+    return;
+
+}
+
+
+/*============================================================================*/
+/*                              Public functions                              */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Initialise tracing
+ *
+ * @param[in] filename Trace file name (no tracing if empty).
+ * @param[in] status Error status.
+ ******************************************************************************/
+Status TraceInit(const char *filename, Status status) {
+
+    // Main do-loop to fall through in case of an error
+    do {
+
+      // Fall through in case of an error
+      if (status != STATUS_OK)
+        continue;
+
+      // Fall through if no trace file has been specified
+      if (filename == NULL || filename[0] == '\0')
+        continue;
+
+      // Close any open trace
+      TraceClose(status);
+
+      // Open trace file
+      g_trace_file = fopen(filename, "w");
+      if (g_trace_file == NULL) {
+        Log(Warning_2, "Unable to open trace file '%s'. Tracing disabled.",
+            filename);
+        continue;
+      }
+
+      // Initialise trace
+      #ifndef WIN32
+      pthread_key_create(&g_trace_key, NULL);
+      #endif
+      g_trace_start = 0.0;
+      g_trace_start = trace_time();
+      g_trace_num   = 0;
+      g_trace_tids  = 0;
+      fprintf(g_trace_file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+
+    } while (0); // End of main do-loop
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Finish tracing
+ *
+ * @param[in] status Error status.
+ ******************************************************************************/
+Status TraceClose(Status status) {
+
+    // Main do-loop to fall through in case of an error
+    do {
+
+      // Fall through if no trace is open
+      if (g_trace_file == NULL)
+        continue;
+
+      // Close trace file
+      fprintf(g_trace_file, "\n]}\n");
+      fclose(g_trace_file);
+      g_trace_file = NULL;
+      #ifndef WIN32
+      pthread_key_delete(g_trace_key);
+      #endif
+
+    } while (0); // End of main do-loop
+
+    // Return status
+    return status;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Write buffered trace events to the trace file
+ *
+ * Needs to be called before fork(), so that the child process does not
+ * inherit pending events in its copy of the stdio buffer.
+ ******************************************************************************/
+void TraceFlush(void) {
+
+    // Lock trace file
+    #ifndef WIN32
+    pthread_mutex_lock(&g_trace_mutex);
+    #endif
+
+    // Flush trace file
+    if (g_trace_file != NULL)
+      fflush(g_trace_file);
+
+    // Unlock trace file
+    #ifndef WIN32
+    pthread_mutex_unlock(&g_trace_mutex);
+    #endif
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Detach forked child process from trace
+ *
+ * Disables tracing in a child process without writing to or closing the
+ * trace file, which is still owned by the parent. The trace mutex is reset
+ * as it may have been held by another thread of the parent at fork().
+ ******************************************************************************/
+void TraceDetach(void) {
+
+    // Forget trace file
+    g_trace_file = NULL;
+    #ifndef WIN32
+    pthread_mutex_init(&g_trace_mutex, NULL);
+    #endif
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Signals if tracing is enabled
+ ******************************************************************************/
+int TraceEnabled(void) {
+
+    // Return enable flag
+    return (g_trace_file != NULL);
+
+}
+
+
+/**************************************************************************//**
+ * @brief Begin trace span
+ *
+ * @param[in] cat Span category.
+ * @param[in] name Span name.
+ ******************************************************************************/
+void TraceBegin(const char *cat, const char *name) {
+
+    // Write begin event
+    if (g_trace_file != NULL)
+      trace_event("B", cat, name, NULL);
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Escape string for use in span arguments
+ *
+ * @param[in] arg String (e.g. a file name or formula).
+ *
+ * Escapes quotes, backslashes and control characters so that the string can
+ * be placed between quotes in a JSON object member.
+ ******************************************************************************/
+std::string TraceEscape(const std::string &arg) {
+
+    // Declare local variables
+    std::string result;
+    char        code[8];
+
+    // Escape characters
+    for (std::string::size_type i = 0; i < arg.length(); ++i) {
+      unsigned char c = (unsigned char)arg[i];
+      if (c == '"' || c == '\\') {
+        result += '\\';
+        result += (char)c;
+      }
+      else if (c < 0x20) {
+        sprintf(code, "\\u%04x", (unsigned int)c);
+        result += code;
+      }
+      else
+        result += (char)c;
+    }
+
+    // Return escaped string
+    return result;
+
+}
+
+
+/**************************************************************************//**
+ * @brief End trace span
+ *
+ * @param[in] cat Span category.
+ * @param[in] name Span name.
+ * @param[in] argFormat Format of span arguments (JSON object members, or NULL).
+ *
+ * The span arguments are only formatted if tracing is enabled. String
+ * arguments need to be escaped using TraceEscape().
+ ******************************************************************************/
+void TraceEnd(const char *cat, const char *name, const char *argFormat, ...) {
+
+    // Declare local variables
+    char    args[TRACE_ARG_SIZE];
+    va_list vl;
+
+    // Write end event
+    if (g_trace_file != NULL) {
+      args[0] = '\0';
+      if (argFormat != NULL) {
+        va_start(vl, argFormat);
+        vsnprintf(args, TRACE_ARG_SIZE, argFormat, vl);
+        va_end(vl);
+      }
+      trace_event("E", cat, name, args);
+    }
+
+    // Return
+    return;
+
+}
+
+/* Namespace ends ___________________________________________________________ */
+}
@@ -0,0 +1,40 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file Trace.h
+ * @brief Trace event (Chrome/Perfetto timeline) interface definition.
+ * @author J. Knodlseder
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/* Includes _________________________________________________________________ */
+#include <string>
+#include "sourceIdentify.h"
+
+
+/* Namespace definition _____________________________________________________ */
+namespace sourceIdentify {
+
+
+/* Prototypes _______________________________________________________________ */
+Status TraceInit(const char *filename, Status status);
+Status TraceClose(Status status);
+int    TraceEnabled(void);
+void   TraceFlush(void);
+void   TraceDetach(void);
+void   TraceBegin(const char *cat, const char *name);
+void   TraceEnd(const char *cat, const char *name, const char *argFormat, ...);
+std::string TraceEscape(const std::string &arg);
+
+
+/* Namespace ends ___________________________________________________________ */
+}
+#endif // TRACE_H
@@ -47,10 +47,13 @@ Replace header information with CVS typeset information.
  */
 
 /* Includes _________________________________________________________________ */
+#include <stdlib.h>          // for "getenv" function
 #include <time.h>            // for "clock_t" type
 #include "sourceIdentify.h"
 #include "Parameters.h"
 #include "Log.h"
+#include "Profile.h"
+#include "Trace.h"
 #include "Catalogue.h"
 
 /* Namespace usage __________________________________________________________ */
@@ -92,64 +95,97 @@ public:
       Parameters par;
       Catalogue  cat;
 
-      // Main do-loop to fall through in case of an error
-      do {
-
-        // Save the execution start time
-        t_start = clock();
-
-        // Initialise log file
-        status = LogInit(TOOL_LOGFILE, TOOL_VERSION, status);
-        if (status != STATUS_OK)
-          continue;
-
-        // Get parameter file object
-        st_app::AppParGroup &pars(getParGroup(TOOL_NAME));
-
-        // Load task parameters
-        status = par.load(pars, status);
-        if (status != STATUS_OK) {
-          if (par.logTerse())
-            Log(Error_3, "%d : Error while loading task parameters.", status);
-          continue;
-        }
-
-        // Dump header into log file
-        if (par.logTerse()) {
-          Log(Log_1, HD_BORDER);
-          Log(Log_1, HD_NAME);
-          Log(Log_1, HD_SEP);
-          Log(Log_1, HD_VERSION);
-          Log(Log_1, HD_DATE);
-          Log(Log_1, HD_AUTHOR);
-          Log(Log_1, HD_BORDER);
-        }
-
-        // Dump task parameters
-        if (par.logTerse()) {
-          status = par.dump(status);
+      // Write buffered log messages and close the trace if an exception
+      // (e.g. a parameter error) escapes, as LogClose() is then skipped
+      try {
+
+        // Main do-loop to fall through in case of an error
+        do {
+
+          // Save the execution start time
+          t_start = clock();
+
+          // Initialise log file (the log file name may be overridden by the
+          // environment, so that concurrent runs do not share the log file)
+          const char *logfile = getenv(TOOL_LOGENV);
+          if (logfile == NULL || logfile[0] == '\0')
+            logfile = TOOL_LOGFILE;
+          status = LogInit(logfile, TOOL_VERSION, status);
+          if (status != STATUS_OK)
+            continue;
+
+          // Get parameter file object
+          st_app::AppParGroup &pars(getParGroup(TOOL_NAME));
+
+          // Load task parameters
+          status = par.load(pars, status);
+          if (status != STATUS_OK) {
+            if (par.logTerse())
+              Log(Error_3, "%d : Error while loading task parameters.", status);
+            continue;
+          }
+
+          // Initialise pipeline profiling
+          status = ProfileInit(par.profile(), status);
+
+          // Initialise trace event file
+          status = TraceInit(par.traceFile().c_str(), status);
+
+          // Optionally start background log writer
+          if (par.logAsync())
+            LogAsync(1, status);
+
+          // Dump header into log file
+          if (par.logTerse()) {
+            Log(Log_1, HD_BORDER);
+            Log(Log_1, HD_NAME);
+            Log(Log_1, HD_SEP);
+            Log(Log_1, HD_VERSION);
+            Log(Log_1, HD_DATE);
+            Log(Log_1, HD_AUTHOR);
+            Log(Log_1, HD_BORDER);
+          }
+
+          // Dump task parameters
+          if (par.logTerse()) {
+            status = par.dump(status);
+            if (status != STATUS_OK) {
+              if (par.logTerse())
+                Log(Error_3, "%d : Error while dumping task parameters.", status);
+              continue;
+            }
+          }
+
+          // Build counterpart catalogue
+          status = cat.build(&par, status);
           if (status != STATUS_OK) {
             if (par.logTerse())
-              Log(Error_3, "%d : Error while dumping task parameters.", status);
+              Log(Error_3, "%d : Error while building counterpart candidate"
+                           " catalogue.", status);
             continue;
           }
-        }
 
-        // Build counterpart catalogue
-        status = cat.build(&par, status);
-        if (status != STATUS_OK) {
-          if (par.logTerse())
-            Log(Error_3, "%d : Error while building counterpart candidate"
-                         " catalogue.", status);
-          continue;
-        }
+        } while (0); // End of main do-loop
 
-      } while (0); // End of main do-loop
+      }
+      catch (...) {
+        TraceClose(STATUS_OK);
+        LogClose(STATUS_OK);
+        throw;
+      }
 
       // Save the execution stop time and calculate elapsed time
       clock_t t_stop   = clock();
       double  t_elapse = (double)(t_stop - t_start) / (double)CLOCKS_PER_SEC;
 
+      // Dump and save pipeline profile
+      if (par.logTerse())
+        ProfileDump(STATUS_OK);
+      ProfileSave(par.profileFile().c_str(), STATUS_OK);
+
+      // Close trace event file
+      TraceClose(STATUS_OK);
+
       // Dump termination message
       if (par.logTerse())
         Log(Log_1, "Task terminated using %.3f sec CPU time.", t_elapse);
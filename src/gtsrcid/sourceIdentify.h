@@ -137,6 +137,7 @@ Replace header information with CVS typeset information.
 #define TOOL_NAME     "gtsrcid"
 #define TOOL_VERSION  "v2r4p0"
 #define TOOL_LOGFILE  "gtsrcid.log"
+#define TOOL_LOGENV   "GTSRCID_LOGFILE"     // Overrides TOOL_LOGFILE
 #define TOOL_DATE     "12-Jun-2014"
 #define HD_BORDER     "************************************************************"
 #define HD_SEP        "* -------------------------------------------------------- *"
@@ -186,7 +187,8 @@ typedef enum  {                                  // Function status code
   STATUS_FCT_NOT_FOUND     = -100500,             // Function not found
   STATUS_FCT_INVALID       = -100502,             // Invalid function
   STATUS_FCT_NO_CLOSING    = -100503,             // No closing parenthesis
-  STATUS_FCT_BAD_NUM_ARG   = -100504              // Bad number of function args
+  STATUS_FCT_BAD_NUM_ARG   = -100504,             // Bad number of function args
+  STATUS_MC_WORKER_FAILED  = -100600              // Monte Carlo worker failed
 } Status;
 
 /* Prototypes _______________________________________________________________ */
@@ -0,0 +1,702 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file srcidmodule.cxx
+ * @brief Python extension module for the source association engine.
+ * @author J. Knodlseder
+ *
+ * Implements the _srcid Python module that gives access to the in-memory
+ * association interface (see Associate.h). Catalogues are passed as
+ * dictionaries of NumPy arrays, NumPy structured arrays or FITS table HDUs.
+ * Double precision, contiguous columns are used without copy. The global
+ * interpreter lock is released while the association is computed, and the
+ * results are returned as a NumPy structured array.
+ *
+ * Usage:
+ *   import _srcid
+ *   res = _srcid.associate(src, cpt, probPrior='0.062', probThres=0.5)
+ *
+ * The position columns need to be named 'ra' and 'dec' (deg). The optional
+ * columns 'err_maj', 'err_min' and 'err_ang' (deg) give the 95% confidence
+ * error ellipse, the optional column 'name' gives the object names. All
+ * remaining numerical columns may be referenced in formulae and selection
+ * criteria as @<prefix>_<column>.
+ */
+
+/* Includes _________________________________________________________________ */
+#include <Python.h>
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+#include <pthread.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "Associate.h"
+
+
+/* Definitions ______________________________________________________________ */
+#define MODULE_NAME   "_srcid"
+
+
+/* Namespace definition _____________________________________________________ */
+using namespace sourceIdentify;
+
+
+/* Type defintions __________________________________________________________ */
+typedef struct {                      // Python catalogue
+  AssocCatalogue             cat;        //!< In-memory catalogue
+  std::vector<PyObject*>     arrays;     //!< Array references
+  std::vector<std::string>   names;      //!< Object names
+  std::vector<const char*>   name_ptr;   //!< Object name pointers
+} PyCatalogue;
+
+
+/* Globals __________________________________________________________________ */
+static pthread_mutex_t g_srcid_mutex = PTHREAD_MUTEX_INITIALIZER;
+static PyObject       *g_srcid_error = NULL;
+static const char     *c_res_names[] = {"prob", "prob_pos", "prob_chance",
+                                        "prob_prior", "prob_post",
+                                        "prob_post_single", "loglr",
+                                        "angsep", "psi", "rho", "fom"};
+static const int       c_num_res     = 11;
+
+
+/* Private Prototypes _______________________________________________________ */
+static const char *object_string(PyObject *str);
+static void      catalogue_free(PyCatalogue *cat);
+static PyObject *catalogue_keys(PyObject *obj);
+static int       catalogue_column(PyCatalogue *cat, PyObject *obj,
+                                  const char *key, const double **ptr);
+static int       catalogue_names(PyCatalogue *cat, PyObject *obj);
+static int       catalogue_load(PyCatalogue *cat, PyObject *obj);
+static int       options_string(PyObject *kwargs, const char *key,
+                                std::string &value);
+static int       options_list(PyObject *kwargs, const char *key,
+                              std::vector<std::string> &value);
+static int       options_load(AssocOptions *opt, PyObject *kwargs);
+static PyObject *result_array(const AssocResult &res);
+
+
+/*============================================================================*/
+/*                              Private functions                             */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Return character string of Python string object
+ *
+ * @param[in] str Python string object (e.g. returned by PyObject_Str()).
+ *
+ * Returns NULL with a Python exception set if the string can not be
+ * converted (e.g. on encoding errors). The character string is owned by
+ * @p str.
+ ******************************************************************************/
+static const char *object_string(PyObject *str) {
+
+    // Get character string
+    #if PY_MAJOR_VERSION >= 3
+    const char *c = PyUnicode_AsUTF8(str);
+    #else
+    const char *c = PyString_AsString(str);
+    #endif
+
+    // Return character string
+    return c;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Release Python catalogue
+ *
+ * @param[in] cat Pointer to Python catalogue.
+ ******************************************************************************/
+static void catalogue_free(PyCatalogue *cat) {
+
+    // Release array references
+    for (int i = 0; i < (int)cat->arrays.size(); ++i)
+      Py_XDECREF(cat->arrays[i]);
+    cat->arrays.clear();
+
+    // Return
+    return;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Return column names of catalogue object
+ *
+ * @param[in] obj Dictionary, structured array or FITS table HDU.
+ *
+ * Returns a new reference to a list of column names or NULL if the object
+ * is not a catalogue.
+ ******************************************************************************/
+static PyObject *catalogue_keys(PyObject *obj) {
+
+    // Dictionary
+    if (PyDict_Check(obj))
+      return PyDict_Keys(obj);
+
+    // Structured array (including FITS_rec)
+    if (PyArray_Check(obj)) {
+      PyObject *dtype = PyObject_GetAttrString(obj, "dtype");
+      PyObject *names = (dtype != NULL) ? PyObject_GetAttrString(dtype, "names")
+                                        : NULL;
+      Py_XDECREF(dtype);
+      if (names != NULL && names != Py_None) {
+        PyObject *list = PySequence_List(names);
+        Py_DECREF(names);
+        return list;
+      }
+      Py_XDECREF(names);
+      PyErr_Clear();
+    }
+
+    // Signal error
+    PyErr_SetString(PyExc_TypeError, "Catalogue must be a dictionary of arrays,"
+                    " a structured array or a FITS table HDU.");
+    return NULL;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Get double precision column
+ *
+ * @param[in] cat Pointer to Python catalogue.
+ * @param[in] obj Catalogue object.
+ * @param[in] key Column name.
+ * @param[out] ptr Pointer to column data (NULL if column does not exist).
+ *
+ * The column is converted to a contiguous double precision array. No copy
+ * is made if the column already has this layout. The array reference is
+ * kept in the catalogue until catalogue_free() is called. Returns -1 on
+ * error, 0 otherwise.
+ ******************************************************************************/
+static int catalogue_column(PyCatalogue *cat, PyObject *obj, const char *key,
+                            const double **ptr) {
+
+    // Initialise pointer
+    *ptr = NULL;
+
+    // Get column (skip if column does not exist)
+    PyObject *col = PyMapping_GetItemString(obj, (char*)key);
+    if (col == NULL) {
+      PyErr_Clear();
+      return 0;
+    }
+
+    // Convert to contiguous double precision array
+    PyObject *arr = PyArray_FROM_OTF(col, NPY_DOUBLE, NPY_ARRAY_IN_ARRAY);
+    Py_DECREF(col);
+    if (arr == NULL)
+      return -1;
+
+    // Check dimension
+    if (PyArray_NDIM((PyArrayObject*)arr) != 1 ||
+        PyArray_DIM((PyArrayObject*)arr, 0) != cat->cat.numObjects) {
+      Py_DECREF(arr);
+      PyErr_Format(PyExc_ValueError, "Column '%s' has wrong dimension.", key);
+      return -1;
+    }
+
+    // Keep reference and set pointer
+    cat->arrays.push_back(arr);
+    *ptr = (const double*)PyArray_DATA((PyArrayObject*)arr);
+
+    // Return
+    return 0;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Get object names
+ *
+ * @param[in] cat Pointer to Python catalogue.
+ * @param[in] obj Catalogue object.
+ *
+ * Returns -1 on error, 0 otherwise.
+ ******************************************************************************/
+static int catalogue_names(PyCatalogue *cat, PyObject *obj) {
+
+    // Get column (skip if column does not exist)
+    PyObject *col = PyMapping_GetItemString(obj, (char*)"name");
+    if (col == NULL) {
+      PyErr_Clear();
+      return 0;
+    }
+
+    // Get sequence
+    PyObject *seq = PySequence_Fast(col, "Column 'name' is not a sequence.");
+    Py_DECREF(col);
+    if (seq == NULL)
+      return -1;
+    if (PySequence_Fast_GET_SIZE(seq) != cat->cat.numObjects) {
+      Py_DECREF(seq);
+      PyErr_SetString(PyExc_ValueError, "Column 'name' has wrong dimension.");
+      return -1;
+    }
+
+    // Convert names
+    cat->names.assign(cat->cat.numObjects, std::string());
+    for (long i = 0; i < cat->cat.numObjects; ++i) {
+      PyObject *item = PySequence_Fast_GET_ITEM(seq, i);
+      if (PyBytes_Check(item))
+        cat->names[i] = PyBytes_AsString(item);
+      else {
+        PyObject *str = PyObject_Str(item);
+        if (str == NULL) {
+          Py_DECREF(seq);
+          return -1;
+        }
+        const char *c = object_string(str);
+        if (c == NULL) {
+          Py_DECREF(str);
+          Py_DECREF(seq);
+          return -1;
+        }
+        cat->names[i] = c;
+        Py_DECREF(str);
+      }
+    }
+    Py_DECREF(seq);
+
+    // Set name pointers
+    cat->name_ptr.assign(cat->cat.numObjects, (const char*)NULL);
+    for (long i = 0; i < cat->cat.numObjects; ++i)
+      cat->name_ptr[i] = cat->names[i].c_str();
+    cat->cat.names = &(cat->name_ptr[0]);
+
+    // Return
+    return 0;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Load Python catalogue
+ *
+ * @param[in] cat Pointer to Python catalogue.
+ * @param[in] obj Dictionary, structured array or FITS table HDU.
+ *
+ * Returns -1 on error, 0 otherwise.
+ ******************************************************************************/
+static int catalogue_load(PyCatalogue *cat, PyObject *obj) {
+
+    // Declare local variables
+    int       rc   = -1;
+    PyObject *data = NULL;
+    PyObject *keys = NULL;
+
+    // Initialise catalogue
+    AssocInitCatalogue(&cat->cat);
+
+    // Single loop for common exit point
+    do {
+
+      // Use data of FITS HDUs
+      if (!PyDict_Check(obj) && !PyArray_Check(obj) &&
+          PyObject_HasAttrString(obj, "data"))
+        data = PyObject_GetAttrString(obj, "data");
+      else {
+        data = obj;
+        Py_INCREF(data);
+      }
+      if (data == NULL)
+        break;
+
+      // Get column names
+      keys = catalogue_keys(data);
+      if (keys == NULL)
+        break;
+
+      // Get number of objects from the 'ra' column
+      PyObject *ra = PyMapping_GetItemString(data, (char*)"ra");
+      if (ra == NULL) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_KeyError, "Catalogue has no 'ra' column.");
+        break;
+      }
+      cat->cat.numObjects = (long)PyObject_Length(ra);
+      Py_DECREF(ra);
+      if (cat->cat.numObjects < 0)
+        break;
+
+      // Get position and error columns
+      if (catalogue_column(cat, data, "ra",      &cat->cat.ra)      ||
+          catalogue_column(cat, data, "dec",     &cat->cat.dec)     ||
+          catalogue_column(cat, data, "err_maj", &cat->cat.err_maj) ||
+          catalogue_column(cat, data, "err_min", &cat->cat.err_min) ||
+          catalogue_column(cat, data, "err_ang", &cat->cat.err_ang))
+        break;
+      if (cat->cat.dec == NULL) {
+        PyErr_SetString(PyExc_KeyError, "Catalogue has no 'dec' column.");
+        break;
+      }
+
+      // Get object names
+      if (catalogue_names(cat, data))
+        break;
+
+      // Get additional numerical columns (non numerical columns are skipped)
+      Py_ssize_t num = PyList_Size(keys);
+      rc = 0;
+      for (Py_ssize_t i = 0; i < num; ++i) {
+        PyObject *key = PyList_GetItem(keys, i);
+        PyObject *str = PyObject_Str(key);
+        if (str == NULL) {
+          rc = -1;
+          break;
+        }
+        const char *c = object_string(str);
+        if (c == NULL) {
+          Py_DECREF(str);
+          rc = -1;
+          break;
+        }
+        std::string name = c;
+        Py_DECREF(str);
+        if (name == "ra" || name == "dec" || name == "err_maj" ||
+            name == "err_min" || name == "err_ang" || name == "name")
+          continue;
+        const double *ptr = NULL;
+        if (catalogue_column(cat, data, name.c_str(), &ptr)) {
+          PyErr_Clear();
+          continue;
+        }
+        if (ptr != NULL) {
+          cat->cat.colNames.push_back(name);
+          cat->cat.colData.push_back(ptr);
+        }
+      }
+
+    } while (0); // End of main do-loop
+
+    // Release references
+    Py_XDECREF(keys);
+    Py_XDECREF(data);
+
+    // Return
+    return rc;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Get string option
+ *
+ * @param[in] kwargs Keyword dictionary (may be NULL).
+ * @param[in] key Option name.
+ * @param[out] value Option value (unchanged if option is not given).
+ *
+ * Numbers are accepted and converted into strings. Returns -1 on error,
+ * 0 otherwise.
+ ******************************************************************************/
+static int options_string(PyObject *kwargs, const char *key,
+                          std::string &value) {
+
+    // Get option
+    PyObject *item = (kwargs != NULL) ? PyDict_GetItemString(kwargs, key) : NULL;
+    if (item == NULL)
+      return 0;
+
+    // Convert into string
+    PyObject *str = PyObject_Str(item);
+    if (str == NULL)
+      return -1;
+    const char *c = object_string(str);
+    if (c == NULL) {
+      Py_DECREF(str);
+      return -1;
+    }
+    value = c;
+    Py_DECREF(str);
+
+    // Return
+    return 0;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Get list of strings option
+ *
+ * @param[in] kwargs Keyword dictionary (may be NULL).
+ * @param[in] key Option name.
+ * @param[out] value Option values (unchanged if option is not given).
+ *
+ * Returns -1 on error, 0 otherwise.
+ ******************************************************************************/
+static int options_list(PyObject *kwargs, const char *key,
+                        std::vector<std::string> &value) {
+
+    // Get option
+    PyObject *item = (kwargs != NULL) ? PyDict_GetItemString(kwargs, key) : NULL;
+    if (item == NULL)
+      return 0;
+
+    // Get sequence
+    PyObject *seq = PySequence_Fast(item, "Option is not a sequence.");
+    if (seq == NULL)
+      return -1;
+
+    // Convert elements into strings
+    value.clear();
+    for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(seq); ++i) {
+      PyObject *str = PyObject_Str(PySequence_Fast_GET_ITEM(seq, i));
+      if (str == NULL) {
+        Py_DECREF(seq);
+        return -1;
+      }
+      const char *c = object_string(str);
+      if (c == NULL) {
+        Py_DECREF(str);
+        Py_DECREF(seq);
+        return -1;
+      }
+      value.push_back(c);
+      Py_DECREF(str);
+    }
+    Py_DECREF(seq);
+
+    // Return
+    return 0;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Load association options from keywords
+ *
+ * @param[out] opt Pointer to association options.
+ * @param[in] kwargs Keyword dictionary (may be NULL).
+ *
+ * The keywords follow the gtsrcid parameter names. Returns -1 on error,
+ * 0 otherwise.
+ ******************************************************************************/
+static int options_load(AssocOptions *opt, PyObject *kwargs) {
+
+    // Declare local variables
+    std::string value;
+
+    // Set defaults
+    AssocInitOptions(opt);
+
+    // Get string options
+    if (options_string(kwargs, "srcCatPrefix", opt->srcPrefix) ||
+        options_string(kwargs, "cptCatPrefix", opt->cptPrefix) ||
+        options_string(kwargs, "probMethod",   opt->probMethod) ||
+        options_string(kwargs, "probPrior",    opt->probPrior)  ||
+        options_string(kwargs, "fom",          opt->fom)        ||
+        options_list(kwargs,   "outCatQty",    opt->outCatQty)  ||
+        options_list(kwargs,   "select",       opt->select))
+      return -1;
+
+    // Get numerical options
+    if (kwargs != NULL) {
+      PyObject *item;
+      if ((item = PyDict_GetItemString(kwargs, "srcPosError")) != NULL)
+        opt->srcPosError = PyFloat_AsDouble(item);
+      if ((item = PyDict_GetItemString(kwargs, "cptPosError")) != NULL)
+        opt->cptPosError = PyFloat_AsDouble(item);
+      if ((item = PyDict_GetItemString(kwargs, "probThres")) != NULL)
+        opt->probThres = PyFloat_AsDouble(item);
+      if ((item = PyDict_GetItemString(kwargs, "maxNumCpt")) != NULL)
+        opt->maxNumCpt = PyLong_AsLong(item);
+      if ((item = PyDict_GetItemString(kwargs, "chatter")) != NULL)
+        opt->chatter = (int)PyLong_AsLong(item);
+      if (PyErr_Occurred())
+        return -1;
+    }
+
+    // Return
+    return 0;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Build NumPy structured array from association results
+ *
+ * @param[in] res Association results.
+ *
+ * The array has the fields 'src' and 'cpt' (row indices starting from 0),
+ * the probability and distance columns and all new output quantities.
+ ******************************************************************************/
+static PyObject *result_array(const AssocResult &res) {
+
+    // Declare local variables
+    PyObject      *spec  = NULL;
+    PyArray_Descr *descr = NULL;
+    PyObject      *array = NULL;
+
+    // Collect double precision columns
+    std::vector<const std::vector<double>*> cols;
+    std::vector<std::string>                names;
+    const std::vector<double> *std_cols[] = {&res.prob, &res.prob_pos,
+                                             &res.prob_chance, &res.prob_prior,
+                                             &res.prob_post,
+                                             &res.prob_post_single, &res.likrat,
+                                             &res.angsep, &res.psi, &res.rho,
+                                             &res.fom};
+    for (int i = 0; i < c_num_res; ++i) {
+      cols.push_back(std_cols[i]);
+      names.push_back(c_res_names[i]);
+    }
+    for (int i = 0; i < (int)res.qtyNames.size(); ++i) {
+      cols.push_back(&(res.qtyData[i]));
+      names.push_back(res.qtyNames[i]);
+    }
+
+    // Build dtype specification [('src','<i4'), ('cpt','<i8'), ...]
+    spec = PyList_New(0);
+    PyList_Append(spec, Py_BuildValue("(ss)", "src", "i4"));
+    PyList_Append(spec, Py_BuildValue("(ss)", "cpt", "i8"));
+    for (int i = 0; i < (int)names.size(); ++i)
+      PyList_Append(spec, Py_BuildValue("(ss)", names[i].c_str(), "f8"));
+    for (Py_ssize_t i = 0; i < PyList_Size(spec); ++i)
+      Py_DECREF(PyList_GetItem(spec, i));
+
+    // Create array (packed layout)
+    if (PyArray_DescrConverter(spec, &descr) != NPY_SUCCEED) {
+      Py_DECREF(spec);
+      return NULL;
+    }
+    Py_DECREF(spec);
+    npy_intp dims[1] = {(npy_intp)res.numAssoc};
+    array = PyArray_NewFromDescr(&PyArray_Type, descr, 1, dims, NULL, NULL,
+                                 0, NULL);
+    if (array == NULL)
+      return NULL;
+
+    // Fill array
+    char *ptr = (char*)PyArray_DATA((PyArrayObject*)array);
+    for (long row = 0; row < res.numAssoc; ++row) {
+      npy_int32 src = (npy_int32)res.src[row];
+      npy_int64 cpt = (npy_int64)res.cpt[row];
+      memcpy(ptr, &src, sizeof(src));
+      ptr += sizeof(src);
+      memcpy(ptr, &cpt, sizeof(cpt));
+      ptr += sizeof(cpt);
+      for (int i = 0; i < (int)cols.size(); ++i) {
+        double value = (*cols[i])[row];
+        memcpy(ptr, &value, sizeof(value));
+        ptr += sizeof(value);
+      }
+    }
+
+    // Return array
+    return array;
+
+}
+
+
+/*============================================================================*/
+/*                              Module functions                              */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Associate source and counterpart catalogues
+ *
+ * @param[in] self Module.
+ * @param[in] args Positional arguments (src, cpt).
+ * @param[in] kwargs Keyword arguments (gtsrcid parameters).
+ *
+ * The keywords are srcCatPrefix, cptCatPrefix, srcPosError, cptPosError,
+ * probMethod, probPrior, probThres, maxNumCpt, fom, outCatQty (list),
+ * select (list) and chatter. Concurrent calls from several Python threads
+ * are serialised, since the engine logging is not reentrant.
+ ******************************************************************************/
+static PyObject *srcid_associate(PyObject *self, PyObject *args,
+                                 PyObject *kwargs) {
+
+    // Declare local variables
+    PyObject     *obj_src = NULL;
+    PyObject     *obj_cpt = NULL;
+    PyObject     *result  = NULL;
+    PyCatalogue   src;
+    PyCatalogue   cpt;
+    AssocOptions  opt;
+    AssocResult   res;
+    Status        status  = STATUS_OK;
+
+    // Get catalogues
+    if (!PyArg_ParseTuple(args, "OO:associate", &obj_src, &obj_cpt))
+      return NULL;
+
+    // Single loop for common exit point
+    do {
+
+      // Load catalogues and options
+      if (catalogue_load(&src, obj_src) || catalogue_load(&cpt, obj_cpt) ||
+          options_load(&opt, kwargs))
+        break;
+
+      // Associate catalogues without holding the interpreter lock
+      Py_BEGIN_ALLOW_THREADS
+      pthread_mutex_lock(&g_srcid_mutex);
+      status = associate(src.cat, cpt.cat, opt, res, status);
+      pthread_mutex_unlock(&g_srcid_mutex);
+      Py_END_ALLOW_THREADS
+      if (status != STATUS_OK) {
+        PyErr_Format(g_srcid_error, "Association failed (status=%d).", status);
+        break;
+      }
+
+      // Build result array
+      result = result_array(res);
+
+    } while (0); // End of main do-loop
+
+    // Release catalogue arrays
+    catalogue_free(&src);
+    catalogue_free(&cpt);
+
+    // Return result
+    return result;
+
+}
+
+
+/* Module definition ________________________________________________________ */
+static PyMethodDef srcid_methods[] = {
+  {"associate", (PyCFunction)srcid_associate, METH_VARARGS | METH_KEYWORDS,
+   "associate(src, cpt, **pars) -> structured array of associations"},
+  {NULL, NULL, 0, NULL}
+};
+
+#if PY_MAJOR_VERSION >= 3
+static struct PyModuleDef srcid_module = {
+  PyModuleDef_HEAD_INIT, MODULE_NAME,
+  "In-memory source association engine of gtsrcid.", -1, srcid_methods
+};
+
+PyMODINIT_FUNC PyInit__srcid(void) {
+    import_array();
+    PyObject *module = PyModule_Create(&srcid_module);
+    if (module == NULL)
+      return NULL;
+    g_srcid_error = PyErr_NewException((char*)MODULE_NAME ".error", NULL, NULL);
+    Py_INCREF(g_srcid_error);
+    PyModule_AddObject(module, "error", g_srcid_error);
+    return module;
+}
+#else
+PyMODINIT_FUNC init_srcid(void) {
+    import_array();
+    PyObject *module = Py_InitModule3(MODULE_NAME, srcid_methods,
+                       "In-memory source association engine of gtsrcid.");
+    if (module == NULL)
+      return;
+    g_srcid_error = PyErr_NewException((char*)MODULE_NAME ".error", NULL, NULL);
+    Py_INCREF(g_srcid_error);
+    PyModule_AddObject(module, "error", g_srcid_error);
+}
+#endif
@@ -0,0 +1,714 @@
+/*------------------------------------------------------------------------------
+Id ........: $Id$
+Author ....: $Author$
+Revision ..: $Revision$
+Date ......: $Date$
+--------------------------------------------------------------------------------
+$Log$
+------------------------------------------------------------------------------*/
+/**
+ * @file gtsrcid_server.cxx
+ * @brief Resident source association server.
+ * @author J. Knodlseder
+ *
+ * Loads one or more counterpart catalogues once, together with their
+ * declination indices and FITS memory catalogues, and answers association
+ * requests for individual source positions over a line protocol on
+ * stdin/stdout or on a local UNIX socket.
+ *
+ * Usage:
+ *   gtsrcid_server [-socket PATH] [-log FILE] [-stream] CONFIG
+ *
+ * Each non-empty line of the CONFIG file that does not start with '#'
+ * defines one counterpart catalogue:
+ *   LABEL cptCatName=FILE [KEY=VALUE ...]
+ * where KEY is one of the gtsrcid parameters cptCatPrefix, cptDensFile,
+ * srcPosError, cptPosError, probMethod, probPrior, probThres, maxNumCpt,
+ * fom, outCatQty01..09, select01..09 or chatter. Values containing blanks
+ * need to be quoted ('...' or "...").
+ *
+ * Request lines:
+ *   ID RA DEC ERR_MAJ [ERR_MIN ERR_ANG] [@LABEL]
+ * with the position in deg and the 95% error ellipse in deg. Without @LABEL
+ * the source is associated with all catalogues. The reply consists of one
+ * line per counterpart, ranked by decreasing probability:
+ *   ID LABEL RANK ROW PROB PROB_POST_SINGLE ANGSEP NAME
+ * where ROW is the counterpart catalogue row (starting from 1), followed by
+ *   ID END NUMBER MILLISECONDS
+ * Errors are reported as "ID ERROR message". The commands "ping" and "quit"
+ * are also understood. Lines starting with '#' are ignored.
+ *
+ * With -stream the request sources are not associated independently but
+ * accumulate into one source list per catalogue (see Catalogue::stream), so
+ * that PROB_POST_CAT and PROB_POST account for all sources received so far.
+ * The reply starts with the provisional candidates of the new source,
+ * ranked by decreasing PROB_POST_SINGLE:
+ *   ID PROV LABEL RANK ROW PROB_POST_SINGLE ANGSEP NAME
+ * followed, for each source whose results changed (including the new one),
+ * by its complete new list of counterparts in the usual reply format:
+ *   SRCID UPDATE LABEL NUMBER
+ *   SRCID LABEL RANK ROW PROB PROB_POST_SINGLE ANGSEP NAME
+ * A growing TSV source list can be associated continuously with
+ *   tail -f sources.tsv | gtsrcid_server -stream CONFIG
+ */
+
+/* Includes _________________________________________________________________ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <string>
+#include <vector>
+#include "Associate.h"
+#include "Parameters.h"
+#include "Catalogue.h"
+#include "Log.h"
+
+
+/* Definitions ______________________________________________________________ */
+#define SERVER_NAME      "gtsrcid_server"     // Task name
+#define SERVER_LINE_LEN  65536                // Maximum request line length
+
+
+/* Namespace definition _____________________________________________________ */
+using namespace sourceIdentify;
+
+
+/* Type defintions __________________________________________________________ */
+typedef struct {                // Server options
+  std::string socket;           //!< UNIX socket path (empty: stdin/stdout)
+  std::string log;              //!< Log file name (empty: no log)
+  std::string config;           //!< Configuration file
+  int         stream;           //!< Streaming mode
+} ServerOptions;
+
+typedef struct {                // Resident counterpart catalogue
+  std::string label;            //!< Catalogue label
+  Parameters *par;              //!< Association parameters
+  Catalogue  *cat;              //!< Catalogue
+} ServerCatalogue;
+
+
+/* Private globals __________________________________________________________ */
+static std::vector<ServerCatalogue> g_cats;
+static int                          g_stream = 0;
+
+
+/* Prototypes _______________________________________________________________ */
+int    split_line(const char *line, std::vector<std::string> &tokens);
+int    load_catalogue(std::vector<std::string> &tokens);
+int    load_config(std::string filename);
+double elapsed_ms(struct timeval *start);
+long   write_query(ServerCatalogue &entry, const char *id,
+                   AssocCatalogue &src, FILE *out);
+long   write_stream(ServerCatalogue &entry, const char *id,
+                    AssocCatalogue &src, FILE *out);
+int    handle_request(const char *line, FILE *out);
+int    serve(FILE *in, FILE *out);
+int    serve_socket(std::string path);
+int    parse_options(int argc, char *argv[], ServerOptions &opt);
+
+
+/*============================================================================*/
+/*                               Configuration                                */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Split line into blank separated tokens
+ *
+ * @param[in] line Line.
+ * @param[out] tokens Tokens.
+ *
+ * Single or double quotes group characters (including blanks) into one
+ * token; the quotes are removed. Returns the number of tokens.
+ ******************************************************************************/
+int split_line(const char *line, std::vector<std::string> &tokens) {
+
+    // Initialise tokens
+    tokens.clear();
+
+    // Loop over line
+    const char *ptr = line;
+    while (*ptr != '\0') {
+
+      // Skip blanks
+      while (*ptr == ' ' || *ptr == '\t' || *ptr == '\n' || *ptr == '\r')
+        ptr++;
+      if (*ptr == '\0')
+        break;
+
+      // Collect token
+      std::string token;
+      char        quote = 0;
+      while (*ptr != '\0') {
+        if (quote != 0) {
+          if (*ptr == quote)
+            quote = 0;
+          else
+            token += *ptr;
+        }
+        else if (*ptr == '\'' || *ptr == '"')
+          quote = *ptr;
+        else if (*ptr == ' ' || *ptr == '\t' || *ptr == '\n' || *ptr == '\r')
+          break;
+        else
+          token += *ptr;
+        ptr++;
+      }
+      tokens.push_back(token);
+
+    } // endwhile: looped over line
+
+    // Return number of tokens
+    return (int)tokens.size();
+
+}
+
+
+/**************************************************************************//**
+ * @brief Load resident counterpart catalogue
+ *
+ * @param[in] tokens Configuration line tokens (label and KEY=VALUE pairs).
+ ******************************************************************************/
+int load_catalogue(std::vector<std::string> &tokens) {
+
+    // Declare local variables
+    AssocOptions    opt;
+    ServerCatalogue entry;
+    Status          status = STATUS_OK;
+
+    // Set default options
+    AssocInitOptions(&opt);
+    opt.srcPrefix = "SRC";
+    opt.cptPrefix = tokens[0];
+
+    // Parse KEY=VALUE pairs
+    for (int i = 1; i < (int)tokens.size(); ++i) {
+      std::string::size_type pos = tokens[i].find("=");
+      if (pos == std::string::npos) {
+        fprintf(stderr, "Invalid option '%s' for catalogue '%s'.\n",
+                tokens[i].c_str(), tokens[0].c_str());
+        return 1;
+      }
+      std::string key   = tokens[i].substr(0, pos);
+      std::string value = tokens[i].substr(pos+1);
+      if      (key == "cptCatName")   opt.cptCatName  = value;
+      else if (key == "cptDensFile")  opt.cptDensFile = value;
+      else if (key == "cptCatPrefix") opt.cptPrefix   = value;
+      else if (key == "srcPosError")  opt.srcPosError = atof(value.c_str());
+      else if (key == "cptPosError")  opt.cptPosError = atof(value.c_str());
+      else if (key == "probMethod")   opt.probMethod  = value;
+      else if (key == "probPrior")    opt.probPrior   = value;
+      else if (key == "probThres")    opt.probThres   = atof(value.c_str());
+      else if (key == "maxNumCpt")    opt.maxNumCpt   = atol(value.c_str());
+      else if (key == "fom")          opt.fom         = value;
+      else if (key == "chatter")      opt.chatter     = atoi(value.c_str());
+      else if (key.find("outCatQty") == 0) opt.outCatQty.push_back(value);
+      else if (key.find("select")    == 0) opt.select.push_back(value);
+      else {
+        fprintf(stderr, "Unknown parameter '%s' for catalogue '%s'.\n",
+                key.c_str(), tokens[0].c_str());
+        return 1;
+      }
+    }
+    if (opt.cptCatName.length() < 1) {
+      fprintf(stderr, "No cptCatName for catalogue '%s'.\n", tokens[0].c_str());
+      return 1;
+    }
+
+    // Set parameters and load catalogue
+    entry.label = tokens[0];
+    entry.par   = new Parameters;
+    entry.cat   = new Catalogue;
+    status      = entry.par->set(opt, status);
+    status      = entry.cat->load(entry.par, status);
+    if (status != STATUS_OK) {
+      fprintf(stderr, "Unable to load catalogue '%s' (status=%d).\n",
+              opt.cptCatName.c_str(), status);
+      delete entry.cat;
+      delete entry.par;
+      return 1;
+    }
+
+    // Add catalogue
+    g_cats.push_back(entry);
+
+    // Return
+    return 0;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Load configuration file
+ *
+ * @param[in] filename Configuration file name.
+ ******************************************************************************/
+int load_config(std::string filename) {
+
+    // Declare local variables
+    char                     line[SERVER_LINE_LEN];
+    std::vector<std::string> tokens;
+    int                      rc = 0;
+
+    // Open configuration file
+    FILE *fptr = fopen(filename.c_str(), "r");
+    if (fptr == NULL) {
+      fprintf(stderr, "Unable to open configuration file '%s'.\n",
+              filename.c_str());
+      return 1;
+    }
+
+    // Load all catalogues
+    while (fgets(line, SERVER_LINE_LEN, fptr) != NULL) {
+      if (split_line(line, tokens) < 1 || tokens[0][0] == '#')
+        continue;
+      rc = load_catalogue(tokens);
+      if (rc != 0)
+        break;
+      fprintf(stderr, "Loaded catalogue '%s'.\n", tokens[0].c_str());
+    }
+
+    // Close configuration file
+    fclose(fptr);
+
+    // Signal if no catalogue was loaded
+    if (rc == 0 && g_cats.size() < 1) {
+      fprintf(stderr, "No catalogue defined in '%s'.\n", filename.c_str());
+      rc = 1;
+    }
+
+    // Return
+    return rc;
+
+}
+
+
+/*============================================================================*/
+/*                                  Requests                                  */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Return elapsed time in milliseconds
+ *
+ * @param[in] start Start time.
+ ******************************************************************************/
+double elapsed_ms(struct timeval *start) {
+
+    // Get current time
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    // Return elapsed time
+    return (now.tv_sec  - start->tv_sec)  * 1000.0 +
+           (now.tv_usec - start->tv_usec) / 1000.0;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Associate source and write reply
+ *
+ * @param[in] entry Catalogue.
+ * @param[in] id Request identifier.
+ * @param[in] src Source.
+ * @param[in] out Reply stream.
+ *
+ * Returns the number of reply lines.
+ ******************************************************************************/
+long write_query(ServerCatalogue &entry, const char *id, AssocCatalogue &src,
+                 FILE *out) {
+
+    // Declare local variables
+    AssocResult res;
+    long        numReply = 0;
+
+    // Associate source
+    Status status = entry.cat->query(entry.par, src, res, STATUS_OK);
+    if (status != STATUS_OK) {
+      fprintf(out, "%s ERROR association with '%s' failed (status=%d)\n",
+              id, entry.label.c_str(), status);
+      return 0;
+    }
+
+    // Write candidates
+    for (long i = 0; i < res.numAssoc; ++i) {
+      fprintf(out, "%s %s %ld %ld %.6g %.6g %.6g %s\n", id,
+              entry.label.c_str(), i+1, res.cpt[i]+1, res.prob[i],
+              res.prob_post_single[i], res.angsep[i],
+              entry.cat->object_name(res.cpt[i]));
+      numReply++;
+    }
+
+    // Return number of reply lines
+    return numReply;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Add source to association stream and write reply
+ *
+ * @param[in] entry Catalogue.
+ * @param[in] id Request identifier.
+ * @param[in] src Source.
+ * @param[in] out Reply stream.
+ *
+ * Returns the number of reply lines.
+ ******************************************************************************/
+long write_stream(ServerCatalogue &entry, const char *id, AssocCatalogue &src,
+                  FILE *out) {
+
+    // Declare local variables
+    AssocResult       prov;
+    AssocResult       res;
+    std::vector<int>  update;
+    std::vector<long> rank;
+    long              numReply = 0;
+
+    // Add source to stream
+    Status status = entry.cat->stream(entry.par, src, prov, update, res,
+                                      STATUS_OK);
+    if (status != STATUS_OK) {
+      fprintf(out, "%s ERROR association with '%s' failed (status=%d)\n",
+              id, entry.label.c_str(), status);
+      return 0;
+    }
+
+    // Rank provisional candidates by decreasing PROB_POST_SINGLE
+    for (long i = 0; i < prov.numAssoc; ++i) {
+      long j = (long)rank.size();
+      rank.push_back(i);
+      for ( ; j > 0 && prov.prob_post_single[rank[j-1]] <
+                       prov.prob_post_single[i]; --j)
+        rank[j] = rank[j-1];
+      rank[j] = i;
+    }
+
+    // Write provisional candidates
+    for (long r = 0; r < (long)rank.size(); ++r) {
+      long i = rank[r];
+      fprintf(out, "%s PROV %s %ld %ld %.6g %.6g %s\n", id,
+              entry.label.c_str(), r+1, prov.cpt[i]+1,
+              prov.prob_post_single[i], prov.angsep[i],
+              entry.cat->object_name(prov.cpt[i]));
+      numReply++;
+    }
+
+    // Write updated sources
+    for (int j = 0; j < (int)update.size(); ++j) {
+
+      // Count counterparts of source
+      const char *name = entry.cat->source_name(update[j]);
+      long        num  = 0;
+      for (long i = 0; i < res.numAssoc; ++i) {
+        if (res.src[i] == update[j])
+          num++;
+      }
+
+      // Write counterparts
+      fprintf(out, "%s UPDATE %s %ld\n", name, entry.label.c_str(), num);
+      numReply++;
+      for (long i = 0, r = 0; i < res.numAssoc; ++i) {
+        if (res.src[i] != update[j])
+          continue;
+        fprintf(out, "%s %s %ld %ld %.6g %.6g %.6g %s\n", name,
+                entry.label.c_str(), ++r, res.cpt[i]+1, res.prob[i],
+                res.prob_post_single[i], res.angsep[i],
+                entry.cat->object_name(res.cpt[i]));
+        numReply++;
+      }
+
+    } // endfor: looped over updated sources
+
+    // Return number of reply lines
+    return numReply;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Handle one request line
+ *
+ * @param[in] line Request line.
+ * @param[in] out Reply stream.
+ *
+ * Returns 1 if the server should stop, 0 otherwise.
+ ******************************************************************************/
+int handle_request(const char *line, FILE *out) {
+
+    // Declare local variables
+    std::vector<std::string> tokens;
+    struct timeval           start;
+
+    // Start timer
+    gettimeofday(&start, NULL);
+
+    // Split request and handle commands
+    int num = split_line(line, tokens);
+    if (num < 1 || tokens[0][0] == '#')
+      return 0;
+    if (tokens[0] == "quit")
+      return 1;
+    if (tokens[0] == "ping") {
+      fprintf(out, "pong\n");
+      fflush(out);
+      return 0;
+    }
+
+    // Extract optional catalogue label
+    std::string label;
+    if (tokens[num-1][0] == '@') {
+      label = tokens[num-1].substr(1);
+      num--;
+    }
+
+    // Check request
+    if (num != 4 && num != 6) {
+      fprintf(out, "%s ERROR expect ID RA DEC ERR_MAJ [ERR_MIN ERR_ANG]"
+              " [@LABEL]\n", tokens[0].c_str());
+      fflush(out);
+      return 0;
+    }
+
+    // Set source
+    double ra      = atof(tokens[1].c_str());
+    double dec     = atof(tokens[2].c_str());
+    double err_maj = atof(tokens[3].c_str());
+    double err_min = (num == 6) ? atof(tokens[4].c_str()) : err_maj;
+    double err_ang = (num == 6) ? atof(tokens[5].c_str()) : 0.0;
+    const char    *name = tokens[0].c_str();
+    AssocCatalogue src;
+    AssocInitCatalogue(&src);
+    src.numObjects = 1;
+    src.ra         = &ra;
+    src.dec        = &dec;
+    src.err_maj    = &err_maj;
+    src.err_min    = &err_min;
+    src.err_ang    = &err_ang;
+    src.names      = &name;
+
+    // Loop over catalogues
+    long numReply = 0;
+    int  found    = 0;
+    for (int k = 0; k < (int)g_cats.size(); ++k) {
+
+      // Skip catalogue if not requested
+      if (label.length() > 0 && g_cats[k].label != label)
+        continue;
+      found = 1;
+
+      // Associate source
+      if (g_stream)
+        numReply += write_stream(g_cats[k], tokens[0].c_str(), src, out);
+      else
+        numReply += write_query(g_cats[k], tokens[0].c_str(), src, out);
+
+    } // endfor: looped over catalogues
+
+    // Write end of reply
+    if (!found)
+      fprintf(out, "%s ERROR unknown catalogue '%s'\n", tokens[0].c_str(),
+              label.c_str());
+    fprintf(out, "%s END %ld %.3f\n", tokens[0].c_str(), numReply,
+            elapsed_ms(&start));
+    fflush(out);
+
+    // Return
+    return 0;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Serve requests from stream
+ *
+ * @param[in] in Request stream.
+ * @param[in] out Reply stream.
+ *
+ * Returns 1 if a "quit" command was received, 0 at end of stream.
+ ******************************************************************************/
+int serve(FILE *in, FILE *out) {
+
+    // Declare local variables
+    char line[SERVER_LINE_LEN];
+
+    // Handle requests
+    while (fgets(line, SERVER_LINE_LEN, in) != NULL) {
+      if (handle_request(line, out))
+        return 1;
+    }
+
+    // Return
+    return 0;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Serve requests on local UNIX socket
+ *
+ * @param[in] path Socket path.
+ *
+ * Connections are handled one after the other.
+ ******************************************************************************/
+int serve_socket(std::string path) {
+
+    // Declare local variables
+    struct sockaddr_un addr;
+
+    // Create socket
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) {
+      perror("socket");
+      return 1;
+    }
+
+    // Bind socket to path
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.length() >= sizeof(addr.sun_path)) {
+      fprintf(stderr, "Socket path '%s' is too long.\n", path.c_str());
+      close(sock);
+      return 1;
+    }
+    strcpy(addr.sun_path, path.c_str());
+    unlink(path.c_str());
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(sock, 8) < 0) {
+      perror("bind");
+      close(sock);
+      return 1;
+    }
+    fprintf(stderr, "Listening on '%s'.\n", path.c_str());
+
+    // Accept connections
+    int stop = 0;
+    while (!stop) {
+      int conn = accept(sock, NULL, NULL);
+      if (conn < 0)
+        continue;
+      FILE *in  = fdopen(conn, "r");
+      FILE *out = fdopen(dup(conn), "w");
+      if (in != NULL && out != NULL)
+        stop = serve(in, out);
+      if (in  != NULL) fclose(in);
+      if (out != NULL) fclose(out);
+    }
+
+    // Close socket
+    close(sock);
+    unlink(path.c_str());
+
+    // Return
+    return 0;
+
+}
+
+
+/*============================================================================*/
+/*                                Main program                                */
+/*============================================================================*/
+
+/**************************************************************************//**
+ * @brief Parse command line options
+ *
+ * @param[in] argc Number of arguments.
+ * @param[in] argv Arguments.
+ * @param[out] opt Server options.
+ ******************************************************************************/
+int parse_options(int argc, char *argv[], ServerOptions &opt) {
+
+    // Initialise options
+    opt.stream = 0;
+
+    // Parse arguments
+    for (int i = 1; i < argc; ++i) {
+      std::string arg  = argv[i];
+      const char *next = (i+1 < argc) ? argv[i+1] : NULL;
+      if (arg == "-socket" && next != NULL) { opt.socket = next; i++; }
+      else if (arg == "-log" && next != NULL) { opt.log = next; i++; }
+      else if (arg == "-stream") opt.stream = 1;
+      else if (arg[0] != '-' && opt.config.length() < 1)
+        opt.config = arg;
+      else {
+        fprintf(stderr, "Unknown option '%s'.\n", arg.c_str());
+        return 1;
+      }
+    }
+
+    // Check for configuration file
+    if (opt.config.length() < 1)
+      return 1;
+
+    // Return
+    return 0;
+
+}
+
+
+/**************************************************************************//**
+ * @brief Main entry point
+ *
+ * @param[in] argc Number of arguments.
+ * @param[in] argv Arguments.
+ ******************************************************************************/
+int main(int argc, char *argv[]) {
+
+    // Declare local variables
+    ServerOptions opt;
+    int           rc = 0;
+
+    // Single loop for common exit point
+    do {
+
+      // Parse options
+      rc = parse_options(argc, argv, opt);
+      if (rc != 0) {
+        fprintf(stderr, "Usage: %s [-socket PATH] [-log FILE] [-stream]"
+                " CONFIG\n", SERVER_NAME);
+        continue;
+      }
+
+      // Optionally open log file
+      if (opt.log.length() > 0) {
+        if (LogInit(opt.log.c_str(), SERVER_NAME, STATUS_OK) != STATUS_OK) {
+          fprintf(stderr, "Unable to open log file '%s'.\n", opt.log.c_str());
+          rc = 1;
+          continue;
+        }
+      }
+
+      // Set streaming mode
+      g_stream = opt.stream;
+
+      // Load catalogues
+      rc = load_config(opt.config);
+      if (rc != 0)
+        continue;
+
+      // Serve requests
+      if (opt.socket.length() > 0)
+        rc = serve_socket(opt.socket);
+      else
+        serve(stdin, stdout);
+
+    } while (0); // End of main do-loop
+
+    // Release catalogues
+    for (int k = 0; k < (int)g_cats.size(); ++k) {
+      delete g_cats[k].cat;
+      delete g_cats[k].par;
+    }
+
+    // Close log file
+    if (opt.log.length() > 0)
+      LogClose(STATUS_OK);
+
+    // Return
+    return (rc == 0) ? 0 : 1;
+
+}